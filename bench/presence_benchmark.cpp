@@ -0,0 +1,161 @@
+// Compares the two ways a SET_ACTIVITY frame has been built:
+//  - old: a nlohmann::json tree, dump() into a string, copied behind the
+//    IPC header into a fresh buffer
+//  - new: JsonWriter appending straight into a reused frame buffer that
+//    already holds the reserved header
+// Both produce the same document; the benchmark checks that before timing.
+//
+// Build with -DBUILD_BENCHMARKS=ON and run presence_benchmark [ITERATIONS].
+
+#include "json_writer.h"
+
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr size_t FRAME_HEADER_SIZE = 8;
+    constexpr int DEFAULT_ITERATIONS = 200000;
+
+    // A TV episode with assets, a button, and text that needs escaping
+    struct Activity
+    {
+        int type = 3;
+        std::string state = "S02E05 - \"Ozymandias\" \xE2\x80\x94 Part 1";
+        std::string details = "Breaking Bad \\ Season 2";
+        std::string largeImage = "https://plex.example.com:32400/photo/:/transcode?width=512&height=512&url=%2Flibrary%2Fmetadata%2F4242%2Fthumb%2F1700000000";
+        std::string largeText = "Breaking Bad (2008)";
+        std::string smallImage = "plex_logo";
+        std::string smallText = "Plex for Windows \xC2\xB7 1080p \xC2\xB7 12.4 Mbps";
+        int64_t start = 1792340014;
+        int64_t end = 1792343614;
+        std::vector<std::pair<std::string, std::string>> buttons = {{"View on IMDb", "https://www.imdb.com/title/tt2301451/"}};
+    };
+
+    std::vector<char> oldPath(const Activity &activity, int pid, const std::string &nonce)
+    {
+        nlohmann::json assets = {{"large_image", activity.largeImage}, {"large_text", activity.largeText},
+                                 {"small_image", activity.smallImage}, {"small_text", activity.smallText}};
+        nlohmann::json buttons = nlohmann::json::array();
+        for (const auto &[label, url] : activity.buttons)
+        {
+            buttons.push_back({{"label", label}, {"url", url}});
+        }
+        nlohmann::json presence = {
+            {"cmd", "SET_ACTIVITY"},
+            {"args", {{"pid", pid}, {"activity", {{"type", activity.type}, {"name", "Plex"}, {"state", activity.state}, {"details", activity.details}, {"timestamps", {{"start", activity.start}, {"end", activity.end}}}, {"assets", assets}, {"instance", true}, {"buttons", buttons}}}}},
+            {"nonce", nonce}};
+
+        std::string payload = presence.dump();
+        std::vector<char> frame(FRAME_HEADER_SIZE + payload.size());
+        uint32_t header[2] = {1, static_cast<uint32_t>(payload.size())};
+        std::memcpy(frame.data(), header, FRAME_HEADER_SIZE);
+        std::memcpy(frame.data() + FRAME_HEADER_SIZE, payload.data(), payload.size());
+        return frame;
+    }
+
+    // Mirrors Discord::writePresence
+    void newPath(std::string &frame, const Activity &activity, int pid, const std::string &nonce)
+    {
+        frame.assign(FRAME_HEADER_SIZE, '\0');
+        JsonWriter writer(frame);
+        writer.beginObject()
+            .field("cmd", "SET_ACTIVITY")
+            .key("args")
+            .beginObject()
+            .field("pid", pid)
+            .key("activity")
+            .beginObject()
+            .field("type", activity.type)
+            .field("name", "Plex")
+            .field("state", activity.state)
+            .field("details", activity.details)
+            .key("timestamps")
+            .beginObject()
+            .field("start", activity.start)
+            .field("end", activity.end)
+            .endObject()
+            .key("assets")
+            .beginObject()
+            .field("large_image", activity.largeImage)
+            .field("large_text", activity.largeText)
+            .field("small_image", activity.smallImage)
+            .field("small_text", activity.smallText)
+            .endObject()
+            .field("instance", true)
+            .key("buttons")
+            .beginArray();
+        for (const auto &[label, url] : activity.buttons)
+        {
+            writer.beginObject().field("label", label).field("url", url).endObject();
+        }
+        writer.endArray().endObject().endObject().field("nonce", nonce).endObject();
+
+        uint32_t header[2] = {1, static_cast<uint32_t>(frame.size() - FRAME_HEADER_SIZE)};
+        std::memcpy(&frame[0], header, FRAME_HEADER_SIZE);
+    }
+
+    template <typename Func>
+    double microsecondsPerCall(int iterations, Func func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            func();
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / iterations;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0)
+    {
+        std::cerr << "Usage: presence_benchmark [ITERATIONS]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Activity activity;
+    const int pid = 4242;
+    const std::string nonce = "1792340014-123456";
+
+    // Both paths must describe the same document
+    std::string frame;
+    newPath(frame, activity, pid, nonce);
+    auto reference = oldPath(activity, pid, nonce);
+    auto oldDocument = nlohmann::json::parse(reference.begin() + FRAME_HEADER_SIZE, reference.end());
+    auto newDocument = nlohmann::json::parse(frame.begin() + FRAME_HEADER_SIZE, frame.end());
+    if (oldDocument != newDocument)
+    {
+        std::cerr << "Outputs differ:\n"
+                  << oldDocument.dump() << "\n"
+                  << newDocument.dump() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    size_t sink = 0;
+    double oldTime = microsecondsPerCall(iterations, [&]()
+                                         { sink += oldPath(activity, pid, nonce).size(); });
+    double newTime = microsecondsPerCall(iterations, [&]()
+                                         {
+        newPath(frame, activity, pid, nonce);
+        sink += frame.size(); });
+
+    std::cout << "Frame of " << frame.size() << " bytes, " << iterations << " iterations\n"
+              << "old path (tree + dump + frame copy): " << oldTime << " us\n"
+              << "new path (JsonWriter into reused buffer): " << newTime << " us\n"
+              << "speedup: " << oldTime / newTime << "x" << std::endl;
+
+    // Keeps the compiler from dropping the work being timed
+    return sink > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
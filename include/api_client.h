@@ -0,0 +1,130 @@
+#pragma once
+
+// Standard library headers
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Project headers
+#include "cancellation_token.h"
+#include "wake_signal.h"
+
+/**
+ * @brief Token bucket describing one published request quota
+ */
+struct RateLimit
+{
+    double capacity;        // Burst size in requests
+    double refillPerSecond; // Tokens added back per second
+};
+
+/**
+ * @brief Order in which queued requests are sent
+ */
+enum class ApiPriority
+{
+    High, // Needed for the presence currently being shown
+    Normal,
+    Low // Speculative lookups that can wait
+};
+
+/**
+ * @brief Result of an ApiClient request
+ */
+struct ApiResponse
+{
+    long statusCode = 0; // 0 if no response was received (timeout, DNS, shutdown)
+    std::string body;
+
+    bool success() const { return statusCode >= 200 && statusCode < 300; }
+
+    // Worth retrying later, as opposed to a definitive answer from the API
+    bool transient() const { return statusCode == 0 || statusCode == 408 || statusCode == 429 || statusCode >= 500; }
+};
+
+/**
+ * @class ApiClient
+ * @brief Rate-limited client for one third-party API
+ *
+ * Every request goes through a single dispatcher thread that only sends it
+ * once all of the provider's token buckets have a token, so the quota is
+ * shared by every caller no matter which Plex server triggered the lookup.
+ * Queued requests are sent by priority, then in arrival order. A 429 or 503
+ * answer pauses the whole client for the Retry-After period before the
+ * request is retried.
+ */
+class ApiClient
+{
+public:
+    ApiClient(std::string name, std::vector<RateLimit> limits);
+    ~ApiClient();
+
+    ApiClient(const ApiClient &) = delete;
+    ApiClient &operator=(const ApiClient &) = delete;
+
+    /**
+     * @brief Queue a GET request and wait for its result
+     * @param cancel Optional token; cancelling it fails the request at once
+     *               whether it is still queued or already in flight
+     */
+    ApiResponse get(const std::string &url,
+                    const std::map<std::string, std::string> &headers = {},
+                    ApiPriority priority = ApiPriority::Normal,
+                    const CancellationToken *cancel = nullptr);
+
+    /**
+     * @brief Fail every queued request and abort the one in flight
+     *
+     * The client stays usable; later requests are sent as usual.
+     */
+    void cancelPending();
+
+    /**
+     * @brief Stop the dispatcher; queued and later requests fail immediately
+     */
+    void stop();
+
+private:
+    struct Bucket
+    {
+        RateLimit limit;
+        double tokens;
+    };
+
+    struct Request
+    {
+        std::string url;
+        std::map<std::string, std::string> headers;
+        int attempts = 0;
+        const CancellationToken *cancel = nullptr; // Owned by the caller, who waits for the result
+        std::promise<ApiResponse> result;
+    };
+
+    // Queue order: priority first, then sequence number (FIFO)
+    using QueueKey = std::pair<int, uint64_t>;
+
+    void dispatchLoop();
+    void refillLocked(std::chrono::steady_clock::time_point now);
+    std::chrono::steady_clock::duration waitTimeLocked(std::chrono::steady_clock::time_point now) const;
+    static std::chrono::seconds parseRetryAfter(const std::map<std::string, std::string> &headers);
+
+    const std::string m_name;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<Bucket> m_buckets;
+    std::chrono::steady_clock::time_point m_lastRefill;
+    std::chrono::steady_clock::time_point m_blockedUntil;
+    std::map<QueueKey, std::unique_ptr<Request>> m_queue;
+    uint64_t m_nextSequence = 0;
+    bool m_stopping = false;
+    WakeSignal m_cancelSignal; // Aborts the request in flight
+    std::thread m_dispatcher;
+};
@@ -2,6 +2,7 @@
 
 // Standard library headers
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <future>
 #include <memory>
@@ -13,9 +14,13 @@ using json = nlohmann::json;
 
 // Project headers
 #include "config.h"
+#include "control_server.h"
 #include "discord.h"
+#include "latency_tracker.h"
 #include "plex.h"
+#include "timer_service.h"
 #include "trayicon.h"
+#include "worker_pool.h"
 
 class Application
 {
@@ -38,11 +43,18 @@ private:
     std::condition_variable m_discordConnectCv;
     std::mutex m_discordConnectMutex;
     time_t m_lastStartTime = 0;
+    bool m_playbackChanged = false; // Guarded by m_discordConnectMutex
     std::future<void> m_updateCheckFuture;
+    std::chrono::steady_clock::time_point m_startTime = std::chrono::steady_clock::now();
+
+    // Declared after m_plex and m_discord so it is destroyed first: its
+    // commands use both
+    ControlServer m_controlServer;
 
     // Helper methods for improved readability
     void setupLogging();
     void setupDiscordCallbacks();
+    void setupControlCommands();
     void updateTrayStatus(const MediaInfo &info);
     void processPlaybackInfo(const MediaInfo &info);
     void performCleanup();
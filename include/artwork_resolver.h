@@ -0,0 +1,104 @@
+#pragma once
+
+// Standard library headers
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Project headers
+#include "cache.h"
+#include "wake_signal.h"
+
+/**
+ * @class ArtworkResolver
+ * @brief Turns Plex thumbnail paths into stable, Discord-friendly artwork URLs
+ *
+ * URLs are derived only from the server, the thumb path and the item's
+ * updatedAt stamp, so Discord's media proxy sees the same URL on every
+ * presence refresh and fetches each image once. Server reachability is
+ * checked with HEAD probes whose results are cached, and the resolved URL
+ * is memoized per thumb without the access token, which is appended on
+ * every call so a rotated token takes effect at once.
+ *
+ * Resolved URLs can be pre-warmed: a background worker requests them once so
+ * the server's transcode cache is hot by the time Discord's proxy asks.
+ */
+class ArtworkResolver
+{
+public:
+    /**
+     * @param byteBudget Memory budget shared by the resolver's caches
+     * @param abortSignal Optional signal that aborts in-flight probes and fetches
+     */
+    explicit ArtworkResolver(size_t byteBudget, WakeSignal *abortSignal = nullptr);
+    ~ArtworkResolver();
+
+    /**
+     * @brief Resolve the transcoded artwork URL for a thumbnail
+     * @param thumbPath Thumbnail path on the server (e.g. /library/metadata/1/thumb/123)
+     * @param updatedAt The item's updatedAt stamp, 0 if unknown
+     * @param serverUri URI of the server hosting the item
+     * @param accessToken Access token for the server
+     * @return Artwork URL, or an empty string if any input is missing
+     */
+    std::string resolve(const std::string &thumbPath, int64_t updatedAt,
+                        const std::string &serverUri, const std::string &accessToken);
+
+    /**
+     * @brief Queue a resolved URL to be fetched once in the background
+     *
+     * Does nothing for URLs that are already queued, being fetched or were
+     * warmed recently, and for URLs this resolver did not build.
+     * @param url Artwork URL returned by resolve()
+     */
+    void prewarm(const std::string &url);
+
+    /**
+     * @brief Stop the pre-warm worker and drop queued requests
+     */
+    void stop();
+
+    /**
+     * @brief Forget memoized URLs and probe results
+     */
+    void clear();
+
+    /**
+     * @brief Forget memoized URLs and probe results for one server URI
+     */
+    void forgetServer(const std::string &serverUri);
+
+    /**
+     * @brief Get statistics for the resolver's caches
+     */
+    std::vector<CacheStats> stats() const;
+
+    /**
+     * @brief List up to limit live keys of the named cache
+     * @return false if no cache of the resolver has this name
+     */
+    bool keys(const std::string &cacheName, size_t limit, std::vector<std::string> &keys) const;
+
+private:
+    bool isReachable(const std::string &baseUri);
+    std::string chooseBaseUri(const std::string &serverUri);
+    void prewarmLoop();
+
+    BoundedCache<std::string> m_resolvedUrls;
+    BoundedCache<bool> m_reachability;
+    BoundedCache<bool> m_warmedUrls;
+
+    // Pre-warm worker, started on the first prewarm() call
+    std::thread m_prewarmThread;
+    std::mutex m_prewarmMutex;
+    std::condition_variable m_prewarmCv;
+    std::deque<std::string> m_prewarmQueue;
+    std::set<std::string> m_prewarmPending; // Queued or in flight
+    bool m_stopping = false;
+    WakeSignal *m_abortSignal; // Aborts probes and pre-warm fetches, may be null
+};
@@ -0,0 +1,364 @@
+#pragma once
+
+// Standard library headers
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Point-in-time statistics for a BoundedCache
+ */
+struct CacheStats
+{
+    std::string name;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;   // Entries dropped to stay within the byte budget
+    uint64_t expirations = 0; // Entries dropped because their TTL ran out
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t byteBudget = 0;
+
+    double hitRatio() const
+    {
+        uint64_t lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+    }
+};
+
+/**
+ * @class BoundedCache
+ * @brief Thread-safe string-keyed cache with per-entry TTL, LRU eviction and a byte budget
+ *
+ * Keys are spread over independently locked shards so concurrent lookups for
+ * different keys rarely contend. Lookups accept std::string_view without
+ * allocating. Each shard owns an equal slice of the byte budget and evicts its
+ * least recently used entries once the slice is exceeded, so memory stays flat
+ * no matter how many distinct keys pass through.
+ *
+ * @tparam Value Cached value type; must be copyable
+ */
+template <typename Value>
+class BoundedCache
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using SizeFunction = std::function<size_t(const Value &)>;
+
+    /**
+     * @brief Create a cache
+     * @param name Name used when reporting statistics
+     * @param byteBudget Approximate upper bound on memory used by entries
+     * @param sizeOf Estimates the heap footprint of a value in bytes
+     * @param shardCount Number of independently locked shards
+     */
+    BoundedCache(std::string name, size_t byteBudget, SizeFunction sizeOf, size_t shardCount = 8)
+        : m_name(std::move(name)),
+          m_sizeOf(std::move(sizeOf)),
+          m_shards(shardCount == 0 ? 1 : shardCount)
+    {
+        setByteBudget(byteBudget);
+    }
+
+    BoundedCache(const BoundedCache &) = delete;
+    BoundedCache &operator=(const BoundedCache &) = delete;
+
+    /**
+     * @brief Look up a live entry and mark it as recently used
+     * @return A copy of the value, or std::nullopt if absent or expired
+     */
+    std::optional<Value> get(std::string_view key)
+    {
+        Shard &shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.index.find(key);
+        if (it == shard.index.end())
+        {
+            ++shard.misses;
+            return std::nullopt;
+        }
+
+        auto node = it->second;
+        if (node->expires <= Clock::now())
+        {
+            removeLocked(shard, it);
+            ++shard.expirations;
+            ++shard.misses;
+            return std::nullopt;
+        }
+
+        shard.lru.splice(shard.lru.begin(), shard.lru, node);
+        ++shard.hits;
+        return node->value;
+    }
+
+    /**
+     * @brief Insert or replace an entry
+     * @param key Entry key
+     * @param value Value to store
+     * @param ttl How long the entry stays valid
+     */
+    void put(std::string_view key, Value value, std::chrono::seconds ttl)
+    {
+        Shard &shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.index.find(key);
+        if (it != shard.index.end())
+        {
+            removeLocked(shard, it);
+        }
+
+        size_t bytes = ENTRY_OVERHEAD + key.size() + m_sizeOf(value);
+        size_t budget = m_shardBudget.load();
+        if (bytes > budget)
+        {
+            // Would evict everything else and still not fit
+            ++shard.evictions;
+            return;
+        }
+
+        shard.lru.push_front(Node{nullptr, std::move(value), Clock::now() + ttl, bytes});
+        auto inserted = shard.index.emplace(std::string(key), shard.lru.begin()).first;
+        shard.lru.front().key = &inserted->first;
+        shard.bytes += bytes;
+
+        // Expired entries that are never looked up again would otherwise
+        // linger until the budget forces them out, so sweep now and then
+        if (++shard.putsSinceSweep >= SWEEP_INTERVAL)
+        {
+            shard.putsSinceSweep = 0;
+            purgeExpiredLocked(shard, Clock::now());
+        }
+
+        enforceBudgetLocked(shard, budget);
+    }
+
+    /**
+     * @brief Remove an entry if present
+     */
+    void erase(std::string_view key)
+    {
+        Shard &shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.index.find(key);
+        if (it != shard.index.end())
+        {
+            removeLocked(shard, it);
+        }
+    }
+
+    /**
+     * @brief Remove every entry whose key starts with prefix
+     * @return Number of entries removed
+     */
+    size_t erasePrefix(std::string_view prefix)
+    {
+        size_t removed = 0;
+        for (auto &shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.index.lower_bound(prefix);
+            while (it != shard.index.end() && std::string_view(it->first).substr(0, prefix.size()) == prefix)
+            {
+                removeLocked(shard, it++);
+                ++removed;
+            }
+        }
+        return removed;
+    }
+
+    /**
+     * @brief Remove all entries (statistics are kept)
+     */
+    void clear()
+    {
+        for (auto &shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.index.clear();
+            shard.lru.clear();
+            shard.bytes = 0;
+        }
+    }
+
+    /**
+     * @brief Drop every expired entry
+     * @return Number of entries removed
+     */
+    size_t purgeExpired()
+    {
+        size_t removed = 0;
+        auto now = Clock::now();
+        for (auto &shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            removed += purgeExpiredLocked(shard, now);
+        }
+        return removed;
+    }
+
+    /**
+     * @brief Change the byte budget, evicting immediately if it shrank
+     */
+    void setByteBudget(size_t byteBudget)
+    {
+        m_byteBudget = byteBudget;
+        size_t shardBudget = byteBudget / m_shards.size();
+        m_shardBudget = shardBudget;
+
+        for (auto &shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            enforceBudgetLocked(shard, shardBudget);
+        }
+    }
+
+    /**
+     * @brief Collect hit ratio, entry count and memory use across all shards
+     */
+    CacheStats stats() const
+    {
+        CacheStats result;
+        result.name = m_name;
+        result.byteBudget = m_byteBudget.load();
+        for (const auto &shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            result.hits += shard.hits;
+            result.misses += shard.misses;
+            result.evictions += shard.evictions;
+            result.expirations += shard.expirations;
+            result.entries += shard.index.size();
+            result.bytes += shard.bytes;
+        }
+        return result;
+    }
+
+    /**
+     * @brief List the keys of live entries, most recently used first within each shard
+     * @param limit Maximum number of keys to return
+     */
+    std::vector<std::string> keys(size_t limit) const
+    {
+        std::vector<std::string> result;
+        auto now = Clock::now();
+        for (const auto &shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (const auto &node : shard.lru)
+            {
+                if (result.size() >= limit)
+                {
+                    return result;
+                }
+                if (node.expires > now)
+                {
+                    result.push_back(*node.key);
+                }
+            }
+        }
+        return result;
+    }
+
+    const std::string &name() const { return m_name; }
+
+private:
+    // Rough per-entry bookkeeping cost: map node, list node and the key string header
+    static constexpr size_t ENTRY_OVERHEAD = 128;
+
+    // Number of insertions into a shard between expired-entry sweeps
+    static constexpr uint32_t SWEEP_INTERVAL = 64;
+
+    struct Node
+    {
+        const std::string *key; // Points at the key owned by the shard index
+        Value value;
+        Clock::time_point expires;
+        size_t bytes;
+    };
+
+    using NodeList = std::list<Node>;
+    using Index = std::map<std::string, typename NodeList::iterator, std::less<>>;
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        NodeList lru; // Most recently used first
+        Index index;
+        size_t bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t expirations = 0;
+        uint32_t putsSinceSweep = 0;
+    };
+
+    Shard &shardFor(std::string_view key)
+    {
+        return m_shards[std::hash<std::string_view>{}(key) % m_shards.size()];
+    }
+
+    void removeLocked(Shard &shard, typename Index::iterator it)
+    {
+        shard.bytes -= it->second->bytes;
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+
+    size_t purgeExpiredLocked(Shard &shard, Clock::time_point now)
+    {
+        size_t removed = 0;
+        for (auto it = shard.index.begin(); it != shard.index.end();)
+        {
+            if (it->second->expires <= now)
+            {
+                shard.bytes -= it->second->bytes;
+                shard.lru.erase(it->second);
+                it = shard.index.erase(it);
+                ++shard.expirations;
+                ++removed;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return removed;
+    }
+
+    void enforceBudgetLocked(Shard &shard, size_t budget)
+    {
+        auto now = Clock::now();
+        while (shard.bytes > budget && !shard.lru.empty())
+        {
+            const Node &victim = shard.lru.back();
+            if (victim.expires <= now)
+            {
+                ++shard.expirations;
+            }
+            else
+            {
+                ++shard.evictions;
+            }
+            removeLocked(shard, shard.index.find(*victim.key));
+        }
+    }
+
+    const std::string m_name;
+    const SizeFunction m_sizeOf;
+    std::vector<Shard> m_shards;
+    std::atomic<size_t> m_byteBudget{0};
+    std::atomic<size_t> m_shardBudget{0};
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+// Standard library headers
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// Project headers
+#include "wake_signal.h"
+
+/**
+ * @class CancellationToken
+ * @brief Shared flag a caller sets to ask running work to give up
+ *
+ * Copies share the same state, so the caller keeps one copy and hands the
+ * other to the work. Cancellation is cooperative: the work checks
+ * isCancelled() at convenient points, or registers a listener that
+ * interrupts whatever it is blocked on (an HttpClient wakes its transfer).
+ *
+ * A token is only a flag and a listener list, so creating one costs no
+ * system resources; the pipe-backed WakeSignal is built on the first call
+ * to signal().
+ */
+class CancellationToken
+{
+public:
+    using Listener = std::function<void()>;
+
+    CancellationToken() : m_state(std::make_shared<State>()) {}
+
+    void cancel() const;
+    bool isCancelled() const { return m_state->cancelled.load(); }
+
+    /**
+     * @brief Register a callback run once on cancel()
+     *
+     * Runs immediately if the token is already cancelled.
+     * @return Id to pass to removeListener()
+     */
+    size_t addListener(Listener listener) const;
+    void removeListener(size_t id) const;
+
+    /**
+     * @brief Signal notified on cancel(), valid while any copy of the token lives
+     *
+     * For waits that need a WakeSignal, such as poll() on its descriptor.
+     */
+    WakeSignal *signal() const;
+
+    /**
+     * @brief Keeps a listener registered for the lifetime of a scope
+     */
+    class ListenerGuard
+    {
+    public:
+        // token may be null, in which case nothing is registered
+        ListenerGuard(const CancellationToken *token, Listener listener)
+            : m_token(token), m_id(token ? token->addListener(std::move(listener)) : 0)
+        {
+        }
+
+        ~ListenerGuard()
+        {
+            if (m_token)
+            {
+                m_token->removeListener(m_id);
+            }
+        }
+
+        ListenerGuard(const ListenerGuard &) = delete;
+        ListenerGuard &operator=(const ListenerGuard &) = delete;
+
+    private:
+        const CancellationToken *m_token;
+        size_t m_id;
+    };
+
+private:
+    struct State
+    {
+        std::atomic<bool> cancelled{false};
+        std::mutex mutex;
+        std::map<size_t, Listener> listeners;
+        size_t nextListenerId = 0;
+        std::unique_ptr<WakeSignal> signal;
+    };
+
+    std::shared_ptr<State> m_state;
+};
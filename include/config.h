@@ -2,9 +2,11 @@
 
 // Standard library headers
 #include <atomic>
+#include <condition_variable>
 #include <filesystem>
 #include <fstream>
 #include <map>
+#include <mutex>
 #include <shared_mutex>
 #include <string>
 #include <vector>
@@ -15,6 +17,7 @@
 // Project headers
 #include "logger.h"
 #include "models.h"
+#include "timer_service.h"
 #include "version.h"
 
 /**
@@ -47,11 +50,21 @@ public:
     bool loadConfig();
 
     /**
-     * @brief Save configuration to file
-     * @return True if successful, false otherwise
+     * @brief Schedule the configuration to be saved
+     *
+     * Calls within SAVE_DELAY of each other are coalesced into one write,
+     * which happens on the worker pool. The file is replaced atomically, so
+     * a crash mid-write leaves the previous version intact.
+     * @return True; write errors are logged
      */
     bool saveConfig();
 
+    /**
+     * @brief Write pending changes now, on the calling thread
+     * @return True if nothing was pending or the write succeeded
+     */
+    bool flush();
+
     //
     // General settings
     //
@@ -120,15 +133,35 @@ public:
      */
     void setTMDBAccessToken(const std::string &token);
 
+    /**
+     * @brief Get the memory budget shared by all in-memory caches
+     * @return Budget in bytes
+     */
+    size_t getCacheMemoryBudget() const;
+
+    /**
+     * @brief Set the memory budget shared by all in-memory caches
+     * @param bytes New budget in bytes
+     */
+    void setCacheMemoryBudget(size_t bytes);
+
     //
     // Plex server management
     //
 
     /**
      * @brief Get all configured Plex servers
-     * @return Map of server client ID to server object
+     * @return Snapshot of the map of server client ID to server object; safe to
+     *         iterate while the registry is being refreshed
      */
-    const std::map<std::string, std::shared_ptr<PlexServer>> &getPlexServers() const;
+    std::map<std::string, std::shared_ptr<PlexServer>> getPlexServers() const;
+
+    /**
+     * @brief Get a single configured Plex server
+     * @param clientId Server client identifier
+     * @return The server, or nullptr if it is not configured
+     */
+    std::shared_ptr<PlexServer> getPlexServer(const std::string &clientId) const;
 
     /**
      * @brief Add or update a Plex server
@@ -143,6 +176,19 @@ public:
                        const std::string &localUri, const std::string &publicUri,
                        const std::string &accessToken, bool owned = false);
 
+    /**
+     * @brief Add a Plex server or replace the one with the same client identifier
+     * @param server Server object; holders of the previous object keep it unchanged
+     */
+    void setPlexServer(std::shared_ptr<PlexServer> server);
+
+    /**
+     * @brief Remove a configured Plex server
+     * @param clientId Server client identifier
+     * @return true if the server was configured
+     */
+    bool removePlexServer(const std::string &clientId);
+
     /**
      * @brief Remove all configured Plex servers
      */
@@ -252,12 +298,19 @@ private:
     void loadFromYaml(const YAML::Node &config);
     YAML::Node saveToYaml() const;
 
+    // Debounced saving
+    static constexpr auto SAVE_DELAY = std::chrono::seconds(1);
+    void scheduleSaveLocked();
+    void runQueuedSave();
+    bool writeFile();
+
     // Configuration path
     std::filesystem::path configPath;
 
     // Configuration values
     std::atomic<int> logLevel{1};
     std::atomic<uint64_t> discordClientId{1402058094103761007};
+    std::atomic<size_t> cacheMemoryBudget{4 * 1024 * 1024};
 
     // Complex types need mutex protection
     bool showMusic{true};
@@ -284,4 +337,13 @@ private:
 
     // Thread safety mutex
     mutable std::shared_mutex mutex;
+
+    // Save state; saveMutex guards the members after dirty
+    std::atomic<bool> dirty{false};
+    std::mutex writeMutex; // Held while the file is written
+    std::mutex saveMutex;
+    std::condition_variable saveCv;
+    TimerService::TimerId saveTimer = 0;
+    bool saveQueued = false; // A write was posted to the worker pool
+    bool closing = false;
 };
@@ -0,0 +1,87 @@
+#pragma once
+
+// Standard library headers
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Third-party headers
+#include <nlohmann/json.hpp>
+
+// Project headers
+#include "wake_signal.h"
+
+/**
+ * @class ControlServer
+ * @brief Local socket for querying the running instance and tuning it at runtime
+ *
+ * Listens on a Unix-domain socket in the config directory that only the
+ * owner can connect to. A client sends one line, a command name followed
+ * by space-separated arguments, and gets one line of JSON back before the
+ * connection is closed: {"ok":true,"result":...} or {"ok":false,"error":"..."}.
+ * Commands run one at a time on the server thread, so handlers must not
+ * block for long. A handler rejects its arguments by throwing
+ * std::invalid_argument.
+ *
+ * Not available on Windows, where start() only logs that.
+ */
+class ControlServer
+{
+public:
+    using Handler = std::function<nlohmann::json(const std::vector<std::string> &args)>;
+
+    ControlServer() = default;
+    ~ControlServer();
+
+    ControlServer(const ControlServer &) = delete;
+    ControlServer &operator=(const ControlServer &) = delete;
+
+    /**
+     * @brief Register a command; call before start()
+     * @param name Command name, the first word of a request
+     * @param usage Arguments and a short description, listed by "help"
+     * @param handler Produces the result for the request's arguments
+     */
+    void addCommand(const std::string &name, const std::string &usage, Handler handler);
+
+    /**
+     * @brief Create the socket and start answering requests
+     * @return false if the socket cannot be created
+     */
+    bool start();
+
+    /**
+     * @brief Stop answering requests and remove the socket
+     */
+    void stop();
+
+    static std::filesystem::path socketPath();
+
+    /**
+     * @brief Send one request to the running instance
+     * @param line Command name and arguments
+     * @param response Receives the JSON response, or why there is none
+     * @return false if no instance answered
+     */
+    static bool request(const std::string &line, std::string &response);
+
+private:
+    struct Command
+    {
+        std::string usage;
+        Handler handler;
+    };
+
+    void serveLoop();
+    void serveClient(int clientFd);
+    std::string handleRequest(const std::string &line);
+
+    std::map<std::string, Command> m_commands;
+    WakeSignal m_stopSignal;
+    std::thread m_thread;
+    int m_listenFd = -1;
+    std::filesystem::path m_path;
+};
@@ -9,12 +9,15 @@
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <deque>
+#include <utility>
+#include <vector>
 
 // Platform-specific headers
 #ifdef _WIN32
@@ -29,9 +32,12 @@
 // Project headers
 #include "config.h"
 #include "discord_ipc.h"
+#include "json_writer.h"
+#include "latency_tracker.h"
 #include "logger.h"
 #include "models.h"
 #include "thread_utils.h"
+#include "timer_service.h"
 
 /**
  * Main interface for Discord Rich Presence integration
@@ -79,6 +85,31 @@ public:
 	 */
 	void clearPresence();
 
+	/**
+	 * Drops the connection to Discord and connects again right away
+	 *
+	 * Also skips the backoff wait if the connection thread is waiting to retry.
+	 */
+	void reconnect();
+
+	/**
+	 * Round-trip statistics of requests answered by Discord
+	 */
+	struct RoundTripStats
+	{
+		uint64_t answered = 0;
+		uint64_t timedOut = 0;
+		std::chrono::microseconds p50{0};
+		std::chrono::microseconds p99{0};
+	};
+
+	/**
+	 * Gets the round-trip statistics collected since start
+	 *
+	 * @return Answered and timed out requests with their round-trip percentiles
+	 */
+	RoundTripStats getRoundTripStats();
+
 	// Add callback typedefs and setters
 	/**
 	 * Callback type for connection state changes
@@ -105,6 +136,8 @@ private:
 	std::thread conn_thread;
 	std::mutex mutex;
 	bool running;
+	WakeSignal stop_signal; // Notified by stop() to cut waits and IPC reads short
+	std::atomic<bool> reconnect_requested{false}; // Set by reconnect(), which also notifies stop_signal
 	bool needs_reconnect;
 	int reconnect_attempts;
 	bool is_playing;
@@ -112,9 +145,27 @@ private:
 
 	// New members for frame queue
 	std::mutex frame_queue_mutex;
-	std::string queued_frame;
+	std::string queued_frame; // Reserved header space followed by the payload
+	std::string queued_nonce;
 	bool has_queued_frame;
+	std::mutex send_mutex;
+	std::string sending_frame; // Swapped with queued_frame when sent; guarded by send_mutex
+	std::string sending_nonce;
+
+	// Requests waiting for Discord's answer, by nonce
+	struct PendingRequest
+	{
+		std::chrono::steady_clock::time_point sent;
+		std::chrono::steady_clock::time_point deadline;
+	};
+	std::mutex pending_mutex;
+	std::map<std::string, PendingRequest> pending_requests;
+	LatencyHistogram round_trips;
+	uint64_t completed_requests = 0;
+	uint64_t timed_out_requests = 0;
+	std::chrono::steady_clock::time_point next_health_check; // Used by the connection thread only
 	int64_t last_frame_write_time;
+	TimerService::TimerId frame_timer = 0; // Retries a rate-limited frame
 
 	ConnectionCallback onConnected;
 	ConnectionCallback onDisconnected;
@@ -143,18 +194,49 @@ private:
 	void connectionThread();
 
 	/**
-	 * Checks if Discord connection is still alive by sending a ping
+	 * Pings Discord unless a frame was sent recently
+	 *
+	 * The PONG is awaited like any other request: if it doesn't arrive
+	 * before its deadline the connection is considered hung.
+	 *
+	 * @return false if the ping could not be sent
+	 */
+	bool pingIfIdle();
+
+	/**
+	 * Sends a presence update frame to Discord without waiting for the answer
 	 *
-	 * @return true if connection is healthy, false otherwise
+	 * @param frame Reserved header space followed by the JSON payload
+	 * @param nonce Nonce of the payload, which Discord's answer carries
+	 */
+	void sendPresenceFrame(std::string &frame, const std::string &nonce);
+
+	/**
+	 * Closes the connection after a failure and lets the connection thread reconnect
 	 */
-	bool isStillAlive();
+	void connectionLost();
 
 	/**
-	 * Sends a presence update message to Discord
+	 * Handles a frame read by the connection thread
 	 *
-	 * @param message The JSON payload to send
+	 * Answers are matched to their request by nonce; everything else is an
+	 * event Discord sent on its own.
 	 */
-	void sendPresenceMessage(const std::string &message);
+	void handleFrame(int opcode, const std::string &data);
+
+	// Outstanding requests: tracked when sent, completed by the matching
+	// answer, failed once their deadline passes
+	void trackRequest(const std::string &nonce);
+	void forgetRequest(const std::string &nonce);
+	bool completeRequest(const std::string &nonce);
+	std::chrono::steady_clock::time_point nextRequestDeadline();
+
+	/**
+	 * Drops requests whose deadline has passed
+	 *
+	 * @return false if any request timed out, meaning Discord is hung
+	 */
+	bool expireRequests();
 
 	/**
 	 * Attempts to establish a connection to Discord
@@ -164,30 +246,42 @@ private:
 	bool attemptConnection();
 
 	/**
-	 * Creates the activity portion of the Discord Rich Presence payload
-	 *
-	 * @param info Media information to display
-	 * @return JSON object representing the activity
+	 * Fields of a Rich Presence activity, ready to be serialized
 	 */
-	nlohmann::json createActivity(const MediaInfo &info);
+	struct Activity
+	{
+		int type = 3;
+		std::string state;
+		std::string details;
+		std::string largeImage;
+		std::string largeText;  // Omitted when empty
+		std::string smallImage; // Omitted with smallText when empty
+		std::string smallText;
+		int64_t start = 0;
+		int64_t end = 0;
+		std::vector<std::pair<std::string, std::string>> buttons; // Label and URL
+	};
 
 	/**
-	 * Creates the primary Discord presence payload
+	 * Fills in the activity shown for the given media
 	 *
 	 * @param info Media information to display
-	 * @param nonce Unique identifier for this update
-	 * @return JSON string representation of the presence payload
+	 * @param activity Activity to fill in
+	 * @return false if this media type is hidden and no activity should be shown
 	 */
-	std::string createPresence(const MediaInfo &info, const std::string &nonce);
+	bool createActivity(const MediaInfo &info, Activity &activity);
 
 	/**
-	 * Creates the metadata portion of the Discord presence payload
+	 * Appends a SET_ACTIVITY payload to the frame buffer
 	 *
-	 * @param info Media information to display
+	 * Written directly with a JsonWriter rather than through a JSON document,
+	 * since presence updates are the only frames sent regularly.
+	 *
+	 * @param frame Buffer to append to, normally holding just the reserved header
+	 * @param activity Activity to show, or nullptr to clear the presence
 	 * @param nonce Unique identifier for this update
-	 * @return JSON string representation of the metadata payload
 	 */
-	std::string createPresenceMetadata(const MediaInfo &info, const std::string &nonce);
+	void writePresence(std::string &frame, const Activity *activity, const std::string &nonce);
 
 	/**
 	 * Generates a unique nonce string for Discord messages
@@ -197,11 +291,11 @@ private:
 	std::string generateNonce();
 
 	/**
-	 * Queues a presence message to be sent to Discord
+	 * Queues a presence update to be sent to Discord, replacing any queued one
 	 *
-	 * @param message The JSON payload to queue
+	 * @param activity Activity to show, or nullptr to clear the presence
 	 */
-	void queuePresenceMessage(const std::string &message);
+	void queuePresence(const Activity *activity);
     
 	/**
 	 * Processes the queued frame and sends it to Discord
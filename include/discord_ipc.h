@@ -6,6 +6,7 @@
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -16,6 +17,8 @@
 #include <ws2tcpip.h>
 #else
 #include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -38,6 +41,7 @@
 
 // Project headers
 #include "logger.h"
+#include "wake_signal.h"
 
 // Discord IPC opcodes
 enum DiscordOpcodes
@@ -102,14 +106,51 @@ public:
      */
     bool writeFrame(int opcode, const std::string &payload);
 
+    /** Bytes reserved in front of the payload by writeFramed() callers */
+    static constexpr size_t FRAME_HEADER_SIZE = 8;
+
+    /**
+     * Writes a frame built in place, without copying the payload
+     *
+     * The first FRAME_HEADER_SIZE bytes of the frame are overwritten with the
+     * header; the payload follows them. The frame is sent with a single write.
+     *
+     * @param opcode The Discord IPC opcode for this message
+     * @param frame Reserved header space followed by the JSON payload
+     * @return true if write was successful, false if it failed
+     */
+    bool writeFramed(int opcode, std::string &frame);
+
+    /** Outcome of readFrame() */
+    enum class ReadResult
+    {
+        Frame,       // A complete frame was read
+        Timeout,     // Nothing complete arrived in time; partial data is kept
+        Interrupted, // The wake signal is set
+        Closed       // The connection failed or was closed
+    };
+
     /**
-     * Reads a framed message from Discord
+     * Reads the next framed message from Discord
+     *
+     * Bytes are collected across calls, so a frame that is still arriving
+     * when the timeout passes is returned complete by a later call. Only one
+     * thread may read at a time.
      *
      * @param opcode Output parameter that will contain the received opcode
      * @param data Output parameter that will contain the received data
-     * @return true if read was successful, false if it failed
+     * @param timeout How long to wait for a frame; negative waits until one
+     *                arrives or the wake signal is notified
+     * @return What happened; opcode and data are only set for Frame
      */
-    bool readFrame(int &opcode, std::string &data);
+    ReadResult readFrame(int &opcode, std::string &data, std::chrono::milliseconds timeout);
+
+    /**
+     * Sets a signal that interrupts blocking reads when notified
+     *
+     * @param signal Signal to watch, or nullptr to block until data arrives
+     */
+    void setWakeSignal(WakeSignal *signal);
 
     /**
      * Sends the initial handshake message to Discord
@@ -127,14 +168,69 @@ public:
     bool sendPing();
 
 private:
+    /** Longest a write may wait for Discord to drain the socket */
+    static constexpr int WRITE_TIMEOUT_MS = 5000;
+
+    /** Frames claiming to be larger than this are treated as corrupt */
+    static constexpr uint32_t MAX_FRAME_SIZE = 16 * 1024 * 1024;
+
     /** Flag indicating whether there's an active connection to Discord */
     std::atomic<bool> connected;
 
+    /** Bytes received but not yet returned as a frame; used by the reading thread only */
+    std::string read_buffer;
+
+    /** Serializes writes so frames from different threads don't interleave */
+    std::mutex write_mutex;
+
+    /**
+     * Moves the first complete frame out of the read buffer
+     *
+     * @return true if there was a complete frame
+     */
+    bool takeFrame(int &opcode, std::string &data);
+
+    /**
+     * Waits up to timeout for data and appends what arrived to the read buffer
+     *
+     * @return Frame if data was added (not necessarily a whole frame), or why not
+     */
+    ReadResult fillReadBuffer(std::chrono::milliseconds timeout);
+
+    /** Interrupts blocking reads when notified; may be null */
+    WakeSignal *wake_signal;
+
 #ifdef _WIN32
-    /** Windows-specific handle to the Discord IPC pipe */
+    /** Windows-specific handle to the Discord IPC pipe, opened for overlapped I/O */
     HANDLE pipe_handle;
+
+    /**
+     * Completion events of the overlapped read and write. Reads come from one
+     * thread and writes are serialized, so one of each is enough.
+     */
+    HANDLE read_event;
+    HANDLE write_event;
+
+    /** Set through the wake signal to end the wait for a pending read */
+    HANDLE wake_event;
+
+    /**
+     * Waits up to timeout_ms for an overlapped operation, cancelling it if it
+     * is still pending then
+     *
+     * @param extra_event Another event that ends the wait early, or NULL
+     * @return The operation's result, as GetOverlappedResult() reports it
+     */
+    bool finishOverlapped(OVERLAPPED &overlapped, DWORD timeout_ms, HANDLE extra_event, DWORD &transferred);
 #else
     /** Unix-specific file descriptor for the Discord IPC socket */
     int pipe_fd;
+
+    /**
+     * Makes the freshly connected socket non-blocking and marks it connected
+     *
+     * @return true on success; the socket is closed on failure
+     */
+    bool markConnected();
 #endif
 };
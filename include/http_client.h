@@ -8,38 +8,81 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <vector>
 
 // Third-party headers
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
 
 // Project headers
+#include "cancellation_token.h"
 #include "logger.h"
+#include "notification_transport.h"
+#include "request_template.h"
+#include "wake_signal.h"
 
 /**
- * @brief HTTP client with support for GET, POST, and Server-Sent Events (SSE)
+ * @brief HTTP client with support for GET, POST, and notification streams
+ *        (Server-Sent Events or WebSocket)
+ *
+ * Transfers run on a curl multi handle so they can be interrupted at once:
+ * stopSSE() and reconnectSSE() wake the stream transfer, and notifying the
+ * optional abort signal aborts every transfer made by the client.
  */
 class HttpClient
 {
 public:
-    HttpClient();
+    explicit HttpClient(WakeSignal *abortSignal = nullptr);
     ~HttpClient();
 
     // Callback type for SSE events
     using EventCallback = std::function<void(const std::string &)>;
 
-    // Regular HTTP requests
+    // Returns the URL to use for the next SSE connection attempt
+    using UrlProvider = std::function<std::string()>;
+
+    // Called after a failed SSE connection attempt; returns true if the URL
+    // provider now yields a different URL and the retry should happen immediately
+    using ErrorCallback = std::function<bool()>;
+
+    // Called when an SSE connection starts delivering data
+    using ConnectedCallback = std::function<void()>;
+
+    // Regular HTTP requests; cancelling the optional token aborts the
+    // request the same way the client's abort signal does
     bool get(const std::string &url,
              const std::map<std::string, std::string> &headers,
-             std::string &response);
+             std::string &response,
+             const CancellationToken *cancel = nullptr);
+
+    // Same, with the template's base URL and prebuilt header list
+    bool get(const RequestTemplate &request,
+             const std::string &path,
+             std::string &response,
+             const CancellationToken *cancel = nullptr);
 
     bool post(const std::string &url,
               const std::map<std::string, std::string> &headers,
               const std::string &body,
-              std::string &response);
+              std::string &response,
+              const CancellationToken *cancel = nullptr);
+
+    // HEAD request, used to check reachability without transferring a body
+    bool head(const std::string &url,
+              const std::map<std::string, std::string> &headers,
+              const CancellationToken *cancel = nullptr);
+    bool head(const RequestTemplate &request,
+              const std::string &path,
+              const CancellationToken *cancel = nullptr);
+
+    // Status code and headers (names lower-cased) of the last regular request;
+    // the status code is 0 if no response was received
+    long lastStatusCode() const { return m_lastStatusCode; }
+    const std::map<std::string, std::string> &lastResponseHeaders() const { return m_lastResponseHeaders; }
 
     bool downloadFile(const std::string &url,
                       const std::map<std::string, std::string> &headers,
@@ -49,28 +92,87 @@ public:
     bool startSSE(const std::string &url,
                   const std::map<std::string, std::string> &headers,
                   EventCallback callback);
+    bool startSSE(UrlProvider urlProvider,
+                  const std::map<std::string, std::string> &headers,
+                  EventCallback callback,
+                  ErrorCallback onError = nullptr,
+                  ConnectedCallback onConnected = nullptr);
+
+    // Notification stream over the first supported transport. The URL
+    // provider yields the server URI, which each transport completes. If
+    // the server answers but refuses a transport before it ever worked, the
+    // stream falls back to the next one for as long as it runs.
+    bool startNotifications(UrlProvider serverUriProvider,
+                            const std::map<std::string, std::string> &headers,
+                            std::vector<std::shared_ptr<NotificationTransport>> transports,
+                            EventCallback callback,
+                            ErrorCallback onError = nullptr,
+                            ConnectedCallback onConnected = nullptr);
+
+    // Stop the SSE or notification stream
     bool stopSSE();
 
+    // Drop the current stream connection and reconnect using the URL provider
+    void reconnectSSE();
+
 private:
     // CURL callback functions
     static size_t writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata);
+    static size_t headerCallback(char *ptr, size_t size, size_t nmemb, void *userdata);
     static size_t sseCallback(char *ptr, size_t size, size_t nmemb, void *userdata);
     static int sseCallbackProgress(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
                                    curl_off_t ultotal, curl_off_t ulnow);
 
     // Helper methods
-    bool setupCommonOptions(const std::string &url, const std::map<std::string, std::string> &headers);
+    CURLcode performTransfer(CURLM *multi, CURL *curl, const std::function<bool()> &shouldAbort);
+    CURLcode performRequest(CURL *curl, const CancellationToken *cancel);
+    void wakeTransfers();
+    bool aborted() const;
+    bool setupCommonOptions(const std::string &url);
+    bool performGet(const std::string &url, struct curl_slist *headers, std::string &response,
+                    const CancellationToken *cancel);
+    bool performHead(const std::string &url, struct curl_slist *headers, const CancellationToken *cancel);
+
+    // Serve a request or an SSE stream from the TrafficReplay capture
+    bool replayRequest(const std::string &method, const std::string &url, std::string *response,
+                       const CancellationToken *cancel);
+    void replaySSE(const UrlProvider &urlProvider, const ErrorCallback &onError);
+
+    // Run on the stream thread: connection attempts until stopped
+    void runStream(const UrlProvider &urlProvider, const std::map<std::string, std::string> &headers,
+                   const ErrorCallback &onError);
+    void checkStreamEstablished(CURL *curl);
+    void deliverEvent(const std::string &data);
+
+    // Sleep for a replayed delay; false if interrupted returned true first
+    bool replayWait(std::chrono::microseconds delay, const std::function<bool()> &interrupted);
     struct curl_slist *createHeaderList(const std::map<std::string, std::string> &headers);
     bool checkResponse(CURLcode res);
 
     // Member variables
     CURL *m_curl;
+    CURLM *m_multi; // Drives m_curl; reused so connections stay alive between requests
+    WakeSignal *m_abortSignal;
+    size_t m_abortListenerId{0};
+    std::mutex m_transferMutex;
+    std::set<CURLM *> m_activeTransfers;
+    std::string m_endpoint; // LatencyTracker endpoint of the current request
+    long m_lastStatusCode{0};
+    std::map<std::string, std::string> m_lastResponseHeaders;
     std::thread m_sseThread;
     EventCallback m_eventCallback;
-    std::string m_sseBuffer;
+    ConnectedCallback m_connectedCallback;
+    std::vector<std::shared_ptr<NotificationTransport>> m_transports; // Supported ones, in order of preference
+    NotificationTransport *m_transport{nullptr};                      // Of the current connection attempt
+    NotificationTransport::EventCallback m_deliverEvent;
+    std::string m_sseUrl; // URL of the current stream connection, for capture
+    CURL *m_sseCurl{nullptr};
+    bool m_sseEstablished{false}; // The current connection was accepted
+    bool m_transportWorked{false}; // The current transport was accepted at least once
 
     // Thread synchronization for SSE
     std::atomic<bool> m_stopFlag{false};
+    std::atomic<bool> m_reconnectFlag{false};
     std::atomic<bool> m_sseRunning{false};
     std::mutex m_sseMutex;
     std::condition_variable m_sseCondVar;
@@ -0,0 +1,171 @@
+#pragma once
+
+// Standard library headers
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * @class JsonWriter
+ * @brief Appends JSON straight to a string, without building a document first
+ *
+ * Meant for small payloads of known shape that are sent often. The writer
+ * only tracks where commas go; the caller is responsible for balancing
+ * begin/end calls and for putting a key before every value inside objects.
+ * Strings are written as UTF-8, escaping quotes, backslashes and control
+ * characters like nlohmann::json::dump() does.
+ */
+class JsonWriter
+{
+public:
+    explicit JsonWriter(std::string &out) : m_out(out) {}
+
+    JsonWriter &beginObject()
+    {
+        separator();
+        m_out.push_back('{');
+        m_needComma = false;
+        return *this;
+    }
+
+    JsonWriter &endObject()
+    {
+        m_out.push_back('}');
+        m_needComma = true;
+        return *this;
+    }
+
+    JsonWriter &beginArray()
+    {
+        separator();
+        m_out.push_back('[');
+        m_needComma = false;
+        return *this;
+    }
+
+    JsonWriter &endArray()
+    {
+        m_out.push_back(']');
+        m_needComma = true;
+        return *this;
+    }
+
+    JsonWriter &key(std::string_view name)
+    {
+        separator();
+        writeString(name);
+        m_out.push_back(':');
+        m_needComma = false;
+        return *this;
+    }
+
+    JsonWriter &value(std::string_view text)
+    {
+        separator();
+        writeString(text);
+        m_needComma = true;
+        return *this;
+    }
+
+    JsonWriter &value(const char *text) { return value(std::string_view(text)); }
+    JsonWriter &value(const std::string &text) { return value(std::string_view(text)); }
+
+    JsonWriter &value(bool flag)
+    {
+        separator();
+        m_out.append(flag ? "true" : "false");
+        m_needComma = true;
+        return *this;
+    }
+
+    template <typename Int, std::enable_if_t<std::is_integral_v<Int> && !std::is_same_v<Int, bool>, int> = 0>
+    JsonWriter &value(Int number)
+    {
+        separator();
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), number);
+        m_out.append(digits, result.ptr);
+        m_needComma = true;
+        return *this;
+    }
+
+    JsonWriter &null()
+    {
+        separator();
+        m_out.append("null");
+        m_needComma = true;
+        return *this;
+    }
+
+    // Shorthand for key(name).value(v)
+    template <typename Value>
+    JsonWriter &field(std::string_view name, const Value &v)
+    {
+        return key(name).value(v);
+    }
+
+private:
+    void separator()
+    {
+        if (m_needComma)
+        {
+            m_out.push_back(',');
+        }
+    }
+
+    void writeString(std::string_view text)
+    {
+        static constexpr char HEX[] = "0123456789abcdef";
+
+        m_out.push_back('"');
+        size_t runStart = 0;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            auto c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x20 && c != '"' && c != '\\')
+            {
+                continue;
+            }
+
+            // Copy the plain run before the character in one go
+            m_out.append(text.data() + runStart, i - runStart);
+            runStart = i + 1;
+            switch (c)
+            {
+            case '"':
+                m_out.append("\\\"");
+                break;
+            case '\\':
+                m_out.append("\\\\");
+                break;
+            case '\b':
+                m_out.append("\\b");
+                break;
+            case '\f':
+                m_out.append("\\f");
+                break;
+            case '\n':
+                m_out.append("\\n");
+                break;
+            case '\r':
+                m_out.append("\\r");
+                break;
+            case '\t':
+                m_out.append("\\t");
+                break;
+            default:
+                m_out.append("\\u00");
+                m_out.push_back(HEX[c >> 4]);
+                m_out.push_back(HEX[c & 0xF]);
+                break;
+            }
+        }
+        m_out.append(text.data() + runStart, text.size() - runStart);
+        m_out.push_back('"');
+    }
+
+    std::string &m_out;
+    bool m_needComma = false;
+};
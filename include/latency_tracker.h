@@ -0,0 +1,121 @@
+#pragma once
+
+// Standard library headers
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Rolling latency histogram with logarithmic buckets
+ *
+ * Bucket bounds grow by a factor of 2^(1/4) from 100 us, so percentiles are
+ * accurate to about 19% anywhere between LAN and slow third-party calls.
+ * Once WINDOW samples have been added all counts are halved, which lets old
+ * samples fade out instead of pinning the percentiles forever.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr size_t BUCKETS = 96;
+    static constexpr uint32_t WINDOW = 256;
+
+    void add(std::chrono::microseconds latency);
+
+    /**
+     * @brief Upper bound of the bucket holding the given quantile
+     * @return Zero if there are no samples
+     */
+    std::chrono::microseconds percentile(double quantile) const;
+
+    uint32_t samples() const { return m_total; }
+
+private:
+    static std::chrono::microseconds upperBound(size_t bucket);
+
+    std::array<uint32_t, BUCKETS> m_counts{};
+    uint32_t m_total = 0;
+};
+
+/**
+ * @brief Timeouts to use for one request
+ */
+struct RequestTimeouts
+{
+    std::chrono::milliseconds connect;
+    std::chrono::milliseconds total;
+    long lowSpeedTime; // Seconds below LOW_SPEED_LIMIT bytes/s before giving up
+};
+
+/**
+ * @brief Latency summary of one endpoint, for logging
+ */
+struct EndpointLatencyStats
+{
+    std::string endpoint;
+    uint32_t samples = 0;
+    std::chrono::microseconds p50{0};
+    std::chrono::microseconds p99{0};
+    std::chrono::microseconds connectP99{0};
+    RequestTimeouts timeouts{};
+};
+
+/**
+ * @class LatencyTracker
+ * @brief Singleton deriving request timeouts from the latency seen so far
+ *
+ * Latency is tracked per endpoint: scheme, host and port plus the first two
+ * path segments, so /status/sessions on a LAN server and a Jikan search are
+ * judged separately. Once an endpoint has enough samples its timeouts are
+ * its p99 times a safety factor, clamped to a floor and a ceiling; until
+ * then the defaults apply. Connecting is tracked apart from the whole
+ * request, so a dead LAN path fails within tens of milliseconds while a
+ * slow but healthy API keeps its long timeout.
+ */
+class LatencyTracker
+{
+public:
+    static constexpr long LOW_SPEED_LIMIT = 1; // Bytes per second
+
+    static LatencyTracker &getInstance();
+
+    /**
+     * @brief Endpoint a URL belongs to, e.g. "http://10.0.0.2:32400/status/sessions"
+     *
+     * Query strings and numeric path segments are dropped.
+     */
+    static std::string endpointOf(const std::string &url);
+
+    RequestTimeouts timeoutsFor(const std::string &endpoint) const;
+
+    /**
+     * @brief Record a finished request
+     * @param connectTime Time until the connection was up; zero if it never was
+     * @param totalTime Time of the whole request
+     * @param timedOut Whether the request hit its total timeout; the
+     *                 sample then only says the request took at least that long
+     */
+    void record(const std::string &endpoint, std::chrono::microseconds connectTime,
+                std::chrono::microseconds totalTime, bool timedOut);
+
+    std::vector<EndpointLatencyStats> stats() const;
+
+private:
+    LatencyTracker() = default;
+    LatencyTracker(const LatencyTracker &) = delete;
+    LatencyTracker &operator=(const LatencyTracker &) = delete;
+
+    struct Endpoint
+    {
+        LatencyHistogram connect;
+        LatencyHistogram total;
+    };
+
+    RequestTimeouts timeoutsLocked(const Endpoint *endpoint) const;
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, Endpoint> m_endpoints;
+};
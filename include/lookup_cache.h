@@ -0,0 +1,144 @@
+#pragma once
+
+// Standard library headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Project headers
+#include "cache.h"
+
+/**
+ * @brief Outcome of a lookup against an external service
+ */
+enum class LookupStatus
+{
+    Found,    // The service returned a value
+    NotFound, // The service answered definitively that there is no value
+    Transient // No usable answer (timeout, rate limit, 5xx); worth retrying
+};
+
+/**
+ * @brief Result of a lookup, with the value only meaningful when Found
+ */
+template <typename Value>
+struct Lookup
+{
+    LookupStatus status = LookupStatus::Transient;
+    Value value{};
+
+    bool found() const { return status == LookupStatus::Found; }
+};
+
+/**
+ * @brief Lifetimes applied by a LookupCache
+ */
+struct LookupCachePolicy
+{
+    std::chrono::seconds foundTtl;       // How long a found value is kept
+    std::chrono::seconds notFoundTtl;    // First "not found" answer; doubles on each repeat
+    std::chrono::seconds maxNotFoundTtl; // Upper bound for the doubling
+    std::chrono::seconds transientTtl;   // Cooldown after a transient failure
+};
+
+/**
+ * @class LookupCache
+ * @brief BoundedCache for external lookups that also remembers misses
+ *
+ * Definitive misses are cached with a shorter lifetime that doubles every
+ * time the same key misses again, so titles the service does not know stop
+ * generating requests while they play. Transient failures get their own short
+ * cooldown and do not count as misses, so an outage never makes a key look
+ * permanently unknown.
+ *
+ * @tparam Value Cached value type; must be copyable
+ */
+template <typename Value>
+class LookupCache
+{
+public:
+    using SizeFunction = typename BoundedCache<Value>::SizeFunction;
+
+    LookupCache(std::string name, size_t byteBudget, SizeFunction sizeOf, LookupCachePolicy policy)
+        : m_policy(policy),
+          m_entries(name, byteBudget - byteBudget / 8, [sizeOf](const Lookup<Value> &lookup)
+                    { return sizeOf(lookup.value); }),
+          m_missCounts(name + "_misses", byteBudget / 8, [](const uint32_t &)
+                       { return sizeof(uint32_t); }, 1)
+    {
+    }
+
+    /**
+     * @brief Look up a cached answer, positive or negative
+     * @return The cached lookup, or std::nullopt if the service should be asked
+     */
+    std::optional<Lookup<Value>> get(std::string_view key)
+    {
+        return m_entries.get(key);
+    }
+
+    /**
+     * @brief Record the answer of a lookup, choosing the TTL from its status
+     */
+    void put(std::string_view key, const Lookup<Value> &lookup)
+    {
+        switch (lookup.status)
+        {
+        case LookupStatus::Found:
+            m_missCounts.erase(key);
+            m_entries.put(key, lookup, m_policy.foundTtl);
+            break;
+
+        case LookupStatus::NotFound:
+        {
+            // The miss count outlives the negative entry, so a key that keeps
+            // missing is asked about less and less often
+            uint32_t misses = m_missCounts.get(key).value_or(0);
+            auto ttl = m_policy.notFoundTtl * (int64_t{1} << (std::min)(misses, MAX_DOUBLINGS));
+            ttl = (std::min)(ttl, m_policy.maxNotFoundTtl);
+
+            m_missCounts.put(key, misses + 1, m_policy.maxNotFoundTtl * 2);
+            m_entries.put(key, Lookup<Value>{LookupStatus::NotFound, Value{}}, ttl);
+            break;
+        }
+
+        case LookupStatus::Transient:
+            m_entries.put(key, Lookup<Value>{LookupStatus::Transient, Value{}}, m_policy.transientTtl);
+            break;
+        }
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+        m_missCounts.clear();
+    }
+
+    CacheStats stats() const
+    {
+        return m_entries.stats();
+    }
+
+    std::vector<std::string> keys(size_t limit) const
+    {
+        return m_entries.keys(limit);
+    }
+
+    const std::string &name() const
+    {
+        return m_entries.name();
+    }
+
+private:
+    // Keeps the TTL multiplier from overflowing; maxNotFoundTtl caps it anyway
+    static constexpr uint32_t MAX_DOUBLINGS = 16;
+
+    const LookupCachePolicy m_policy;
+    BoundedCache<Lookup<Value>> m_entries;
+    BoundedCache<uint32_t> m_missCounts;
+};
@@ -1,6 +1,8 @@
 ﻿#pragma once
 
 // Standard library headers
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
 #include <signal.h>
 
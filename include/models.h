@@ -3,6 +3,7 @@
 // Standard library headers
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
@@ -11,10 +12,19 @@
 
 // Project headers
 #include "http_client.h"
+#include "string_pool.h"
 
 // Forward declarations
 class HttpClient;
 
+// How a server's notifications are received
+enum class NotificationProtocol
+{
+    Auto,      // WebSocket, falling back to SSE if the server refuses it
+    WebSocket, // WebSocket only
+    SSE        // Server-Sent Events only
+};
+
 // Define the PlexServer struct
 struct PlexServer
 {
@@ -24,9 +34,29 @@ struct PlexServer
     std::string publicUri;
     std::string accessToken;
     std::chrono::system_clock::time_point lastUpdated;
-    std::unique_ptr<HttpClient> httpClient;
     std::atomic<bool> running;
     bool owned = false;
+    NotificationProtocol notifications = NotificationProtocol::Auto;
+
+    // The client running the server's notification stream, or null. Set-up,
+    // teardown and the threads that nudge the stream race on it, so callers
+    // take their own reference; a replaced client is returned to be
+    // destroyed outside the lock
+    std::shared_ptr<HttpClient> streamClient() const
+    {
+        std::lock_guard<std::mutex> lock(streamClientMutex);
+        return httpClient;
+    }
+    std::shared_ptr<HttpClient> replaceStreamClient(std::shared_ptr<HttpClient> client)
+    {
+        std::lock_guard<std::mutex> lock(streamClientMutex);
+        httpClient.swap(client);
+        return client;
+    }
+
+private:
+    mutable std::mutex streamClientMutex;
+    std::shared_ptr<HttpClient> httpClient;
 };
 
 enum class PlaybackState
@@ -56,59 +86,73 @@ enum class LinkType
     Unknown
 };
 
-// Playback information
-struct MediaInfo
+// Static metadata of a media item. Built once per item, then shared
+// read-only between the media cache and every session playing it.
+struct MediaMetadata
 {
     // General
-    std::string title;               // Title of the media
-    std::string originalTitle;       // Original title (original language)
-    MediaType type;                  // Type of media (movie, TV show)
-    std::string artPath;             // Path to art on the server (cover image)
-    std::string thumbPath;           // Path to the thumbnail on the server
-    int year;                        // Year of release
-    std::string summary;             // Summary of the media
-    std::vector<std::string> genres; // List of genres
-    std::string imdbId;              // IMDB ID (if applicable)
-    std::string tmdbId;              // TMDB ID (if applicable)
-    std::string tvdbId;              // TVDB ID (if applicable)
-    std::string malId;               // MyAnimeList ID (if applicable)
+    std::string title;                   // Title of the media
+    std::string originalTitle;           // Original title (original language)
+    MediaType type = MediaType::Unknown; // Type of media (movie, TV show)
+    std::string artPath;                 // Path to art on the server (cover image)
+    std::string thumbPath;               // Path to the thumbnail on the server
+    int64_t updatedAt = 0;               // Last modification stamp on the server (artwork versioning)
+    int year = 0;                        // Year of release
+    std::string summary;                 // Summary of the media
+    std::vector<InternedString> genres;  // List of genres
+    std::string imdbId;                  // IMDB ID (if applicable)
+    std::string tmdbId;                  // TMDB ID (if applicable)
+    std::string tvdbId;                  // TVDB ID (if applicable)
+    std::string malId;                   // MyAnimeList ID (if applicable)
 
     // TV Show specific
     std::string grandparentTitle; // Parent title (tv show name)
     std::string grandparentArt;   // Parent art URL (tv show cover image)
     std::string grandparentKey;   // Parent ID (tv show ID)
-    int season;                   // Season number
-    int episode;                  // Episode number
+    int season = 0;               // Season number
+    int episode = 0;              // Episode number
 
     // Music specific
-    std::string album;  // Album title
-    std::string artist; // Artist name
+    std::string album;      // Album title
+    std::string artist;     // Artist name
     std::string plexampUrl; // Plexamp deep link
-    int audioBitDepth;
-    int audioSamplingRate;
-
-    // Playback info
-    std::string username; // Username of the person watching
-    std::string client; // Client device name
-    std::string videoResolution;
-    int bitrate;
-    PlaybackState state;  // Current playback state
-    double progress;      // Current progress in seconds
-    double duration;      // Total duration in seconds
-    time_t startTime;     // When the playback started
-
-    // Misc
-    std::string sessionKey; // Plex session key
-    std::string serverId;   // ID of the server hosting this content
-    std::string filename;   // Filename of the media
-    std::string mediaKey;   // Key of the media
-
-    MediaInfo() : state(PlaybackState::Stopped),
-                  progress(0),
-                  duration(0),
-                  startTime(0),
-                  type(MediaType::Unknown),
-                  bitrate(0),
-                  audioBitDepth(0),
-                  audioSamplingRate(0) {}
+    int audioBitDepth = 0;
+    int audioSamplingRate = 0;
+
+    // Media file
+    InternedString videoResolution;
+    int bitrate = 0;
+    double duration = 0;  // Total duration in seconds
+    std::string filename; // Filename of the media
+    std::string mediaKey; // Key of the media
+
+    // Shared instance with every field empty
+    static const std::shared_ptr<const MediaMetadata> &empty()
+    {
+        static const std::shared_ptr<const MediaMetadata> instance = std::make_shared<const MediaMetadata>();
+        return instance;
+    }
+};
+
+// Mutable playback state of a session
+struct PlaybackStatus
+{
+    PlaybackState state = PlaybackState::Stopped; // Current playback state
+    double progress = 0;                          // Current progress in seconds
+    time_t startTime = 0;                         // When the playback started
+};
+
+// Playback information: shared metadata plus per-session state. Copying
+// it copies a shared pointer, a few words and the short session key.
+struct MediaInfo
+{
+    std::shared_ptr<const MediaMetadata> metadata = MediaMetadata::empty();
+    PlaybackStatus playback;
+
+    InternedString username;   // Username of the person watching
+    InternedString client;     // Client device name
+    std::string sessionKey;    // Plex session key; not interned, keys only ever grow
+    InternedString serverId;   // ID of the server hosting this content
+
+    const MediaMetadata &meta() const { return *metadata; }
 };
@@ -0,0 +1,114 @@
+#pragma once
+
+// Standard library headers
+#include <chrono>
+#include <functional>
+#include <string>
+
+// Third-party headers
+#include <curl/curl.h>
+
+/**
+ * @class NotificationTransport
+ * @brief Protocol of a long-lived notification stream run by HttpClient
+ *
+ * HttpClient owns the connection loop: reconnects, backoff, URL failover
+ * and aborting. A transport only decides what one connection attempt looks
+ * like and how the bytes it receives split into events. Transports are
+ * used by the stream thread only, so they need no locking.
+ */
+class NotificationTransport
+{
+public:
+    using EventCallback = std::function<void(const std::string &)>;
+
+    virtual ~NotificationTransport() = default;
+
+    // Name for logs
+    virtual const char *name() const = 0;
+
+    // Whether the linked libcurl can run this transport
+    virtual bool isSupported() const { return true; }
+
+    // URL of the stream on a server, given as scheme, host and port
+    virtual std::string streamUrl(const std::string &serverUri) const = 0;
+
+    /**
+     * @brief Set up a fresh handle for one connection attempt
+     * @param curl Handle of the attempt, valid until the next prepare()
+     * @param headers Request headers; transports may append to the list
+     */
+    virtual void prepare(CURL *curl, struct curl_slist *&headers) = 0;
+
+    // Whether the server accepted the stream, given the response status
+    virtual bool isEstablished(long responseCode) const = 0;
+
+    /**
+     * @brief Feed received bytes
+     * @param onEvent Called with the payload of every complete event
+     */
+    virtual void consume(const char *data, size_t size, const EventCallback &onEvent) = 0;
+
+    /**
+     * @brief Called at least once a second while the connection is up
+     * @return false if the connection is dead and should be dropped
+     */
+    virtual bool keepAlive() { return true; }
+};
+
+/**
+ * @class SseTransport
+ * @brief Server-Sent Events: "data:" lines of events separated by a blank line
+ */
+class SseTransport : public NotificationTransport
+{
+public:
+    // endpoint is appended to the server URI
+    explicit SseTransport(std::string endpoint) : m_endpoint(std::move(endpoint)) {}
+
+    const char *name() const override { return "SSE"; }
+    std::string streamUrl(const std::string &serverUri) const override { return serverUri + m_endpoint; }
+    void prepare(CURL *curl, struct curl_slist *&headers) override;
+    bool isEstablished(long responseCode) const override { return responseCode >= 200 && responseCode < 300; }
+    void consume(const char *data, size_t size, const EventCallback &onEvent) override;
+
+private:
+    const std::string m_endpoint;
+    std::string m_buffer;
+};
+
+/**
+ * @class WebSocketTransport
+ * @brief WebSocket: one event per text message
+ *
+ * libcurl answers the server's pings. The transport pings the server in
+ * turn when the stream is quiet and drops the connection if nothing comes
+ * back, which SSE has no way to notice. If the library cannot send pings,
+ * the stream goes without that check, like SSE. Needs a libcurl built with
+ * WebSocket support; isSupported() checks the library in use at runtime.
+ */
+class WebSocketTransport : public NotificationTransport
+{
+public:
+    // endpoint is appended to the server URI, whose http(s) scheme becomes ws(s)
+    explicit WebSocketTransport(std::string endpoint) : m_endpoint(std::move(endpoint)) {}
+
+    const char *name() const override { return "WebSocket"; }
+    bool isSupported() const override;
+    std::string streamUrl(const std::string &serverUri) const override;
+    void prepare(CURL *curl, struct curl_slist *&headers) override;
+    bool isEstablished(long responseCode) const override { return responseCode == 101; }
+    void consume(const char *data, size_t size, const EventCallback &onEvent) override;
+    bool keepAlive() override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    const std::string m_endpoint;
+    CURL *m_curl = nullptr;
+    std::string m_message;  // Text message being reassembled from fragments
+    bool m_binary = false;  // The message being received is binary and skipped
+    bool m_pingUnsupported = false; // Set for good once curl_ws_send() fails; no more pings
+    Clock::time_point m_lastReceived;
+    Clock::time_point m_pingSent; // Of the unanswered ping; epoch if none
+};
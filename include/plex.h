@@ -3,14 +3,19 @@
 // Standard library headers
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <iomanip>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <random>
+#include <set>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 // Platform-specific headers
@@ -24,18 +29,23 @@
 #include <nlohmann/json.hpp>
 
 // Project headers
+#include "api_client.h"
+#include "artwork_resolver.h"
+#include "cache.h"
+#include "cancellation_token.h"
 #include "config.h"
 #include "http_client.h"
 #include "logger.h"
+#include "lookup_cache.h"
 #include "models.h"
+#include "request_template.h"
+#include "server_connection.h"
+#include "single_flight.h"
+#include "timer_service.h"
+#include "timer_wheel.h"
 #include "uuid.h"
-
-// Forward declarations for cache structures
-struct TMDBCacheEntry;
-struct MALCacheEntry;
-struct MediaCacheEntry;
-struct SessionUserCacheEntry;
-struct ServerUriCacheEntry;
+#include "wake_signal.h"
+#include "worker_pool.h"
 
 class Plex
 {
@@ -52,25 +62,158 @@ public:
 	// Stop all connections
 	void stop();
 
+	// Wait until no session update started by an event is still running;
+	// returns false on timeout
+	bool waitForSessionWork(std::chrono::milliseconds timeout);
+
+	// Called after every change to the active sessions, with the session lock
+	// held; the callback must only signal another thread
+	using PlaybackChangedCallback = std::function<void()>;
+	void setPlaybackChangedCallback(PlaybackChangedCallback callback);
+
+	// Get hit ratio and memory use of the internal caches
+	std::vector<CacheStats> getCacheStats() const;
+
+	// List up to limit live keys of the named cache; false if there is no
+	// cache of that name
+	bool getCacheKeys(const std::string &cacheName, size_t limit, std::vector<std::string> &keys) const;
+
+	// Drop every cached lookup so the next use fetches it again
+	void clearCaches();
+
+	// Snapshot of every active session, in (server ID, session key) order
+	std::vector<MediaInfo> getActiveSessions();
+
+	// Connection state of one configured server
+	struct ServerStatus
+	{
+		std::string id;
+		std::string name;
+		std::string state; // "connected", "connecting", "deferred" or "stopped"
+		std::string activeUri;
+		std::vector<std::string> candidates;
+		bool failedOver = false;
+		bool owned = false;
+	};
+	std::vector<ServerStatus> getServerStatus();
+
+	// Check every server's sessions against the local table now;
+	// returns false if Plex is not initialized
+	bool resyncSessions();
+
 private:
 	// Helper methods
 	std::map<std::string, std::string> getStandardHeaders(const std::string &token = "");
 
+	// Base URL and prebuilt headers per (server URI, token), so requests to
+	// Plex servers don't rebuild their headers every time
+	std::mutex m_templateMutex;
+	std::map<std::string, std::string> m_standardHeaders;
+	std::map<std::pair<std::string, std::string>, std::shared_ptr<const RequestTemplate>> m_requestTemplates;
+	const std::map<std::string, std::string> &standardHeadersLocked();
+	std::shared_ptr<const RequestTemplate> requestTemplate(const std::string &serverUri, const std::string &token);
+
 	// State variables
 	std::atomic<bool> m_initialized;
 	std::atomic<bool> m_shuttingDown;
 
-	// Cache mutexes and maps
-	std::mutex m_cacheMutex;
-	std::map<std::string, TMDBCacheEntry> m_tmdbArtworkCache;
-	std::map<std::string, MALCacheEntry> m_malIdCache;
-	std::map<std::string, MediaCacheEntry> m_mediaInfoCache;
-	std::map<std::string, SessionUserCacheEntry> m_sessionUserCache;
-	std::map<std::string, ServerUriCacheEntry> m_serverUriCache;
+	// Notified by stop(): wakes the background loops and PIN polling and
+	// aborts in-flight requests of every HttpClient created with it
+	WakeSignal m_stopSignal;
 
-	// Active sessions
+	// Caches (bounded by Config::getCacheMemoryBudget)
+	LookupCache<std::string> m_tmdbArtworkCache;
+	LookupCache<std::string> m_malIdCache;
+	BoundedCache<std::shared_ptr<const MediaMetadata>> m_mediaInfoCache;
+	BoundedCache<std::string> m_serverUriCache;
+	ArtworkResolver m_artworkResolver;
+	void logCacheStats() const;
+
+	// Concurrent cache misses for the same key share one fetch
+	SingleFlight<std::string, std::shared_ptr<const MediaMetadata>> m_mediaInfoFlights{"media_info"};
+	// Lookup flights yield nothing when the caller running them was cancelled
+	SingleFlight<std::string, std::optional<Lookup<std::string>>> m_tmdbArtworkFlights{"tmdb_artwork"};
+	SingleFlight<std::string, std::optional<Lookup<std::string>>> m_malIdFlights{"mal_id"};
+
+	// Rate-limited third-party APIs, shared by all servers
+	ApiClient m_jikanClient;
+	ApiClient m_tmdbClient;
+
+	// Active sessions, keyed by (server ID, session key) since session keys
+	// are only unique within one server
+	using SessionId = std::pair<std::string, std::string>;
 	std::mutex m_sessionMutex;
-	std::map<std::string, MediaInfo> m_activeSessions;
+	std::map<SessionId, MediaInfo> m_activeSessions;
+	std::set<std::pair<time_t, SessionId>> m_sessionsByStart; // Selection order: newest start time last
+	std::map<SessionId, uint64_t> m_sessionLatestEvent;       // Sequence number of the newest event per session
+	uint64_t m_sessionEventSeq = 0;
+
+	// Fetches run on a pool of their own, since a rate-limited lookup can
+	// hold a thread for minutes and would starve the shared pool. Each
+	// session's fetches share a token that is cancelled when the session
+	// moves on to another item or stops, so work for what it used to play
+	// gives up instead of finishing late
+	struct SessionWork
+	{
+		std::string mediaKey;
+		CancellationToken cancel;
+	};
+	std::map<SessionId, SessionWork> m_sessionWork;
+	size_t m_sessionTasks = 0; // Fetches queued or running
+	std::condition_variable m_sessionTasksCv;
+	WorkerPool m_sessionPool{"session", 4};
+	void cancelSessionWorkLocked(std::map<SessionId, SessionWork>::iterator first,
+								 std::map<SessionId, SessionWork>::iterator last);
+
+	// Session shown in the presence, republished on every session change so
+	// getCurrentPlayback() reads it without taking m_sessionMutex
+	std::shared_ptr<const MediaInfo> m_currentSession;
+	PlaybackChangedCallback m_playbackChangedCallback;
+	void storeSessionLocked(const SessionId &id, const MediaInfo &info);
+	void eraseSessionLocked(const SessionId &id);
+	void publishCurrentSessionLocked();
+
+	// Session reconciliation: every event pushes the session's deadline out;
+	// an expired deadline, a (re)connected stream or the periodic pass has
+	// the server's /status/sessions checked against the local table
+	TimerWheel<SessionId> m_sessionTimers;
+	std::mutex m_reconcileMutex;
+	std::condition_variable m_reconcileCv;
+	std::set<std::string> m_pendingSweeps; // Servers whose stream just (re)connected
+	bool m_sessionExpiryDue = false;
+	bool m_reconcileAllDue = false;
+	TimerService::TimerId m_sessionExpiryTimer = 0;
+	TimerService::TimerId m_reconcileTimer = 0;
+	std::thread m_reconcileThread;
+	void sessionReconcileLoop();
+	void requestSessionSweep(const std::string &serverId);
+	void touchSession(const SessionId &id);
+	void armSessionExpiry();
+	void reconcileServerSessions(const std::string &serverId, const std::set<SessionId> &expired);
+
+	// Per-server connection health, keyed by server client identifier
+	std::mutex m_connectionMutex;
+	std::map<std::string, std::shared_ptr<ServerConnection>> m_serverConnections;
+
+	// Background loops: fail-back probing of better-ranked URIs and of
+	// servers that were offline at startup, and refreshing the server list
+	// from plex.tv
+	std::thread m_failbackThread;
+	std::thread m_resourceRefreshThread;
+
+	// Startup bring-up: every server is probed and connected in parallel,
+	// servers without a reachable URI are retried by the fail-back loop
+	std::mutex m_bringUpMutex;
+	std::chrono::steady_clock::time_point m_bringUpStart;
+	std::set<std::string> m_pendingStreams;  // Started at startup, not connected yet
+	std::set<std::string> m_deferredServers; // No reachable URI yet
+	size_t m_bringUpServerCount = 0;
+	bool m_bringUpReported = true;
+
+	// Validators from the last plex.tv resources response
+	std::string m_resourcesEtag;
+	std::string m_resourcesLastModified;
+	size_t m_resourcesHash = 0;
 
 	// Authentication methods
 	bool acquireAuthToken();
@@ -86,35 +229,55 @@ private:
 	// Server methods
 	bool fetchServers();
 	bool parseServerJson(const std::string &jsonStr);
+	bool parseServerResources(const std::string &jsonStr, std::map<std::string, std::shared_ptr<PlexServer>> &servers);
+	bool fetchServerResources(std::string &response, bool conditional);
+	void refreshServers();
+	void resourceRefreshLoop();
+	void applyServerChanges(const std::map<std::string, std::shared_ptr<PlexServer>> &servers);
+	void forgetServer(const std::string &serverId);
 	void setupServerConnections();
-	void setupServerSSEConnection(const std::shared_ptr<PlexServer> &server);
+	void bringUpServers(const std::vector<std::shared_ptr<PlexServer>> &servers);
+	bool setupServerSSEConnection(const std::shared_ptr<PlexServer> &server);
+	void retryDeferredServers();
+	void markStreamConnected(const std::string &serverId);
+	void deferServer(const std::shared_ptr<PlexServer> &server);
+	void reportBringUpLocked();
+	void stopServerSSEConnection(const std::shared_ptr<PlexServer> &server);
 
 	// Event handling methods
 	void handleSSEEvent(const std::string &serverId, const std::string &event);
 	void processPlaySessionStateNotification(const std::string &serverId, const nlohmann::json &notification);
 	void updateSessionInfo(const std::string &serverId, const std::string &sessionKey,
 						   const std::string &state, const std::string &mediaKey,
-						   int64_t viewOffset, const std::shared_ptr<PlexServer> &server);
-	void updatePlaybackState(MediaInfo &info, const std::string &state, int64_t viewOffset);
+						   int64_t viewOffset, const std::shared_ptr<PlexServer> &server,
+						   uint64_t eventSeq, const CancellationToken &cancel);
+	void updatePlaybackState(PlaybackStatus &status, const std::string &state, int64_t viewOffset);
 	std::string urlEncode(const std::string &value);
 
 	// Media info methods
-	void buildArtworkUrl(MediaInfo &info, const std::string &serverUri, const std::string &accessToken);
-	MediaInfo fetchMediaDetails(const std::string &serverUri, const std::string &accessToken,
-								const std::string &mediaKey);
-	void extractBasicMediaInfo(const nlohmann::json &metadata, MediaInfo &info);
-	void extractMovieSpecificInfo(const nlohmann::json &metadata, MediaInfo &info, const std::string &serverUri, const std::string &accessToken);
-	void extractTVShowSpecificInfo(const nlohmann::json &metadata, MediaInfo &info);
+	void buildArtworkUrl(MediaMetadata &info, const std::string &serverUri, const std::string &accessToken);
+	std::shared_ptr<const MediaMetadata> fetchMediaDetails(const std::string &serverUri, const std::string &accessToken,
+														   const std::string &mediaKey, const CancellationToken &cancel);
+	void extractBasicMediaInfo(const nlohmann::json &metadata, MediaMetadata &info);
+	void extractMovieSpecificInfo(const nlohmann::json &metadata, MediaMetadata &info, const std::string &serverUri, const std::string &accessToken,
+								  const CancellationToken &cancel);
+	void extractTVShowSpecificInfo(const nlohmann::json &metadata, MediaMetadata &info);
 	void fetchGrandparentMetadata(const std::string &serverUrl, const std::string &accessToken,
-								  MediaInfo &info);
-	void parseGuid(const nlohmann::json &metadata, MediaInfo &info, const std::string &serverUri, const std::string &accessToken);
-	void parseGenres(const nlohmann::json &metadata, MediaInfo &info);
+								  MediaMetadata &info, const CancellationToken &cancel);
+	void parseGuid(const nlohmann::json &metadata, MediaMetadata &info, const std::string &serverUri, const std::string &accessToken,
+				   const CancellationToken &cancel);
+	void parseGenres(const nlohmann::json &metadata, MediaMetadata &info, const CancellationToken &cancel);
 	bool isAnimeContent(const nlohmann::json &metadata);
-	void fetchAnimeMetadata(const nlohmann::json &metadata, MediaInfo &info);
-	void fetchTMDBArtwork(const std::string &tmdbId, MediaInfo &info, const std::string &serverUri, const std::string &plexAccessToken);
+	void fetchAnimeMetadata(const nlohmann::json &metadata, MediaMetadata &info, const CancellationToken &cancel);
+	LookupStatus fetchTMDBArtwork(const std::string &tmdbId, MediaType type, std::string &artPath, const CancellationToken &cancel);
 	std::string fetchSessionUsername(const std::string &serverUri, const std::string &accessToken,
 									 const std::string &sessionKey);
 	std::string getPreferredServerUri(const std::shared_ptr<PlexServer> &server);
-	void extractMusicSpecificInfo(const nlohmann::json &metadata, MediaInfo &info,
-								  const std::string &serverUri, const std::string &accessToken, const std::string &serverId);
+	std::shared_ptr<ServerConnection> getServerConnection(const std::shared_ptr<PlexServer> &server);
+	void reportServerFailure(const std::shared_ptr<PlexServer> &server);
+	bool probeServerUri(const std::string &uri, const std::string &accessToken);
+	void failbackLoop();
+	void extractMusicSpecificInfo(const nlohmann::json &metadata, MediaMetadata &info,
+								  const std::string &serverUri, const std::string &accessToken,
+								  const CancellationToken &cancel);
 };
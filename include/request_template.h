@@ -0,0 +1,49 @@
+#pragma once
+
+// Standard library headers
+#include <map>
+#include <string>
+
+// Third-party headers
+#include <curl/curl.h>
+
+/**
+ * @class RequestTemplate
+ * @brief Immutable base URL and headers shared by every request to one server
+ *
+ * The curl header list is built once, so a request made from a template
+ * costs no header map copies and no string concatenation. curl only reads
+ * the list, so one template can serve requests on any number of threads;
+ * hold it through a shared_ptr for as long as a request uses it.
+ */
+class RequestTemplate
+{
+public:
+    RequestTemplate(std::string baseUrl, std::map<std::string, std::string> headers)
+        : m_baseUrl(std::move(baseUrl)), m_headers(std::move(headers))
+    {
+        for (const auto &[name, value] : m_headers)
+        {
+            m_headerList = curl_slist_append(m_headerList, (name + ": " + value).c_str());
+        }
+    }
+
+    ~RequestTemplate()
+    {
+        curl_slist_free_all(m_headerList);
+    }
+
+    RequestTemplate(const RequestTemplate &) = delete;
+    RequestTemplate &operator=(const RequestTemplate &) = delete;
+
+    const std::string &baseUrl() const { return m_baseUrl; }
+    const std::map<std::string, std::string> &headers() const { return m_headers; }
+
+    // CURLOPT_HTTPHEADER takes a non-const list but never modifies it
+    struct curl_slist *headerList() const { return m_headerList; }
+
+private:
+    const std::string m_baseUrl;
+    const std::map<std::string, std::string> m_headers;
+    struct curl_slist *m_headerList = nullptr;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+// Standard library headers
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @class ServerConnection
+ * @brief Tracks the health of a Plex server's candidate URIs and picks the active one
+ *
+ * Candidates are kept in preference order. Once the active URI has failed
+ * MAX_CONSECUTIVE_ERRORS times in a row the connection fails over to the next
+ * candidate. Candidates ranked above the active one can be probed periodically
+ * so the connection fails back once they become reachable again.
+ */
+class ServerConnection
+{
+public:
+    /**
+     * @brief Number of consecutive errors tolerated before failing over
+     */
+    static constexpr int MAX_CONSECUTIVE_ERRORS = 3;
+
+    /**
+     * @brief Create a connection from a ranked list of candidate URIs
+     * @param candidates Candidate URIs, most preferred first (empty entries are dropped)
+     */
+    explicit ServerConnection(const std::vector<std::string> &candidates);
+
+    /**
+     * @brief Get the URI currently in use
+     * @return Active URI, or an empty string if none has been selected yet
+     */
+    std::string activeUri() const;
+
+    /**
+     * @brief Select a candidate as the active URI and reset its error count
+     * @param uri The candidate to activate
+     * @return True if the active URI changed
+     */
+    bool setActive(const std::string &uri);
+
+    /**
+     * @brief Record a failed request against the active URI
+     * @return True if this failure caused a failover to another candidate
+     */
+    bool reportFailure();
+
+    /**
+     * @brief Record a successful request against the active URI
+     */
+    void reportSuccess();
+
+    /**
+     * @brief Get the candidates ranked above the active URI
+     * @return Better candidates in preference order (empty if already on the best one)
+     */
+    std::vector<std::string> betterCandidates() const;
+
+    /**
+     * @brief Get all candidates in preference order
+     */
+    const std::vector<std::string> &candidates() const;
+
+    /**
+     * @brief Check whether the active URI is not the most preferred candidate
+     */
+    bool isFailedOver() const;
+
+private:
+    const std::vector<std::string> m_candidates;
+    size_t m_activeIndex;
+    bool m_hasActive;
+    int m_consecutiveErrors;
+    mutable std::mutex m_mutex;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+// Standard library headers
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+
+/**
+ * @class SingleFlight
+ * @brief Collapses concurrent calls for the same key into one execution
+ *
+ * The first caller for a key runs the fetch; callers arriving while it is in
+ * flight wait on the same shared result instead of repeating the work. Once
+ * the fetch completes the key is forgotten, so later callers start a new one
+ * (put the result in a cache to avoid that).
+ *
+ * @tparam Key Key type; must be ordered
+ * @tparam Value Result type; must be copyable
+ */
+template <typename Key, typename Value>
+class SingleFlight
+{
+public:
+    explicit SingleFlight(std::string name) : m_name(std::move(name)) {}
+
+    SingleFlight(const SingleFlight &) = delete;
+    SingleFlight &operator=(const SingleFlight &) = delete;
+
+    /**
+     * @brief Run fetch for key, or wait for the run already in flight
+     * @return The fetch result; exceptions thrown by fetch reach every waiter
+     */
+    Value run(const Key &key, const std::function<Value()> &fetch)
+    {
+        std::promise<Value> promise;
+        std::shared_future<Value> pending;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_inFlight.find(key);
+            if (it != m_inFlight.end())
+            {
+                pending = it->second;
+                ++m_collapsed;
+            }
+            else
+            {
+                m_inFlight.emplace(key, promise.get_future().share());
+            }
+        }
+
+        if (pending.valid())
+        {
+            return pending.get();
+        }
+
+        try
+        {
+            Value value = fetch();
+            promise.set_value(value);
+            forget(key);
+            return value;
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+            forget(key);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Number of calls that waited on another caller's fetch
+     */
+    uint64_t collapsed() const { return m_collapsed.load(); }
+
+    const std::string &name() const { return m_name; }
+
+private:
+    void forget(const Key &key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_inFlight.erase(key);
+    }
+
+    const std::string m_name;
+    std::mutex m_mutex;
+    std::map<Key, std::shared_future<Value>> m_inFlight;
+    std::atomic<uint64_t> m_collapsed{0};
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+// Standard library headers
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+
+/**
+ * @class InternedString
+ * @brief Handle to a string stored once in the process-wide StringPool
+ *
+ * Copying a handle copies a pointer, never the characters. Interned strings
+ * live for the rest of the process, so only intern values drawn from a small
+ * set (genres, client names, server IDs, resolutions, usernames, ...).
+ */
+class InternedString
+{
+public:
+    InternedString();
+    explicit InternedString(std::string_view value);
+
+    const std::string &str() const { return *m_value; }
+    const char *c_str() const { return m_value->c_str(); }
+    bool empty() const { return m_value->empty(); }
+
+    // Interned strings are unique, so equality is pointer identity
+    bool operator==(const InternedString &other) const { return m_value == other.m_value; }
+    bool operator!=(const InternedString &other) const { return m_value != other.m_value; }
+    bool operator==(std::string_view other) const { return *m_value == other; }
+    bool operator!=(std::string_view other) const { return *m_value != other; }
+
+private:
+    const std::string *m_value;
+};
+
+/**
+ * @class StringPool
+ * @brief Singleton set of unique strings backing InternedString
+ */
+class StringPool
+{
+public:
+    static StringPool &getInstance()
+    {
+        static StringPool instance;
+        return instance;
+    }
+
+    /**
+     * @brief Get the pooled copy of a string, adding it if needed
+     * @param value String to intern; looking up an existing value does not allocate
+     * @return Pointer that stays valid for the lifetime of the process
+     */
+    const std::string *intern(std::string_view value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_strings.find(value);
+        if (it == m_strings.end())
+        {
+            it = m_strings.emplace(value).first;
+        }
+        return &*it;
+    }
+
+    /**
+     * @brief Get the number of distinct strings in the pool
+     */
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_strings.size();
+    }
+
+private:
+    StringPool() = default;
+    StringPool(const StringPool &) = delete;
+    StringPool &operator=(const StringPool &) = delete;
+
+    mutable std::mutex m_mutex;
+    std::set<std::string, std::less<>> m_strings;
+};
+
+inline InternedString::InternedString() : m_value(StringPool::getInstance().intern(""))
+{
+}
+
+inline InternedString::InternedString(std::string_view value) : m_value(StringPool::getInstance().intern(value))
+{
+}
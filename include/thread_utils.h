@@ -4,13 +4,19 @@
 #include <future>
 #include <chrono>
 #include <functional>
+#include <type_traits>
+#include "cancellation_token.h"
 #include "logger.h"
+#include "worker_pool.h"
 
 namespace ThreadUtils {
 
 /**
  * Join a thread with timeout
- * 
+ *
+ * The join runs on a WorkerPool thread. If it times out, that join is still
+ * pending, so the thread object must stay alive until the thread exits.
+ *
  * @param thread The thread to join
  * @param timeout Timeout duration
  * @param threadName Name for logging
@@ -20,25 +26,30 @@ inline bool joinWithTimeout(std::thread& thread, std::chrono::milliseconds timeo
     if (!thread.joinable()) {
         return true;
     }
-    
-    // Create a future to track the join operation
-    auto joinFuture = std::async(std::launch::async, [&thread]() {
+
+    auto joinFuture = WorkerPool::getInstance().submit([&thread]() {
         thread.join();
     });
-    
-    // Wait for the join operation with timeout
+
     if (joinFuture.wait_for(timeout) == std::future_status::timeout) {
-        LOG_WARNING("ThreadUtils", "Thread '" + threadName + "' join timed out after " + 
+        LOG_WARNING("ThreadUtils", "Thread '" + threadName + "' join timed out after " +
                    std::to_string(timeout.count()) + "ms");
         return false;
     }
-    
+
     return true;
 }
 
 /**
  * Execute a function with timeout
- * 
+ *
+ * The function runs on the WorkerPool. If it takes longer than the timeout
+ * the caller stops waiting and the function's CancellationToken is
+ * cancelled; a function taking a const CancellationToken& should check it
+ * and return early. Functions without that parameter simply finish in the
+ * background. Called from a pool worker, the function runs inline instead,
+ * so a full pool cannot deadlock on itself.
+ *
  * @param func Function to execute
  * @param timeout Timeout duration
  * @param operationName Name for logging
@@ -46,14 +57,28 @@ inline bool joinWithTimeout(std::thread& thread, std::chrono::milliseconds timeo
  */
 template<typename Func>
 inline bool executeWithTimeout(Func func, std::chrono::milliseconds timeout, const std::string& operationName) {
-    auto future = std::async(std::launch::async, func);
-    
+    CancellationToken token;
+    auto run = [func, token]() {
+        if constexpr (std::is_invocable_v<Func, const CancellationToken&>) {
+            func(token);
+        } else {
+            func();
+        }
+    };
+
+    if (WorkerPool::getInstance().isWorkerThread()) {
+        run();
+        return true;
+    }
+
+    auto future = WorkerPool::getInstance().submit(run);
     if (future.wait_for(timeout) == std::future_status::timeout) {
-        LOG_WARNING("ThreadUtils", "Operation '" + operationName + "' timed out after " + 
+        token.cancel();
+        LOG_WARNING("ThreadUtils", "Operation '" + operationName + "' timed out after " +
                    std::to_string(timeout.count()) + "ms");
         return false;
     }
-    
+
     return true;
 }
 
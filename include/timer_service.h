@@ -0,0 +1,119 @@
+#pragma once
+
+// Standard library headers
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+
+/**
+ * @brief Wakeup counters of the TimerService
+ */
+struct TimerStats
+{
+    size_t pending = 0;        // Timers currently scheduled
+    uint64_t fired = 0;        // Callbacks run
+    uint64_t wakeups = 0;      // Times the timer thread woke up on a deadline
+    uint64_t idleWakeups = 0;  // Deadline wakeups that found nothing to run
+    double wakeupsPerSecond = 0;
+    double idleWakeupsPerSecond = 0;
+};
+
+/**
+ * @class TimerService
+ * @brief Singleton running every timed callback of the process on one thread
+ *
+ * Each timer may fire anywhere between its deadline and its deadline plus
+ * slack. The thread sleeps until the earliest such latest time and then runs
+ * every timer whose deadline has passed, so timers that are close together
+ * share a wakeup. Nothing wakes the thread while no timer is due.
+ *
+ * Callbacks run on the timer thread and must not block for long; hand slow
+ * work to another thread.
+ */
+class TimerService
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+    static TimerService &getInstance();
+
+    /**
+     * @brief Run callback once after delay
+     * @param slack How late the callback may run; negative picks the default
+     *              policy of 5% of the delay, between 1 ms and 5 s
+     * @return Id for cancel(); never 0
+     */
+    TimerId schedule(Clock::duration delay, Callback callback,
+                     Clock::duration slack = Clock::duration(-1));
+
+    /**
+     * @brief Run callback every interval until cancelled
+     */
+    TimerId scheduleRepeating(Clock::duration interval, Callback callback,
+                              Clock::duration slack = Clock::duration(-1));
+
+    /**
+     * @brief Cancel a timer; cancelling id 0 does nothing
+     *
+     * If the callback is running on the timer thread, waits for it to return
+     * (unless called from the callback itself), so objects it uses can be
+     * destroyed once cancel() returns.
+     * @return True if the timer was still scheduled
+     */
+    bool cancel(TimerId id);
+
+    TimerStats stats() const;
+
+    /**
+     * @brief Stop the timer thread; pending timers never fire
+     */
+    void shutdown();
+
+private:
+    TimerService();
+    ~TimerService();
+    TimerService(const TimerService &) = delete;
+    TimerService &operator=(const TimerService &) = delete;
+
+    struct Timer
+    {
+        Clock::time_point deadline;
+        Clock::duration slack;
+        Clock::duration interval; // Zero for one-shot timers
+        Callback callback;
+    };
+
+    TimerId add(Clock::duration delay, Clock::duration interval, Callback callback, Clock::duration slack);
+    void insertLocked(TimerId id, Timer timer);
+    void eraseLocked(std::map<TimerId, Timer>::iterator it);
+    void run();
+    static Clock::duration defaultSlack(Clock::duration delay);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::condition_variable m_callbackDone;
+    std::map<TimerId, Timer> m_timers;
+    std::set<std::pair<Clock::time_point, TimerId>> m_byDeadline;
+    std::set<std::pair<Clock::time_point, TimerId>> m_byLatest; // deadline + slack
+    std::set<TimerId> m_batch;                                  // Due in the current wakeup, not run yet
+    TimerId m_nextId = 1;
+    TimerId m_runningId = 0;
+    bool m_stopping = false;
+    bool m_changed = false;
+    std::thread m_thread;
+    std::thread::id m_threadId;
+
+    const Clock::time_point m_started;
+    uint64_t m_fired = 0;
+    uint64_t m_wakeups = 0;
+    uint64_t m_idleWakeups = 0;
+};
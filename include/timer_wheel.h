@@ -0,0 +1,149 @@
+#pragma once
+
+// Standard library headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/**
+ * @class TimerWheel
+ * @brief Hashed timing wheel holding one deadline per key
+ *
+ * Deadlines are rounded up to whole ticks and hashed into a fixed ring of
+ * slots, so scheduling, rescheduling and cancelling are O(log n) in the
+ * number of keys and advancing only looks at the slots that passed. Deadlines
+ * further away than one turn of the wheel stay in their slot until the wheel
+ * comes round to the right turn.
+ *
+ * @tparam Key Timer key type; must be ordered and copyable
+ */
+template <typename Key>
+class TimerWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TimerWheel(Clock::duration tick, size_t slotCount)
+        : m_tick(tick), m_origin(Clock::now()), m_slots(slotCount)
+    {
+    }
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    /**
+     * @brief Set the deadline for key, replacing any earlier one
+     */
+    void schedule(const Key &key, Clock::duration delay)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        cancelLocked(key);
+
+        // Round up so a timer never fires before its delay has passed
+        uint64_t ticks = static_cast<uint64_t>((delay + m_tick - Clock::duration(1)) / m_tick);
+        uint64_t expiryTick = tickAt(Clock::now()) + (std::max)(ticks, uint64_t{1});
+        auto &slot = m_slots[expiryTick % m_slots.size()];
+        slot.push_back({key, expiryTick});
+        m_timers.emplace(key, std::prev(slot.end()));
+    }
+
+    /**
+     * @brief Remove the deadline for key
+     * @return True if key had a deadline
+     */
+    bool cancel(const Key &key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return cancelLocked(key);
+    }
+
+    /**
+     * @brief Move the wheel forward to now and remove every expired timer
+     * @return Keys whose deadline has passed
+     */
+    std::vector<Key> advance(Clock::time_point now = Clock::now())
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<Key> expired;
+        uint64_t target = tickAt(now);
+
+        // After a long gap one turn of the wheel visits every slot anyway
+        if (target > m_currentTick + m_slots.size())
+        {
+            m_currentTick = target - m_slots.size();
+        }
+
+        while (m_currentTick < target)
+        {
+            ++m_currentTick;
+            auto &slot = m_slots[m_currentTick % m_slots.size()];
+            for (auto it = slot.begin(); it != slot.end();)
+            {
+                if (it->expiryTick <= target)
+                {
+                    expired.push_back(it->key);
+                    m_timers.erase(it->key);
+                    it = slot.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+        return expired;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto &slot : m_slots)
+        {
+            slot.clear();
+        }
+        m_timers.clear();
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_timers.size();
+    }
+
+private:
+    struct Timer
+    {
+        Key key;
+        uint64_t expiryTick;
+    };
+    using Slot = std::list<Timer>;
+
+    uint64_t tickAt(Clock::time_point time) const
+    {
+        return time <= m_origin ? 0 : static_cast<uint64_t>((time - m_origin) / m_tick);
+    }
+
+    bool cancelLocked(const Key &key)
+    {
+        auto it = m_timers.find(key);
+        if (it == m_timers.end())
+        {
+            return false;
+        }
+        m_slots[it->second->expiryTick % m_slots.size()].erase(it->second);
+        m_timers.erase(it);
+        return true;
+    }
+
+    const Clock::duration m_tick;
+    const Clock::time_point m_origin;
+    mutable std::mutex m_mutex;
+    std::vector<Slot> m_slots;
+    std::map<Key, typename Slot::iterator> m_timers;
+    uint64_t m_currentTick = 0;
+};
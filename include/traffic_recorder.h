@@ -0,0 +1,197 @@
+#pragma once
+
+// Standard library headers
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Project headers
+#include "latency_tracker.h"
+
+/**
+ * @brief One captured HTTP exchange
+ */
+struct RecordedExchange
+{
+    std::chrono::microseconds start{0};    // Since the capture started
+    std::chrono::microseconds duration{0}; // Until the response was complete
+    long status = 0;                       // 0 if no response was received
+    std::string body;
+};
+
+/**
+ * @brief One captured SSE event
+ */
+struct RecordedEvent
+{
+    std::chrono::microseconds time{0}; // Since the capture started
+    std::string data;
+};
+
+/**
+ * @brief Server known when the capture started; with the username it lets
+ *        a replay run without any config
+ */
+struct RecordedServer
+{
+    std::string name;
+    std::string clientIdentifier;
+    std::string localUri;
+    std::string publicUri;
+    bool owned = false;
+};
+
+/**
+ * @class TrafficRecorder
+ * @brief Singleton writing SSE events and HTTP exchanges to a capture file
+ *
+ * The file has one JSON object per line: a header with the Plex username
+ * and the configured servers, then "http" and "sse" records in the order they completed.
+ * Tokens are replaced by REDACTED before anything is written, in URLs as
+ * well as in bodies, so a capture can be shared. Request headers are not
+ * recorded at all.
+ */
+class TrafficRecorder
+{
+public:
+    static constexpr const char *REDACTED = "REDACTED";
+
+    static TrafficRecorder &getInstance();
+
+    /**
+     * @brief Replace every token in text by REDACTED
+     *
+     * Covers X-Plex-Token query parameters and token fields in JSON and XML.
+     */
+    static std::string scrub(const std::string &text);
+
+    /**
+     * @brief Start writing to path, replacing the file
+     * @return false if the file cannot be opened
+     */
+    bool start(const std::string &path, const std::string &username, const std::vector<RecordedServer> &servers);
+    void stop();
+
+    bool isRecording() const { return m_recording.load(std::memory_order_relaxed); }
+
+    // Time since start(), for the start of an exchange
+    std::chrono::microseconds now() const;
+
+    void recordExchange(const std::string &method, const std::string &url, std::chrono::microseconds start,
+                        long status, const std::string &body);
+    void recordEvent(const std::string &url, const std::string &data);
+
+private:
+    TrafficRecorder() = default;
+    ~TrafficRecorder();
+    TrafficRecorder(const TrafficRecorder &) = delete;
+    TrafficRecorder &operator=(const TrafficRecorder &) = delete;
+
+    void writeLine(const std::string &line);
+
+    std::atomic<bool> m_recording{false};
+    std::chrono::steady_clock::time_point m_start;
+    std::mutex m_mutex;
+    std::ofstream m_file;
+    uint64_t m_records = 0;
+};
+
+/**
+ * @class TrafficReplay
+ * @brief Singleton serving a capture file in place of the network
+ *
+ * While active, HttpClient answers requests from the capture instead of
+ * the network and its SSE streams deliver the captured events. Exchanges
+ * are matched on method and scrubbed URL and handed out in capture order;
+ * the last one is repeated for requests made more often than captured.
+ * Captured timing is kept, divided by the speed: responses take their
+ * captured duration, events arrive at their captured time after the
+ * replay started. At speed 0 nothing waits.
+ */
+class TrafficReplay
+{
+public:
+    static TrafficReplay &getInstance();
+
+    /**
+     * @brief Load a capture file and start the replay clock
+     * @param speed Replay speed factor; 0 replays as fast as possible
+     * @return false if the file cannot be read
+     */
+    bool load(const std::string &path, double speed);
+
+    bool isActive() const { return m_active.load(std::memory_order_relaxed); }
+    double speed() const { return m_speed; }
+
+    const std::string &username() const { return m_username; }
+    const std::vector<RecordedServer> &servers() const { return m_servers; }
+
+    /**
+     * @brief Find the next captured exchange for a request
+     * @return false if the capture has none for this request
+     */
+    bool takeExchange(const std::string &method, const std::string &url, RecordedExchange &exchange);
+
+    /**
+     * @brief Take all captured events of an SSE stream
+     *
+     * Each stream is handed out once; a reconnect gets no events again.
+     * @return false if the capture has no stream for this URL
+     */
+    bool takeEvents(const std::string &url, std::vector<RecordedEvent> &events);
+
+    /**
+     * @brief Replay-clock delay until a captured point in time
+     */
+    std::chrono::microseconds delayUntil(std::chrono::microseconds captured) const;
+
+    /**
+     * @brief Scale a captured duration by the replay speed
+     */
+    std::chrono::microseconds scaled(std::chrono::microseconds captured) const;
+
+    // Called by the SSE replay after each delivered event
+    void eventDelivered(std::chrono::microseconds handlingTime);
+
+    /**
+     * @brief Wait until every captured event was delivered
+     * @return false on timeout
+     */
+    bool waitForEvents(std::chrono::milliseconds timeout);
+
+    size_t totalEvents() const { return m_totalEvents; }
+    std::chrono::microseconds lastEventTime() const { return m_lastEvent; }
+    size_t deliveredEvents() const;
+    size_t unmatchedRequests() const;
+
+    // Per-event time spent in the SSE event callback
+    std::chrono::microseconds handlingPercentile(double quantile) const;
+
+private:
+    TrafficReplay() = default;
+    TrafficReplay(const TrafficReplay &) = delete;
+    TrafficReplay &operator=(const TrafficReplay &) = delete;
+
+    std::atomic<bool> m_active{false};
+    double m_speed = 1.0;
+    std::chrono::steady_clock::time_point m_start;
+    std::string m_username;
+    std::vector<RecordedServer> m_servers;
+    size_t m_totalEvents = 0;
+    std::chrono::microseconds m_lastEvent{0};
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_eventsCv;
+    std::map<std::string, std::deque<RecordedExchange>> m_exchanges; // Key: method and scrubbed URL
+    std::map<std::string, std::vector<RecordedEvent>> m_events;      // Key: scrubbed SSE URL
+    LatencyHistogram m_handling;
+    size_t m_delivered = 0;
+    size_t m_unmatched = 0;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+// Standard library headers
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+
+/**
+ * @class WakeSignal
+ * @brief Sticky signal that interrupts every kind of blocking wait at once
+ *
+ * Once notified the signal stays set until reset(). Threads can sleep on it
+ * with waitFor(), poll() its file descriptor alongside their own sockets
+ * (POSIX), or register a listener that knows how to interrupt a wait the
+ * signal cannot see directly, such as curl_multi_wakeup for a transfer or
+ * CancelIoEx for a blocking pipe read.
+ */
+class WakeSignal
+{
+public:
+    using Listener = std::function<void()>;
+
+    WakeSignal();
+    ~WakeSignal();
+
+    WakeSignal(const WakeSignal &) = delete;
+    WakeSignal &operator=(const WakeSignal &) = delete;
+
+    /**
+     * @brief Set the signal and wake every waiter and listener
+     */
+    void notify();
+
+    /**
+     * @brief Clear the signal so it can be used again
+     */
+    void reset();
+
+    bool isSet() const { return m_set.load(); }
+
+    /**
+     * @brief Sleep until the signal is set or the timeout passes
+     * @return true if the signal is set
+     */
+    bool waitFor(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Register a callback run on every notify()
+     *
+     * Runs immediately if the signal is already set, so a wait that starts
+     * after notify() is still interrupted.
+     * @return Id to pass to removeListener()
+     */
+    size_t addListener(Listener listener);
+    void removeListener(size_t id);
+
+#ifndef _WIN32
+    /**
+     * @brief Descriptor that is readable while the signal is set, for poll()
+     */
+    int fd() const { return m_pipe[0]; }
+#endif
+
+private:
+    std::atomic<bool> m_set{false};
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::map<size_t, Listener> m_listeners;
+    size_t m_nextListenerId = 0;
+#ifndef _WIN32
+    int m_pipe[2] = {-1, -1};
+#endif
+};
+
+/**
+ * @brief Keeps a WakeSignal listener registered for the lifetime of a scope
+ */
+class WakeListenerGuard
+{
+public:
+    WakeListenerGuard(WakeSignal *signal, WakeSignal::Listener listener)
+        : m_signal(signal), m_id(signal ? signal->addListener(std::move(listener)) : 0)
+    {
+    }
+
+    ~WakeListenerGuard()
+    {
+        if (m_signal)
+        {
+            m_signal->removeListener(m_id);
+        }
+    }
+
+    WakeListenerGuard(const WakeListenerGuard &) = delete;
+    WakeListenerGuard &operator=(const WakeListenerGuard &) = delete;
+
+private:
+    WakeSignal *m_signal;
+    size_t m_id;
+};
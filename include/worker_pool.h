@@ -0,0 +1,118 @@
+#pragma once
+
+// Standard library headers
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Queue and throughput counters of the WorkerPool
+ */
+struct WorkerPoolStats
+{
+    size_t threads = 0;
+    size_t queued = 0;    // Tasks waiting for a worker right now
+    size_t maxQueued = 0; // Highest queue depth seen
+    uint64_t executed = 0; // Tasks started
+    uint64_t stolen = 0; // Tasks run by a worker other than the one they were queued on
+};
+
+/**
+ * @class WorkerPool
+ * @brief Pool of a few named worker threads for background jobs
+ *
+ * Every worker owns a deque. Tasks submitted from a worker go to the back of
+ * its own deque and are taken from there (newest first, while their data is
+ * still warm); tasks from other threads are spread round-robin. A worker
+ * whose deque is empty steals the oldest task from another worker before it
+ * goes to sleep.
+ *
+ * Tasks that block for long (network probes, thread joins) tie up a worker,
+ * so long-running loops keep their own threads. The shared instance is for
+ * short jobs; work that may block for minutes gets a pool of its own.
+ */
+class WorkerPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // The shared pool for short jobs
+    static WorkerPool &getInstance();
+
+    /**
+     * @brief Start a private pool
+     * @param name Prefix of the thread names
+     * @param threads Number of workers, at least one
+     */
+    WorkerPool(const std::string &name, size_t threads);
+    ~WorkerPool();
+
+    /**
+     * @brief Queue func and get a future for its result
+     *
+     * Unlike a std::async future, destroying the returned future never waits
+     * for the task.
+     */
+    template <typename Func>
+    std::future<std::invoke_result_t<Func>> submit(Func func)
+    {
+        using Result = std::invoke_result_t<Func>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+        auto future = task->get_future();
+        post([task]()
+             { (*task)(); });
+        return future;
+    }
+
+    /**
+     * @brief Queue a task whose result nobody waits for
+     */
+    void post(Task task);
+
+    /**
+     * @brief Whether the calling thread is one of this pool's workers
+     */
+    bool isWorkerThread() const;
+
+    WorkerPoolStats stats() const;
+
+    /**
+     * @brief Run the queued tasks, then stop the workers
+     */
+    void shutdown();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+private:
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void workerLoop(size_t index, const std::string &threadName);
+    bool popLocal(size_t index, Task &task);
+    bool steal(size_t index, Task &task);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCv;
+    std::atomic<size_t> m_queued{0};
+    std::atomic<size_t> m_maxQueued{0};
+    std::atomic<size_t> m_nextWorker{0};
+    std::atomic<uint64_t> m_executed{0};
+    std::atomic<uint64_t> m_stolen{0};
+    bool m_stopping = false;
+};
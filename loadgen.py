@@ -0,0 +1,511 @@
+#!/usr/bin/env python3
+"""
+Synthetic Load Generator
+Runs Presence For Plex against N fake Plex servers with M playing sessions each
+and reports how it copes: CPU, memory, event-processing latency and the rate of
+requests it sends back to the servers.
+
+Everything runs locally: the fake servers listen on 127.0.0.1, a fake Discord
+client answers on a private IPC socket, and the binary gets a scratch config.
+
+Event-processing latency is measured on sessions owned by the configured user:
+every few events such a session moves on to a new item, and the time from that
+SSE event to the binary fetching the new item's metadata is recorded.
+"""
+
+import argparse
+import heapq
+import itertools
+import json
+import os
+import random
+import shutil
+import signal
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+USERNAME = "loadgen"
+CLOCK_TICKS = os.sysconf("SC_CLK_TCK") if hasattr(os, "sysconf") else 100
+
+
+class QuietHTTPServer(ThreadingHTTPServer):
+    """Drops the traceback of clients that hang up, which the binary does on every stop."""
+
+    daemon_threads = True
+
+    def handle_error(self, request, client_address):
+        if not isinstance(sys.exc_info()[1], (ConnectionError, TimeoutError)):
+            super().handle_error(request, client_address)
+
+
+class Stats:
+    """Counters shared by all fake servers of one run."""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        with self.lock:
+            self.requests = {}
+            self.events = 0
+            self.pending = {}  # metadata path -> time the new item was announced
+            self.latencies = []
+
+    def count_request(self, category):
+        with self.lock:
+            self.requests[category] = self.requests.get(category, 0) + 1
+
+    def event_sent(self, new_item_path=None):
+        with self.lock:
+            self.events += 1
+            if new_item_path:
+                self.pending[new_item_path] = time.monotonic()
+
+    def metadata_requested(self, path):
+        with self.lock:
+            sent = self.pending.pop(path, None)
+            if sent is not None:
+                self.latencies.append(time.monotonic() - sent)
+
+
+class Session:
+    def __init__(self, key, owned, rating_key):
+        self.key = key
+        self.owned = owned
+        self.rating_key = rating_key
+        self.offset = random.randint(0, 3_000_000)
+        self.events = 0
+
+
+class FakePlexServer:
+    """Plex server with M playing sessions and an SSE notification stream."""
+
+    rating_keys = itertools.count(100000)
+
+    def __init__(self, index, sessions, owned, interval, new_item_every, stats):
+        self.index = index
+        self.interval = interval
+        self.new_item_every = new_item_every
+        self.stats = stats
+        self.running = True
+        self.lock = threading.Lock()
+        self.sessions = [Session(str(i + 1), i < owned, next(self.rating_keys)) for i in range(sessions)]
+
+        server = self
+
+        class Handler(BaseHTTPRequestHandler):
+            protocol_version = "HTTP/1.1"
+
+            def log_message(self, *args):
+                pass
+
+            def do_HEAD(self):
+                server.stats.count_request("head")
+                self.send_response(200)
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+
+            def do_GET(self):
+                path = self.path.split("?")[0]
+                if path.startswith("/:/eventsource"):
+                    server.stats.count_request("sse")
+                    return server.stream_events(self)
+                if path == "/status/sessions":
+                    server.stats.count_request("sessions")
+                    return self.send_json(server.sessions_payload())
+                if path.startswith("/library/metadata/"):
+                    server.stats.count_request("metadata")
+                    server.stats.metadata_requested((server.index, path))
+                    return self.send_json(metadata_payload(path.rsplit("/", 1)[-1]))
+                if path == "/identity":
+                    server.stats.count_request("identity")
+                    return self.send_json({"MediaContainer": {"machineIdentifier": server.client_id()}})
+                server.stats.count_request("other")
+                self.send_response(404)
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+
+            def send_json(self, payload):
+                body = json.dumps(payload).encode()
+                self.send_response(200)
+                self.send_header("Content-Type", "application/json")
+                self.send_header("Content-Length", str(len(body)))
+                self.end_headers()
+                self.wfile.write(body)
+
+        self.httpd = QuietHTTPServer(("127.0.0.1", 0), Handler)
+        self.thread = threading.Thread(target=self.httpd.serve_forever, daemon=True)
+        self.thread.start()
+
+    def client_id(self):
+        return "loadgen-server-%d" % self.index
+
+    def uri(self):
+        return "http://127.0.0.1:%d" % self.httpd.server_address[1]
+
+    def stop(self):
+        self.running = False
+        self.httpd.shutdown()
+        self.httpd.server_close()
+
+    def sessions_payload(self):
+        with self.lock:
+            entries = [session_entry(s) for s in self.sessions]
+        return {"MediaContainer": {"size": len(entries), "Metadata": entries}}
+
+    def next_event(self, session):
+        """Advance a session and build its notification, like a client timeline report."""
+        with self.lock:
+            session.events += 1
+            session.offset += int(self.interval * 1000)
+            new_item = session.owned and session.events % self.new_item_every == 0
+            if new_item:
+                session.rating_key = next(self.rating_keys)
+                session.offset = 0
+            notification = {
+                "sessionKey": session.key,
+                "clientIdentifier": "player-%s" % session.key,
+                "guid": "",
+                "ratingKey": str(session.rating_key),
+                "url": "",
+                "key": "/library/metadata/%d" % session.rating_key,
+                "viewOffset": session.offset,
+                "playQueueItemID": session.rating_key + 7,
+                "playQueueID": 3000 + int(session.key),
+                "state": "playing",
+                "transcodeSession": "%032x" % random.getrandbits(128),
+            }
+        path = (self.index, notification["key"]) if new_item else None
+        return {"PlaySessionStateNotification": notification}, path
+
+    def stream_events(self, handler):
+        handler.send_response(200)
+        handler.send_header("Content-Type", "text/event-stream")
+        handler.send_header("Cache-Control", "no-cache")
+        handler.end_headers()
+
+        # Every session reports on its own clock, spread over the interval
+        now = time.monotonic()
+        queue = [(now + random.uniform(0, self.interval), i) for i in range(len(self.sessions))]
+        heapq.heapify(queue)
+        try:
+            while self.running:
+                due, i = queue[0]
+                delay = due - time.monotonic()
+                if delay > 0:
+                    time.sleep(min(delay, 0.5))
+                    continue
+                heapq.heapreplace(queue, (due + self.interval * random.uniform(0.9, 1.1), i))
+                payload, path = self.next_event(self.sessions[i])
+                handler.wfile.write(("event: playing\ndata: %s\n\n" % json.dumps(payload)).encode())
+                handler.wfile.flush()
+                self.stats.event_sent(path)
+        except (BrokenPipeError, ConnectionResetError):
+            pass
+
+
+def session_entry(session):
+    """One /status/sessions entry, about the size real servers send."""
+    user = USERNAME if session.owned else "friend-%s" % session.key
+    rating_key = str(session.rating_key)
+    return {
+        "addedAt": 1700000000,
+        "art": "/library/metadata/%s/art/1700000000" % rating_key,
+        "duration": 2700000,
+        "grandparentTitle": "Show %s" % session.key,
+        "guid": "plex://episode/%s" % rating_key,
+        "index": 3,
+        "key": "/library/metadata/%s" % rating_key,
+        "librarySectionID": "2",
+        "parentIndex": 1,
+        "ratingKey": rating_key,
+        "sessionKey": session.key,
+        "summary": "Lorem ipsum dolor sit amet. " * 12,
+        "thumb": "/library/metadata/%s/thumb/1700000000" % rating_key,
+        "title": "Episode %s" % rating_key,
+        "type": "episode",
+        "viewOffset": session.offset,
+        "Media": [{
+            "audioChannels": 6, "audioCodec": "eac3", "bitrate": 8000, "container": "mkv",
+            "height": 1080, "videoCodec": "h264", "videoResolution": "1080", "width": 1920,
+            "Part": [{"container": "mkv", "duration": 2700000, "file": "/media/show/s01e03.mkv",
+                      "size": 2700000000, "Stream": [
+                          {"codec": "h264", "streamType": 1, "displayTitle": "1080p (H.264)"},
+                          {"codec": "eac3", "streamType": 2, "displayTitle": "English (EAC3 5.1)"},
+                          {"codec": "srt", "streamType": 3, "displayTitle": "English (SRT)"}]}],
+        }],
+        "User": {"id": session.key, "thumb": "https://plex.tv/users/%s/avatar" % session.key, "title": user},
+        "Player": {"address": "10.0.0.%s" % (int(session.key) % 250), "machineIdentifier": "player-%s" % session.key,
+                   "platform": "Chrome", "product": "Plex Web", "state": "playing", "title": "Chrome"},
+        "Session": {"id": "%032x" % random.getrandbits(128), "bandwidth": 9000, "location": "lan"},
+    }
+
+
+def metadata_payload(rating_key):
+    return {"MediaContainer": {"size": 1, "Metadata": [{
+        "ratingKey": rating_key,
+        "key": "/library/metadata/%s" % rating_key,
+        "type": "movie",
+        "title": "Movie %s" % rating_key,
+        "year": 2001,
+        "duration": 6000000,
+        "summary": "Lorem ipsum dolor sit amet. " * 20,
+        "thumb": "/library/metadata/%s/thumb/1700000000" % rating_key,
+        "Guid": [{"id": "imdb://tt%07d" % int(rating_key)}, {"id": "tmdb://%s" % rating_key}],
+        "Genre": [{"tag": "Drama"}, {"tag": "Thriller"}],
+        "Media": [{"videoResolution": "1080", "bitrate": 8000}],
+    }]}}
+
+
+class FakeDiscord:
+    """Answers the Discord IPC handshake, SET_ACTIVITY and pings on a Unix socket."""
+
+    def __init__(self, directory):
+        self.path = os.path.join(directory, "discord-ipc-0")
+        self.activities = 0
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.bind(self.path)
+        self.sock.listen(4)
+        threading.Thread(target=self.accept_loop, daemon=True).start()
+
+    def accept_loop(self):
+        while True:
+            try:
+                conn, _ = self.sock.accept()
+            except OSError:
+                return
+            threading.Thread(target=self.serve, args=(conn,), daemon=True).start()
+
+    def serve(self, conn):
+        try:
+            while True:
+                header = self.read_exact(conn, 8)
+                opcode, length = struct.unpack("<II", header)
+                data = self.read_exact(conn, length)
+                if opcode == 0:
+                    self.send(conn, 1, {"cmd": "DISPATCH", "evt": "READY", "data": {"v": 1, "user": {"id": "1"}}})
+                elif opcode == 1:
+                    request = json.loads(data)
+                    self.activities += request.get("cmd") == "SET_ACTIVITY"
+                    self.send(conn, 1, {"cmd": request.get("cmd"), "evt": None, "nonce": request.get("nonce"),
+                                        "data": {}})
+                elif opcode == 3:
+                    conn.sendall(struct.pack("<II", 4, len(data)) + data)
+                elif opcode == 2:
+                    return
+        except (EOFError, OSError, ValueError):
+            pass
+        finally:
+            conn.close()
+
+    @staticmethod
+    def read_exact(conn, size):
+        data = b""
+        while len(data) < size:
+            chunk = conn.recv(size - len(data))
+            if not chunk:
+                raise EOFError
+            data += chunk
+        return data
+
+    @staticmethod
+    def send(conn, opcode, payload):
+        body = json.dumps(payload).encode()
+        conn.sendall(struct.pack("<II", opcode, len(body)) + body)
+
+    def stop(self):
+        self.sock.close()
+
+
+class ProcessMonitor:
+    """Samples CPU time and resident memory of a process from /proc."""
+
+    def __init__(self, pid):
+        self.pid = pid
+        self.peak_rss = 0
+        self.running = True
+        self.thread = threading.Thread(target=self.loop, daemon=True)
+        self.thread.start()
+
+    def cpu_seconds(self):
+        with open("/proc/%d/stat" % self.pid) as f:
+            fields = f.read().rsplit(")", 1)[1].split()
+        return (int(fields[11]) + int(fields[12])) / CLOCK_TICKS
+
+    def rss_bytes(self):
+        with open("/proc/%d/status" % self.pid) as f:
+            for line in f:
+                if line.startswith("VmRSS:"):
+                    return int(line.split()[1]) * 1024
+        return 0
+
+    def loop(self):
+        while self.running:
+            try:
+                self.peak_rss = max(self.peak_rss, self.rss_bytes())
+            except OSError:
+                return
+            time.sleep(0.2)
+
+    def stop(self):
+        self.running = False
+
+
+def write_config(directory, servers, log_level):
+    lines = [
+        "log_level: %d" % log_level,
+        "plex:",
+        "  auth_token: loadgen-token",
+        "  client_identifier: loadgen-client",
+        "  username: %s" % USERNAME,
+        "plex_servers:",
+    ]
+    for server in servers:
+        lines += [
+            "  - name: Load %d" % server.index,
+            "    client_identifier: %s" % server.client_id(),
+            "    local_uri: %s" % server.uri(),
+            '    public_uri: ""',
+            "    access_token: loadgen-server-token-%d" % server.index,
+            "    owned: true",
+        ]
+    config_dir = os.path.join(directory, "presence-for-plex")
+    os.makedirs(config_dir, exist_ok=True)
+    with open(os.path.join(config_dir, "config.yaml"), "w") as f:
+        f.write("\n".join(lines) + "\n")
+
+
+def percentile(values, quantile):
+    if not values:
+        return None
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(quantile * len(ordered)))]
+
+
+def milliseconds(seconds):
+    return None if seconds is None else 1000 * seconds
+
+
+def run_point(args, server_count, session_count):
+    """Run the binary against one N x M setup and return its measurements."""
+    stats = Stats()
+    directory = tempfile.mkdtemp(prefix="presence-loadgen-")
+    servers = [FakePlexServer(i, session_count, min(args.owned, session_count), args.interval,
+                              args.new_item_every, stats) for i in range(server_count)]
+    discord = FakeDiscord(directory)
+    write_config(directory, servers, args.log_level)
+
+    env = dict(os.environ)
+    env.update({
+        "XDG_CONFIG_DIR": directory,
+        "XDG_RUNTIME_DIR": directory,
+        "TMPDIR": directory + "/",
+        "HOME": directory,
+    })
+    process = subprocess.Popen([args.binary], env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    monitor = ProcessMonitor(process.pid)
+    try:
+        # Measure the steady state only
+        time.sleep(args.warmup)
+        stats.reset()
+        cpu_start = monitor.cpu_seconds()
+        start = time.monotonic()
+        time.sleep(args.duration)
+        elapsed = time.monotonic() - start
+        cpu = monitor.cpu_seconds() - cpu_start
+        rss = monitor.rss_bytes()
+    finally:
+        monitor.stop()
+        process.send_signal(signal.SIGINT)
+        try:
+            process.wait(timeout=15)
+        except subprocess.TimeoutExpired:
+            process.kill()
+            process.wait()
+        for server in servers:
+            server.stop()
+        discord.stop()
+
+    with stats.lock:
+        requests = dict(stats.requests)
+        latencies = list(stats.latencies)
+        unanswered = len(stats.pending)
+        events = stats.events
+
+    if args.keep:
+        print("  logs kept in %s" % directory, file=sys.stderr)
+    else:
+        shutil.rmtree(directory, ignore_errors=True)
+
+    return {
+        "servers": server_count,
+        "sessions": session_count,
+        "events_per_s": events / elapsed,
+        "cpu_percent": 100.0 * cpu / elapsed,
+        "rss_mb": rss / 2**20,
+        "peak_rss_mb": monitor.peak_rss / 2**20,
+        "latency_p50_ms": milliseconds(percentile(latencies, 0.5)),
+        "latency_p99_ms": milliseconds(percentile(latencies, 0.99)),
+        "latency_samples": len(latencies),
+        "unanswered": unanswered,
+        "requests_per_s": sum(requests.values()) / elapsed,
+        "requests": {k: v / elapsed for k, v in sorted(requests.items())},
+        "exit_code": process.returncode,
+    }
+
+
+def parse_counts(text):
+    return [int(part) for part in text.split(",") if part]
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Load test Presence For Plex with fake servers and sessions")
+    parser.add_argument("--binary", default=os.path.join(here, "build", "PresenceForPlex"),
+                        help="PresenceForPlex binary to test")
+    parser.add_argument("--servers", default="1,4", help="comma-separated server counts (N)")
+    parser.add_argument("--sessions", default="10,50,200", help="comma-separated sessions per server (M)")
+    parser.add_argument("--owned", type=int, default=2, help="sessions per server played by the configured user")
+    parser.add_argument("--interval", type=float, default=10.0,
+                        help="seconds between notifications of one session (Plex clients report every 10 s)")
+    parser.add_argument("--new-item-every", type=int, default=3,
+                        help="owned sessions move to a new item every this many notifications")
+    parser.add_argument("--warmup", type=float, default=5.0, help="seconds before measuring")
+    parser.add_argument("--duration", type=float, default=30.0, help="seconds to measure each setup")
+    parser.add_argument("--log-level", type=int, default=2, help="log level of the binary (0 debug .. 3 error)")
+    parser.add_argument("--json", action="store_true", help="print the results as JSON lines")
+    parser.add_argument("--keep", action="store_true", help="keep each run's scratch directory and log")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.binary):
+        parser.error("binary not found: %s" % args.binary)
+    if not os.path.exists("/proc/self/stat"):
+        parser.error("CPU and memory are read from /proc, which this system does not have")
+
+    if not args.json:
+        print("%4s %5s %9s %7s %8s %9s %9s %8s %8s  %s" % ("N", "M", "events/s", "CPU %", "RSS MB", "p50 ms",
+                                                          "p99 ms", "missed", "req/s", "requests/s by kind"))
+    for server_count in parse_counts(args.servers):
+        for session_count in parse_counts(args.sessions):
+            result = run_point(args, server_count, session_count)
+            if args.json:
+                print(json.dumps(result), flush=True)
+                continue
+            kinds = " ".join("%s=%.1f" % item for item in result["requests"].items())
+            latency = ["%9s" % "-" if value is None else "%9.1f" % value
+                       for value in (result["latency_p50_ms"], result["latency_p99_ms"])]
+            print("%4d %5d %9.1f %7.1f %8.1f %s %s %8d %8.1f  %s" % (
+                server_count, session_count, result["events_per_s"], result["cpu_percent"],
+                result["peak_rss_mb"], latency[0], latency[1], result["unanswered"],
+                result["requests_per_s"], kinds), flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,214 @@
+#include "api_client.h"
+#include "http_client.h"
+#include "logger.h"
+#include <algorithm>
+
+namespace
+{
+    // Give up on a request after this many rate-limited answers in a row
+    constexpr const int MAX_ATTEMPTS = 3;
+
+    // Pause used when a 429/503 answer carries no usable Retry-After
+    constexpr const int DEFAULT_RETRY_AFTER = 2; // seconds
+    constexpr const int MAX_RETRY_AFTER = 300;   // seconds
+}
+
+ApiClient::ApiClient(std::string name, std::vector<RateLimit> limits)
+    : m_name(std::move(name)),
+      m_lastRefill(std::chrono::steady_clock::now()),
+      m_blockedUntil(m_lastRefill)
+{
+    for (const auto &limit : limits)
+    {
+        m_buckets.push_back(Bucket{limit, limit.capacity});
+    }
+    m_dispatcher = std::thread(&ApiClient::dispatchLoop, this);
+}
+
+ApiClient::~ApiClient()
+{
+    stop();
+}
+
+ApiResponse ApiClient::get(const std::string &url, const std::map<std::string, std::string> &headers,
+                           ApiPriority priority, const CancellationToken *cancel)
+{
+    auto request = std::make_unique<Request>();
+    request->url = url;
+    request->headers = headers;
+    request->cancel = cancel;
+    std::future<ApiResponse> result = request->result.get_future();
+
+    QueueKey key;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping)
+        {
+            return ApiResponse{};
+        }
+        key = QueueKey{static_cast<int>(priority), m_nextSequence++};
+        m_queue.emplace(key, std::move(request));
+    }
+    m_cv.notify_one();
+
+    // A cancelled request leaves the queue at once; one already in flight is
+    // aborted by the dispatcher's HttpClient, which watches the same token
+    CancellationToken::ListenerGuard cancelGuard(cancel, [this, key]()
+                                                 {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_queue.find(key);
+        if (it != m_queue.end())
+        {
+            it->second->result.set_value(ApiResponse{});
+            m_queue.erase(it);
+        } });
+
+    return result.get();
+}
+
+void ApiClient::cancelPending()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &[key, request] : m_queue)
+    {
+        request->result.set_value(ApiResponse{});
+    }
+    m_queue.clear();
+    m_cancelSignal.notify();
+}
+
+void ApiClient::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping)
+        {
+            return;
+        }
+        m_stopping = true;
+        m_cancelSignal.notify();
+    }
+    m_cv.notify_all();
+
+    if (m_dispatcher.joinable())
+    {
+        m_dispatcher.join();
+    }
+
+    // Release anyone still waiting
+    for (auto &[key, request] : m_queue)
+    {
+        request->result.set_value(ApiResponse{});
+    }
+    m_queue.clear();
+}
+
+void ApiClient::refillLocked(std::chrono::steady_clock::time_point now)
+{
+    double elapsed = std::chrono::duration<double>(now - m_lastRefill).count();
+    m_lastRefill = now;
+    for (auto &bucket : m_buckets)
+    {
+        bucket.tokens = (std::min)(bucket.limit.capacity, bucket.tokens + elapsed * bucket.limit.refillPerSecond);
+    }
+}
+
+std::chrono::steady_clock::duration ApiClient::waitTimeLocked(std::chrono::steady_clock::time_point now) const
+{
+    std::chrono::steady_clock::duration wait = std::chrono::steady_clock::duration::zero();
+    if (m_blockedUntil > now)
+    {
+        wait = m_blockedUntil - now;
+    }
+
+    for (const auto &bucket : m_buckets)
+    {
+        if (bucket.tokens < 1.0)
+        {
+            auto refill = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>((1.0 - bucket.tokens) / bucket.limit.refillPerSecond));
+            wait = (std::max)(wait, refill);
+        }
+    }
+    return wait;
+}
+
+std::chrono::seconds ApiClient::parseRetryAfter(const std::map<std::string, std::string> &headers)
+{
+    auto it = headers.find("retry-after");
+    if (it != headers.end())
+    {
+        // Only the delay-seconds form is handled; an HTTP date falls back to the default
+        try
+        {
+            int seconds = std::stoi(it->second);
+            if (seconds >= 0)
+            {
+                return std::chrono::seconds((std::min)(seconds, MAX_RETRY_AFTER));
+            }
+        }
+        catch (const std::exception &)
+        {
+        }
+    }
+    return std::chrono::seconds(DEFAULT_RETRY_AFTER);
+}
+
+void ApiClient::dispatchLoop()
+{
+    HttpClient client(&m_cancelSignal);
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_stopping)
+    {
+        if (m_queue.empty())
+        {
+            m_cv.wait(lock, [this]
+                      { return m_stopping || !m_queue.empty(); });
+            continue;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        refillLocked(now);
+        auto wait = waitTimeLocked(now);
+        if (wait > std::chrono::steady_clock::duration::zero())
+        {
+            m_cv.wait_for(lock, wait);
+            continue;
+        }
+
+        for (auto &bucket : m_buckets)
+        {
+            bucket.tokens -= 1.0;
+        }
+
+        auto entry = m_queue.begin();
+        QueueKey key = entry->first;
+        std::unique_ptr<Request> request = std::move(entry->second);
+        m_queue.erase(entry);
+
+        // Only cancellations from now on apply to this request
+        m_cancelSignal.reset();
+        lock.unlock();
+
+        std::string body;
+        client.get(request->url, request->headers, body, request->cancel);
+        ApiResponse response{client.lastStatusCode(), std::move(body)};
+
+        lock.lock();
+        bool cancelled = request->cancel && request->cancel->isCancelled();
+        if ((response.statusCode == 429 || response.statusCode == 503) && !cancelled && ++request->attempts < MAX_ATTEMPTS)
+        {
+            auto retryAfter = parseRetryAfter(client.lastResponseHeaders());
+            m_blockedUntil = std::chrono::steady_clock::now() + retryAfter;
+            LOG_WARNING("ApiClient", m_name + " rate limited (HTTP " + std::to_string(response.statusCode) +
+                                         "), pausing requests for " + std::to_string(retryAfter.count()) + "s");
+
+            // Keep the original queue position so it goes out first once the pause ends
+            m_queue.emplace(key, std::move(request));
+            continue;
+        }
+
+        request->result.set_value(std::move(response));
+    }
+}
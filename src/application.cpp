@@ -2,6 +2,118 @@
 #include "version.h"
 #include "preferences.h"
 
+#include <stdexcept>
+
+namespace
+{
+    // Most cache keys listed by "caches NAME" unless a limit is given
+    constexpr size_t DEFAULT_CACHE_KEY_LIMIT = 100;
+
+    const char *playbackStateName(PlaybackState state)
+    {
+        switch (state)
+        {
+        case PlaybackState::Playing:
+            return "playing";
+        case PlaybackState::Paused:
+            return "paused";
+        case PlaybackState::Buffering:
+            return "buffering";
+        case PlaybackState::BadToken:
+            return "bad_token";
+        case PlaybackState::NotInitialized:
+            return "not_initialized";
+        default:
+            return "stopped";
+        }
+    }
+
+    const char *mediaTypeName(MediaType type)
+    {
+        switch (type)
+        {
+        case MediaType::Movie:
+            return "movie";
+        case MediaType::TVShow:
+            return "episode";
+        case MediaType::Music:
+            return "track";
+        default:
+            return "unknown";
+        }
+    }
+
+    const char *logLevelName(LogLevel level)
+    {
+        switch (level)
+        {
+        case LogLevel::Debug:
+            return "debug";
+        case LogLevel::Info:
+            return "info";
+        case LogLevel::Warning:
+            return "warning";
+        case LogLevel::Error:
+            return "error";
+        default:
+            return "none";
+        }
+    }
+
+    json sessionToJson(const MediaInfo &info)
+    {
+        const auto &meta = info.meta();
+        json session = {{"serverId", info.serverId.str()},
+                        {"sessionKey", info.sessionKey},
+                        {"username", info.username.str()},
+                        {"client", info.client.str()},
+                        {"state", playbackStateName(info.playback.state)},
+                        {"progress", info.playback.progress},
+                        {"duration", meta.duration},
+                        {"startTime", static_cast<int64_t>(info.playback.startTime)},
+                        {"type", mediaTypeName(meta.type)},
+                        {"title", meta.title},
+                        {"year", meta.year},
+                        {"mediaKey", meta.mediaKey}};
+        if (meta.type == MediaType::TVShow)
+        {
+            session["show"] = meta.grandparentTitle;
+            session["season"] = meta.season;
+            session["episode"] = meta.episode;
+        }
+        else if (meta.type == MediaType::Music)
+        {
+            session["artist"] = meta.artist;
+            session["album"] = meta.album;
+        }
+        return session;
+    }
+
+    json cacheStatsToJson(const CacheStats &stats)
+    {
+        return {{"name", stats.name},
+                {"entries", stats.entries},
+                {"bytes", stats.bytes},
+                {"byteBudget", stats.byteBudget},
+                {"hits", stats.hits},
+                {"misses", stats.misses},
+                {"hitRatio", stats.hitRatio()},
+                {"evictions", stats.evictions},
+                {"expirations", stats.expirations}};
+    }
+
+    json latencyToJson(const EndpointLatencyStats &latency)
+    {
+        return {{"endpoint", latency.endpoint},
+                {"samples", latency.samples},
+                {"p50Ms", latency.p50.count() / 1000.0},
+                {"p99Ms", latency.p99.count() / 1000.0},
+                {"connectP99Ms", latency.connectP99.count() / 1000.0},
+                {"connectTimeoutMs", latency.timeouts.connect.count()},
+                {"totalTimeoutMs", latency.timeouts.total.count()}};
+    }
+}
+
 Application::Application()
 {
     setupLogging();
@@ -43,9 +155,174 @@ void Application::setupDiscordCallbacks()
 #ifdef _WIN32
             m_trayIcon->setConnectionStatus("Status: Waiting for Discord...");
 #endif
+            std::unique_lock<std::mutex> lock(m_discordConnectMutex);
+            m_discordConnectCv.notify_all();
                                            });
 }
 
+void Application::setupControlCommands()
+{
+    m_controlServer.addCommand("status", "- version, uptime, connections and what is shown", [this](const std::vector<std::string> &)
+                               {
+        auto current = m_plex->getCurrentPlayback();
+        auto servers = m_plex->getServerStatus();
+        size_t connected = std::count_if(servers.begin(), servers.end(), [](const Plex::ServerStatus &server)
+                                         { return server.state == "connected"; });
+        return json{{"version", Config::getInstance().getVersionString()},
+                    {"uptimeSeconds", std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - m_startTime).count()},
+                    {"logLevel", logLevelName(Logger::getInstance().getLogLevel())},
+                    {"discordConnected", m_discord->isConnected()},
+                    {"servers", servers.size()},
+                    {"serversConnected", connected},
+                    {"activeSessions", m_plex->getActiveSessions().size()},
+                    {"current", current.playback.state == PlaybackState::Stopped ? json(nullptr) : sessionToJson(current)}}; });
+
+    m_controlServer.addCommand("sessions", "- every active session", [this](const std::vector<std::string> &)
+                               {
+        json sessions = json::array();
+        for (const auto &info : m_plex->getActiveSessions())
+        {
+            sessions.push_back(sessionToJson(info));
+        }
+        return sessions; });
+
+    m_controlServer.addCommand("caches", "[NAME [LIMIT]] - cache sizes, or the keys of one cache", [this](const std::vector<std::string> &args)
+                               {
+        if (args.empty())
+        {
+            json caches = json::array();
+            for (const auto &stats : m_plex->getCacheStats())
+            {
+                caches.push_back(cacheStatsToJson(stats));
+            }
+            return caches;
+        }
+
+        size_t limit = DEFAULT_CACHE_KEY_LIMIT;
+        if (args.size() > 1)
+        {
+            try
+            {
+                limit = std::stoul(args[1]);
+            }
+            catch (const std::exception &)
+            {
+                throw std::invalid_argument("LIMIT must be a number");
+            }
+        }
+
+        std::vector<std::string> keys;
+        if (!m_plex->getCacheKeys(args[0], limit, keys))
+        {
+            throw std::invalid_argument("No cache named " + args[0]);
+        }
+        for (const auto &stats : m_plex->getCacheStats())
+        {
+            if (stats.name == args[0])
+            {
+                auto result = cacheStatsToJson(stats);
+                result["keys"] = keys;
+                return result;
+            }
+        }
+        return json{{"name", args[0]}, {"keys", keys}}; });
+
+    m_controlServer.addCommand("servers", "- connection state and latency per server", [this](const std::vector<std::string> &)
+                               {
+        auto latencies = LatencyTracker::getInstance().stats();
+        json servers = json::array();
+        for (const auto &server : m_plex->getServerStatus())
+        {
+            // Latency is tracked per endpoint, which starts with one of the server's URIs
+            json serverLatency = json::array();
+            for (const auto &latency : latencies)
+            {
+                for (const auto &uri : server.candidates)
+                {
+                    if (latency.endpoint.compare(0, uri.size(), uri) == 0 &&
+                        (latency.endpoint.size() == uri.size() || latency.endpoint[uri.size()] == '/'))
+                    {
+                        serverLatency.push_back(latencyToJson(latency));
+                        break;
+                    }
+                }
+            }
+            servers.push_back({{"id", server.id},
+                               {"name", server.name},
+                               {"owned", server.owned},
+                               {"state", server.state},
+                               {"activeUri", server.activeUri},
+                               {"candidates", server.candidates},
+                               {"failedOver", server.failedOver},
+                               {"latency", serverLatency}});
+        }
+        return servers; });
+
+    m_controlServer.addCommand("metrics", "- worker pool, timers, request latency and Discord round trips", [this](const std::vector<std::string> &)
+                               {
+        auto poolStats = WorkerPool::getInstance().stats();
+        auto timerStats = TimerService::getInstance().stats();
+        auto roundTrips = m_discord->getRoundTripStats();
+        json latency = json::array();
+        for (const auto &endpoint : LatencyTracker::getInstance().stats())
+        {
+            latency.push_back(latencyToJson(endpoint));
+        }
+        return json{{"workerPool", {{"threads", poolStats.threads},
+                                    {"queued", poolStats.queued},
+                                    {"maxQueued", poolStats.maxQueued},
+                                    {"executed", poolStats.executed},
+                                    {"stolen", poolStats.stolen}}},
+                    {"timers", {{"pending", timerStats.pending},
+                                {"fired", timerStats.fired},
+                                {"wakeups", timerStats.wakeups},
+                                {"idleWakeups", timerStats.idleWakeups},
+                                {"wakeupsPerSecond", timerStats.wakeupsPerSecond},
+                                {"idleWakeupsPerSecond", timerStats.idleWakeupsPerSecond}}},
+                    {"discord", {{"answered", roundTrips.answered},
+                                 {"timedOut", roundTrips.timedOut},
+                                 {"p50Ms", roundTrips.p50.count() / 1000.0},
+                                 {"p99Ms", roundTrips.p99.count() / 1000.0}}},
+                    {"latency", latency}}; });
+
+    m_controlServer.addCommand("loglevel", "[debug|info|warning|error|none] - show or change the log level until restart", [](const std::vector<std::string> &args)
+                               {
+        if (!args.empty())
+        {
+            static const std::map<std::string, LogLevel> levels = {{"debug", LogLevel::Debug},
+                                                                    {"info", LogLevel::Info},
+                                                                    {"warning", LogLevel::Warning},
+                                                                    {"error", LogLevel::Error},
+                                                                    {"none", LogLevel::None}};
+            auto level = levels.find(args[0]);
+            if (level == levels.end())
+            {
+                throw std::invalid_argument("Unknown log level " + args[0]);
+            }
+            Logger::getInstance().setLogLevel(level->second);
+            LOG_INFO("Application", "Log level changed to " + args[0] + " from the control socket");
+        }
+        return json{{"logLevel", logLevelName(Logger::getInstance().getLogLevel())}}; });
+
+    m_controlServer.addCommand("flush-caches", "- drop every cached lookup", [this](const std::vector<std::string> &)
+                               {
+        m_plex->clearCaches();
+        return json{{"flushed", true}}; });
+
+    m_controlServer.addCommand("resync", "- check every server's sessions now", [this](const std::vector<std::string> &)
+                               {
+        if (!m_plex->resyncSessions())
+        {
+            throw std::runtime_error("Plex is not connected");
+        }
+        return json{{"requested", true}}; });
+
+    m_controlServer.addCommand("reconnect-discord", "- drop the Discord connection and connect again", [this](const std::vector<std::string> &)
+                               {
+        m_discord->reconnect();
+        return json{{"requested", true}}; });
+}
+
 bool Application::initialize()
 {
     try
@@ -62,7 +339,7 @@ bool Application::initialize()
             LOG_INFO("Application", "Exit triggered from tray icon");
             stop(); });
         m_trayIcon->setUpdateCheckCallback([this]()
-                                           { m_updateCheckFuture = std::async(std::launch::async, [this] { checkForUpdates(); }); });
+                                           { m_updateCheckFuture = WorkerPool::getInstance().submit([this] { checkForUpdates(); }); });
         m_trayIcon->setPreferencesCallback([this]()
                                            {
             Preferences prefs;
@@ -72,7 +349,18 @@ bool Application::initialize()
 
         setupDiscordCallbacks();
 
+        // The main loop sleeps until a session changes instead of polling
+        m_plex->setPlaybackChangedCallback([this]()
+                                           {
+            std::lock_guard<std::mutex> lock(m_discordConnectMutex);
+            m_playbackChanged = true;
+            m_discordConnectCv.notify_all(); });
+
         m_discord->start();
+
+        setupControlCommands();
+        m_controlServer.start();
+
         m_initialized = true;
         return true;
     }
@@ -223,23 +511,23 @@ void Application::checkForUpdates()
 void Application::updateTrayStatus(const MediaInfo &info)
 {
 #ifdef _WIN32
-    if (info.state == PlaybackState::Stopped)
+    if (info.playback.state == PlaybackState::Stopped)
     {
         m_trayIcon->setConnectionStatus("Status: No active sessions");
     }
-    else if (info.state == PlaybackState::Playing)
+    else if (info.playback.state == PlaybackState::Playing)
     {
         m_trayIcon->setConnectionStatus("Status: Playing");
     }
-    else if (info.state == PlaybackState::Paused)
+    else if (info.playback.state == PlaybackState::Paused)
     {
         m_trayIcon->setConnectionStatus("Status: Paused");
     }
-    else if (info.state == PlaybackState::Buffering)
+    else if (info.playback.state == PlaybackState::Buffering)
     {
         m_trayIcon->setConnectionStatus("Status: Buffering...");
     }
-    else if (info.state == PlaybackState::BadToken)
+    else if (info.playback.state == PlaybackState::BadToken)
     {
         m_trayIcon->setConnectionStatus("Status: Invalid Plex token");
     }
@@ -252,17 +540,17 @@ void Application::updateTrayStatus(const MediaInfo &info)
 
 void Application::processPlaybackInfo(const MediaInfo &info)
 {
-    if (info.state != PlaybackState::BadToken && info.state != PlaybackState::NotInitialized)
+    if (info.playback.state != PlaybackState::BadToken && info.playback.state != PlaybackState::NotInitialized)
     {
-        if (info.state != m_lastState || (info.state == PlaybackState::Playing && abs(info.startTime - m_lastStartTime) > 5))
+        if (info.playback.state != m_lastState || (info.playback.state == PlaybackState::Playing && abs(info.playback.startTime - m_lastStartTime) > 5))
         {
-            LOG_DEBUG("Application", "Playback state changed, updating Discord presence to " + std::to_string(static_cast<int>(info.state)));
+            LOG_DEBUG("Application", "Playback state changed, updating Discord presence to " + std::to_string(static_cast<int>(info.playback.state)));
             m_discord->updatePresence(info);
         }
-        m_lastStartTime = info.startTime;
-        m_lastState = info.state;
+        m_lastStartTime = info.playback.startTime;
+        m_lastState = info.playback.state;
     }
-    else if (info.state == PlaybackState::NotInitialized)
+    else if (info.playback.state == PlaybackState::NotInitialized)
     {
         LOG_INFO("Application", "Plex class not initialized, skipping update");
         m_lastState = PlaybackState::NotInitialized;
@@ -286,19 +574,21 @@ void Application::run()
         {
             if (!m_discord->isConnected())
             {
+                // The connected callback wakes this wait once Plex is set up
                 std::unique_lock<std::mutex> lock(m_discordConnectMutex);
-                // Reduce wait time to be more responsive to shutdown
-                m_discordConnectCv.wait_for(lock,
-                                            std::chrono::milliseconds(500),
-                                            [this]()
-                                            { return m_discord->isConnected() || !m_running; });
+                m_discordConnectCv.wait(lock, [this]()
+                                        { return m_discord->isConnected() || !m_running; });
 
-                if (!m_running || !m_discord->isConnected())
+                if (!m_running)
                 {
                     continue;
                 }
             }
 
+            {
+                std::lock_guard<std::mutex> lock(m_discordConnectMutex);
+                m_playbackChanged = false;
+            }
             MediaInfo info = m_plex->getCurrentPlayback();
 
             updateTrayStatus(info);
@@ -309,7 +599,10 @@ void Application::run()
             LOG_ERROR("Application", "Error in main loop: " + std::string(e.what()));
         }
 
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        // Sleep until a session changes, Discord drops, or stop() is called
+        std::unique_lock<std::mutex> lock(m_discordConnectMutex);
+        m_discordConnectCv.wait(lock, [this]()
+                                { return m_playbackChanged || !m_discord->isConnected() || !m_running; });
     }
 
     performCleanup();
@@ -319,6 +612,10 @@ void Application::performCleanup()
 {
     LOG_INFO("Application", "Stopping application");
     m_running = false;
+    auto cleanupStart = std::chrono::steady_clock::now();
+
+    // No commands while the objects they use are torn down
+    m_controlServer.stop();
 
     // Launch cleanup operations in parallel
     std::vector<std::future<void>> cleanupTasks;
@@ -341,7 +638,7 @@ void Application::performCleanup()
     if (m_plex)
     {
         LOG_INFO("Application", "Cleaning up Plex connections");
-        cleanupTasks.push_back(std::async(std::launch::async, [this]()
+        cleanupTasks.push_back(WorkerPool::getInstance().submit([this]()
                                           {
             try {
                 m_plex->stop();
@@ -355,7 +652,7 @@ void Application::performCleanup()
     if (m_discord)
     {
         LOG_INFO("Application", "Stopping Discord connection");
-        cleanupTasks.push_back(std::async(std::launch::async, [this]()
+        cleanupTasks.push_back(WorkerPool::getInstance().submit([this]()
                                           {
             try {
                 m_discord->stop();
@@ -366,7 +663,8 @@ void Application::performCleanup()
             } }));
     }
 
-    // Wait for all cleanup tasks with timeout
+    // Every wait in the cleanup tasks is interruptible, so they normally finish
+    // within milliseconds; the timeout is only a backstop
     for (auto &task : cleanupTasks)
     {
         if (task.wait_for(std::chrono::seconds(5)) == std::future_status::timeout)
@@ -375,7 +673,28 @@ void Application::performCleanup()
         }
     }
 
-    LOG_INFO("Application", "Application stopped");
+    auto poolStats = WorkerPool::getInstance().stats();
+    LOG_INFO_STREAM("Application", "Worker pool: " << poolStats.threads << " threads, " << poolStats.executed
+                                                   << " tasks (" << poolStats.stolen << " stolen), max queue depth "
+                                                   << poolStats.maxQueued);
+
+    auto timerStats = TimerService::getInstance().stats();
+    LOG_INFO_STREAM("Application", "Timers: " << timerStats.fired << " fired over " << timerStats.wakeups
+                                              << " wakeups (" << std::fixed << std::setprecision(3)
+                                              << timerStats.wakeupsPerSecond << "/s, "
+                                              << timerStats.idleWakeupsPerSecond << " idle/s)");
+
+    for (const auto &latency : LatencyTracker::getInstance().stats())
+    {
+        LOG_DEBUG_STREAM("Application", "Latency " << latency.endpoint << ": " << latency.samples << " samples, p50 "
+                                                   << latency.p50.count() / 1000.0 << " ms, p99 "
+                                                   << latency.p99.count() / 1000.0 << " ms, timeouts "
+                                                   << latency.timeouts.connect.count() << "/"
+                                                   << latency.timeouts.total.count() << " ms");
+    }
+
+    auto cleanupTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - cleanupStart);
+    LOG_INFO("Application", "Application stopped in " + std::to_string(cleanupTime.count()) + " ms");
 }
 
 void Application::stop()
@@ -0,0 +1,233 @@
+#include "artwork_resolver.h"
+#include "http_client.h"
+#include "logger.h"
+#include "utils.h"
+
+namespace
+{
+    constexpr const char *TRANSCODE_ENDPOINT = "/photo/:/transcode?width=256&height=256&minSize=1&upscale=1&format=webp";
+    constexpr const char *IDENTITY_ENDPOINT = "/identity";
+    constexpr const char *TRANSCODE_PATH = "/photo/:/transcode?";
+
+    // Cache timeouts (in seconds)
+    constexpr const int RESOLVED_URL_TIMEOUT = 86400;   // 24 hours
+    constexpr const int REACHABLE_PROBE_TIMEOUT = 600;  // 10 minutes
+    constexpr const int UNREACHABLE_PROBE_TIMEOUT = 60; // 1 minute
+    constexpr const int WARMED_URL_TIMEOUT = 86400;     // 24 hours
+
+    // Bound on queued pre-warm requests; older ones are dropped first
+    constexpr const size_t MAX_PREWARM_QUEUE = 16;
+
+    std::string toHttps(const std::string &uri)
+    {
+        if (uri.compare(0, 7, "http://") == 0)
+        {
+            return "https://" + uri.substr(7);
+        }
+        return uri;
+    }
+}
+
+ArtworkResolver::ArtworkResolver(size_t byteBudget, WakeSignal *abortSignal)
+    : m_resolvedUrls("artwork_url", byteBudget - byteBudget / 8, [](const std::string &url)
+                     { return url.capacity(); }),
+      m_reachability("artwork_reachability", byteBudget / 16, [](const bool &)
+                     { return sizeof(bool); }, 1),
+      m_warmedUrls("artwork_warmed", byteBudget / 16, [](const bool &)
+                   { return sizeof(bool); }, 1),
+      m_abortSignal(abortSignal)
+{
+}
+
+ArtworkResolver::~ArtworkResolver()
+{
+    stop();
+}
+
+bool ArtworkResolver::isReachable(const std::string &baseUri)
+{
+    if (auto cached = m_reachability.get(baseUri))
+    {
+        return *cached;
+    }
+
+    HttpClient probeClient(m_abortSignal);
+    bool reachable = probeClient.head(baseUri + IDENTITY_ENDPOINT, {{"Accept", "application/json"}});
+    if (m_abortSignal && m_abortSignal->isSet())
+    {
+        return reachable; // Aborted, so the answer says nothing about the server
+    }
+    LOG_DEBUG("ArtworkResolver", "Reachability probe for " + baseUri + ": " + (reachable ? "reachable" : "unreachable"));
+
+    m_reachability.put(baseUri, reachable,
+                       std::chrono::seconds(reachable ? REACHABLE_PROBE_TIMEOUT : UNREACHABLE_PROBE_TIMEOUT));
+    return reachable;
+}
+
+std::string ArtworkResolver::chooseBaseUri(const std::string &serverUri)
+{
+    // Discord's media proxy wants HTTPS, so prefer the HTTPS form of the
+    // server URI and only fall back to plain HTTP if that is all that answers
+    std::string httpsUri = toHttps(serverUri);
+    if (httpsUri != serverUri && !isReachable(httpsUri) && isReachable(serverUri))
+    {
+        LOG_INFO("ArtworkResolver", "HTTPS not reachable for " + serverUri + ", using it as is");
+        return serverUri;
+    }
+    return httpsUri;
+}
+
+std::string ArtworkResolver::resolve(const std::string &thumbPath, int64_t updatedAt,
+                                     const std::string &serverUri, const std::string &accessToken)
+{
+    if (thumbPath.empty() || serverUri.empty() || accessToken.empty())
+    {
+        return "";
+    }
+
+    // The token is left out of the memo, so a rotated one never lingers
+    std::string key = serverUri + "|" + thumbPath + "|" + std::to_string(updatedAt);
+    std::string url;
+    if (auto cached = m_resolvedUrls.get(key))
+    {
+        url = std::move(*cached);
+    }
+    else
+    {
+        // No cache-busting: the URL only changes when the artwork itself does
+        url = chooseBaseUri(serverUri) + TRANSCODE_ENDPOINT +
+              "&url=" + utils::urlEncode(thumbPath) +
+              (updatedAt > 0 ? "&v=" + std::to_string(updatedAt) : "");
+        m_resolvedUrls.put(key, url, std::chrono::seconds(RESOLVED_URL_TIMEOUT));
+        LOG_INFO("ArtworkResolver", "Resolved artwork URL for " + thumbPath);
+    }
+    return url + "&X-Plex-Token=" + accessToken;
+}
+
+void ArtworkResolver::prewarm(const std::string &url)
+{
+    if (url.find(TRANSCODE_PATH) == std::string::npos || m_warmedUrls.get(url))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_prewarmMutex);
+    if (m_stopping && m_prewarmThread.joinable())
+    {
+        return;
+    }
+    if (!m_prewarmPending.insert(url).second)
+    {
+        return; // Already queued or in flight
+    }
+
+    if (m_prewarmQueue.size() >= MAX_PREWARM_QUEUE)
+    {
+        m_prewarmPending.erase(m_prewarmQueue.front());
+        m_prewarmQueue.pop_front();
+    }
+    m_prewarmQueue.push_back(url);
+
+    if (!m_prewarmThread.joinable())
+    {
+        m_stopping = false;
+        m_prewarmThread = std::thread(&ArtworkResolver::prewarmLoop, this);
+    }
+    m_prewarmCv.notify_one();
+}
+
+void ArtworkResolver::prewarmLoop()
+{
+    HttpClient client(m_abortSignal);
+    std::unique_lock<std::mutex> lock(m_prewarmMutex);
+    while (true)
+    {
+        m_prewarmCv.wait(lock, [this]
+                         { return m_stopping || !m_prewarmQueue.empty(); });
+        if (m_stopping)
+        {
+            break;
+        }
+
+        std::string url = std::move(m_prewarmQueue.front());
+        m_prewarmQueue.pop_front();
+        lock.unlock();
+
+        // The body is discarded; fetching it is what makes the server
+        // transcode and cache the image
+        std::string response;
+        auto start = std::chrono::steady_clock::now();
+        bool success = client.get(url, {{"Accept", "image/webp,image/*"}}, response);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+        if (success)
+        {
+            m_warmedUrls.put(url, true, std::chrono::seconds(WARMED_URL_TIMEOUT));
+            LOG_DEBUG("ArtworkResolver", "Pre-warmed artwork (" + std::to_string(response.size()) + " bytes in " +
+                                             std::to_string(elapsed.count()) + " ms)");
+        }
+        else
+        {
+            LOG_DEBUG("ArtworkResolver", "Failed to pre-warm artwork after " + std::to_string(elapsed.count()) + " ms");
+        }
+
+        lock.lock();
+        m_prewarmPending.erase(url);
+    }
+}
+
+void ArtworkResolver::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_prewarmMutex);
+        m_stopping = true;
+        m_prewarmQueue.clear();
+        m_prewarmPending.clear();
+    }
+    m_prewarmCv.notify_all();
+
+    if (m_prewarmThread.joinable())
+    {
+        m_prewarmThread.join();
+    }
+}
+
+void ArtworkResolver::clear()
+{
+    m_resolvedUrls.clear();
+    m_reachability.clear();
+    m_warmedUrls.clear();
+}
+
+void ArtworkResolver::forgetServer(const std::string &serverUri)
+{
+    m_resolvedUrls.erasePrefix(serverUri + "|");
+    m_reachability.erase(serverUri);
+    m_reachability.erase(toHttps(serverUri));
+}
+
+std::vector<CacheStats> ArtworkResolver::stats() const
+{
+    return {m_resolvedUrls.stats(), m_reachability.stats(), m_warmedUrls.stats()};
+}
+
+bool ArtworkResolver::keys(const std::string &cacheName, size_t limit, std::vector<std::string> &keys) const
+{
+    if (cacheName == m_resolvedUrls.name())
+    {
+        keys = m_resolvedUrls.keys(limit);
+    }
+    else if (cacheName == m_reachability.name())
+    {
+        keys = m_reachability.keys(limit);
+    }
+    else if (cacheName == m_warmedUrls.name())
+    {
+        keys = m_warmedUrls.keys(limit);
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
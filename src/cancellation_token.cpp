@@ -0,0 +1,51 @@
+#include "cancellation_token.h"
+
+void CancellationToken::cancel() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    if (m_state->cancelled.exchange(true))
+    {
+        return;
+    }
+
+    for (auto &[id, listener] : m_state->listeners)
+    {
+        listener();
+    }
+    if (m_state->signal)
+    {
+        m_state->signal->notify();
+    }
+}
+
+size_t CancellationToken::addListener(Listener listener) const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    size_t id = m_state->nextListenerId++;
+    if (m_state->cancelled)
+    {
+        listener();
+    }
+    m_state->listeners.emplace(id, std::move(listener));
+    return id;
+}
+
+void CancellationToken::removeListener(size_t id) const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    m_state->listeners.erase(id);
+}
+
+WakeSignal *CancellationToken::signal() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    if (!m_state->signal)
+    {
+        m_state->signal = std::make_unique<WakeSignal>();
+        if (m_state->cancelled)
+        {
+            m_state->signal->notify();
+        }
+    }
+    return m_state->signal.get();
+}
@@ -1,4 +1,15 @@
 #include "config.h"
+#include "worker_pool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <sstream>
 
 Config &Config::getInstance()
 {
@@ -46,13 +57,34 @@ std::filesystem::path Config::getConfigDirectory()
 
 Config::Config()
 {
+    // Saves run on these singletons; creating them first makes them outlive
+    // this one, so the destructor can still cancel and wait for a save
+    TimerService::getInstance();
+    WorkerPool::getInstance();
+
     configPath = getConfigDirectory() / "config.yaml";
     loadConfig();
 }
 
 Config::~Config()
 {
-    saveConfig();
+    TimerService::TimerId timer;
+    {
+        std::lock_guard<std::mutex> lock(saveMutex);
+        closing = true;
+        timer = std::exchange(saveTimer, 0);
+    }
+    TimerService::getInstance().cancel(timer);
+
+    {
+        std::unique_lock<std::mutex> lock(saveMutex);
+        saveCv.wait(lock, [this]()
+                    { return !saveQueued; });
+    }
+
+    // Setters don't schedule a save themselves, so always write on exit
+    dirty = true;
+    flush();
 }
 
 bool Config::loadConfig()
@@ -86,6 +118,71 @@ bool Config::loadConfig()
 
 bool Config::saveConfig()
 {
+    dirty = true;
+
+    // A pending timer or write picks this change up as well
+    std::lock_guard<std::mutex> lock(saveMutex);
+    if (saveTimer == 0 && !saveQueued && !closing)
+    {
+        scheduleSaveLocked();
+    }
+    return true;
+}
+
+void Config::scheduleSaveLocked()
+{
+    saveTimer = TimerService::getInstance().schedule(SAVE_DELAY, [this]()
+                                                     {
+        {
+            std::lock_guard<std::mutex> lock(saveMutex);
+            if (closing)
+            {
+                return;
+            }
+            saveTimer = 0;
+            saveQueued = true;
+        }
+
+        // Disk writes are too slow for the timer thread
+        WorkerPool::getInstance().post([this]()
+                                       { runQueuedSave(); }); });
+}
+
+void Config::runQueuedSave()
+{
+    flush();
+
+    std::lock_guard<std::mutex> lock(saveMutex);
+    saveQueued = false;
+
+    // Changes made while the file was being written need another save
+    if (dirty && saveTimer == 0 && !closing)
+    {
+        scheduleSaveLocked();
+    }
+    saveCv.notify_all();
+}
+
+bool Config::flush()
+{
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (!dirty.exchange(false))
+    {
+        return true;
+    }
+
+    if (!writeFile())
+    {
+        // Keep the changes pending so the next save retries them
+        dirty = true;
+        return false;
+    }
+    return true;
+}
+
+bool Config::writeFile()
+{
+    std::string content;
     try
     {
         // Create the config directory if it doesn't exist
@@ -102,25 +199,84 @@ bool Config::saveConfig()
             configToSave = saveToYaml();
         }
 
-        // Write to file
-        std::ofstream ofs(configPath);
-        if (!ofs)
+        std::ostringstream out;
+        out << configToSave;
+        content = out.str();
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR("Config", "Error saving config: " + std::string(e.what()));
+        return false;
+    }
+
+    // Write a temporary file next to the config and move it over the old
+    // one, so readers and crashes only ever see a complete file
+    std::filesystem::path tempPath = configPath;
+    tempPath += ".tmp";
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(tempPath.wstring().c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        LOG_ERROR("Config", "Failed to open config file for writing");
+        return false;
+    }
+
+    DWORD written = 0;
+    bool ok = WriteFile(file, content.data(), static_cast<DWORD>(content.size()), &written, nullptr) &&
+              written == content.size() && FlushFileBuffers(file);
+    CloseHandle(file);
+    ok = ok && MoveFileExW(tempPath.wstring().c_str(), configPath.wstring().c_str(),
+                           MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1)
+    {
+        LOG_ERROR("Config", "Failed to open config file for writing");
+        return false;
+    }
+
+    bool ok = true;
+    size_t offset = 0;
+    while (ok && offset < content.size())
+    {
+        ssize_t written = ::write(fd, content.data() + offset, content.size() - offset);
+        if (written > 0)
         {
-            LOG_ERROR("Config", "Failed to open config file for writing");
-            return false;
+            offset += static_cast<size_t>(written);
         }
+        else if (written == 0 || errno != EINTR)
+        {
+            ok = false;
+        }
+    }
+    ok = ok && ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    ok = ok && ::rename(tempPath.c_str(), configPath.c_str()) == 0;
 
-        ofs << configToSave;
-        ofs.close();
-
-        LOG_INFO("Config", "Config saved successfully");
-        return true;
+    // Persist the rename itself
+    if (ok)
+    {
+        int dirFd = ::open(configPath.parent_path().c_str(), O_RDONLY | O_CLOEXEC);
+        if (dirFd != -1)
+        {
+            ::fsync(dirFd);
+            ::close(dirFd);
+        }
     }
-    catch (const std::exception &e)
+#endif
+
+    if (!ok)
     {
-        LOG_ERROR("Config", "Error saving config: " + std::string(e.what()));
+        LOG_ERROR("Config", "Failed to write config file");
+        std::error_code error;
+        std::filesystem::remove(tempPath, error);
         return false;
     }
+
+    LOG_INFO("Config", "Config saved successfully");
+    return true;
 }
 
 void Config::loadFromYaml(const YAML::Node &config)
@@ -149,6 +305,7 @@ void Config::loadFromYaml(const YAML::Node &config)
             std::string publicUri = server["public_uri"] ? server["public_uri"].as<std::string>() : "";
             std::string accessToken = server["access_token"] ? server["access_token"].as<std::string>() : "";
             bool owned = server["owned"] ? server["owned"].as<bool>() : false;
+            std::string notifications = server["notifications"] ? server["notifications"].as<std::string>() : "auto";
 
             auto serverPtr = std::make_shared<PlexServer>();
             serverPtr->name = name;
@@ -157,6 +314,18 @@ void Config::loadFromYaml(const YAML::Node &config)
             serverPtr->publicUri = publicUri;
             serverPtr->accessToken = accessToken;
             serverPtr->owned = owned;
+            if (notifications == "websocket")
+            {
+                serverPtr->notifications = NotificationProtocol::WebSocket;
+            }
+            else if (notifications == "sse")
+            {
+                serverPtr->notifications = NotificationProtocol::SSE;
+            }
+            else if (notifications != "auto")
+            {
+                LOG_WARNING("Config", "Unknown notifications setting for server " + name + ": " + notifications);
+            }
 
             plexServers[clientId] = serverPtr;
         }
@@ -175,6 +344,13 @@ void Config::loadFromYaml(const YAML::Node &config)
         tmdbAccessToken = config["tmdb_access_token"].as<std::string>();
     }
 
+    // Cache settings
+    if (config["cache"])
+    {
+        const auto &cache = config["cache"];
+        cacheMemoryBudget = cache["memory_budget_bytes"] ? cache["memory_budget_bytes"].as<size_t>() : cacheMemoryBudget.load();
+    }
+
     // Presence settings
     if (config["presence"])
     {
@@ -243,6 +419,9 @@ YAML::Node Config::saveToYaml() const
         serverNode["public_uri"] = server->publicUri;
         serverNode["access_token"] = server->accessToken;
         serverNode["owned"] = server->owned;
+        serverNode["notifications"] = server->notifications == NotificationProtocol::WebSocket ? "websocket"
+                                      : server->notifications == NotificationProtocol::SSE     ? "sse"
+                                                                                                : "auto";
         servers.push_back(serverNode);
     }
     config["plex_servers"] = servers;
@@ -263,6 +442,11 @@ YAML::Node Config::saveToYaml() const
     // TMDB API key
     config["tmdb_access_token"] = tmdbAccessToken;
 
+    // Cache settings
+    YAML::Node cache;
+    cache["memory_budget_bytes"] = cacheMemoryBudget.load();
+    config["cache"] = cache;
+
     // Presence settings
     YAML::Node presence;
     presence["show_music"] = showMusic;
@@ -296,6 +480,16 @@ void Config::setLogLevel(int level)
     logLevel.store(level);
 }
 
+size_t Config::getCacheMemoryBudget() const
+{
+    return cacheMemoryBudget.load();
+}
+
+void Config::setCacheMemoryBudget(size_t bytes)
+{
+    cacheMemoryBudget.store(bytes);
+}
+
 // Plex settings
 std::string Config::getPlexAuthToken() const
 {
@@ -333,12 +527,19 @@ void Config::setPlexUsername(const std::string &username)
     plexUsername = username;
 }
 
-const std::map<std::string, std::shared_ptr<PlexServer>> &Config::getPlexServers() const
+std::map<std::string, std::shared_ptr<PlexServer>> Config::getPlexServers() const
 {
     std::shared_lock lock(mutex);
     return plexServers;
 }
 
+std::shared_ptr<PlexServer> Config::getPlexServer(const std::string &clientId) const
+{
+    std::shared_lock lock(mutex);
+    auto it = plexServers.find(clientId);
+    return it != plexServers.end() ? it->second : nullptr;
+}
+
 void Config::addPlexServer(const std::string &name, const std::string &clientId,
                            const std::string &localUri, const std::string &publicUri,
                            const std::string &accessToken, bool owned)
@@ -369,6 +570,19 @@ void Config::addPlexServer(const std::string &name, const std::string &clientId,
     plexServers[clientId] = server;
 }
 
+void Config::setPlexServer(std::shared_ptr<PlexServer> server)
+{
+    std::unique_lock lock(mutex);
+    std::string clientId = server->clientIdentifier;
+    plexServers[clientId] = std::move(server);
+}
+
+bool Config::removePlexServer(const std::string &clientId)
+{
+    std::unique_lock lock(mutex);
+    return plexServers.erase(clientId) > 0;
+}
+
 void Config::clearPlexServers()
 {
     std::unique_lock lock(mutex);
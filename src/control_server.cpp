@@ -0,0 +1,390 @@
+#include "control_server.h"
+#include "config.h"
+#include "logger.h"
+
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // macOS: SO_NOSIGPIPE is set on the socket instead
+#endif
+#endif
+
+namespace
+{
+    constexpr size_t MAX_REQUEST_BYTES = 4096;
+    constexpr size_t MAX_RESPONSE_BYTES = 16 * 1024 * 1024;
+    constexpr int REQUEST_TIMEOUT_MS = 1000;   // For a client to send its request
+    constexpr int RESPONSE_TIMEOUT_MS = 10000; // For the instance to answer
+
+    std::vector<std::string> splitWords(const std::string &line)
+    {
+        std::vector<std::string> words;
+        std::istringstream stream(line);
+        std::string word;
+        while (stream >> word)
+        {
+            words.push_back(word);
+        }
+        return words;
+    }
+
+    std::string errorResponse(const std::string &message)
+    {
+        return nlohmann::json{{"ok", false}, {"error", message}}.dump();
+    }
+
+#ifndef _WIN32
+    bool makeAddress(const std::filesystem::path &path, sockaddr_un &address)
+    {
+        std::string native = path.string();
+        if (native.size() >= sizeof(address.sun_path))
+        {
+            return false;
+        }
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, native.c_str(), native.size() + 1);
+        return true;
+    }
+
+    void prepareSocket(int fd)
+    {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    }
+
+    // Milliseconds left until deadline, at least 0
+    int remainingMs(std::chrono::steady_clock::time_point deadline)
+    {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        return left.count() > 0 ? static_cast<int>(left.count()) : 0;
+    }
+
+    // Waits until fd is ready for events; false on timeout or error
+    bool waitReady(int fd, short events, std::chrono::steady_clock::time_point deadline)
+    {
+        while (true)
+        {
+            struct pollfd fds = {fd, events, 0};
+            int result = poll(&fds, 1, remainingMs(deadline));
+            if (result > 0)
+            {
+                return true;
+            }
+            if (result == 0 || errno != EINTR)
+            {
+                return false;
+            }
+        }
+    }
+
+    bool writeAll(int fd, const std::string &data, std::chrono::steady_clock::time_point deadline)
+    {
+        size_t written = 0;
+        while (written < data.size())
+        {
+            ssize_t n = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+            if (n > 0)
+            {
+                written += static_cast<size_t>(n);
+            }
+            else if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                if (!waitReady(fd, POLLOUT, deadline))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Reads until a newline or end of stream; false on timeout, error or a
+    // line longer than maxBytes
+    bool readLine(int fd, std::string &line, size_t maxBytes, std::chrono::steady_clock::time_point deadline)
+    {
+        char buffer[512];
+        while (line.find('\n') == std::string::npos)
+        {
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n > 0)
+            {
+                line.append(buffer, static_cast<size_t>(n));
+                if (line.size() > maxBytes && line.find('\n') == std::string::npos)
+                {
+                    return false;
+                }
+            }
+            else if (n == 0)
+            {
+                return !line.empty();
+            }
+            else if (errno == EINTR)
+            {
+                continue;
+            }
+            else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                if (!waitReady(fd, POLLIN, deadline))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                return false;
+            }
+        }
+        line.erase(line.find('\n'));
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        return true;
+    }
+#endif
+}
+
+ControlServer::~ControlServer()
+{
+    stop();
+}
+
+std::filesystem::path ControlServer::socketPath()
+{
+    return Config::getConfigDirectory() / "control.sock";
+}
+
+void ControlServer::addCommand(const std::string &name, const std::string &usage, Handler handler)
+{
+    m_commands[name] = {usage, std::move(handler)};
+}
+
+bool ControlServer::start()
+{
+#ifdef _WIN32
+    LOG_INFO("ControlServer", "The control socket is not available on Windows");
+    return false;
+#else
+    m_path = socketPath();
+    sockaddr_un address;
+    if (!makeAddress(m_path, address))
+    {
+        LOG_WARNING("ControlServer", "Control socket path is too long: " + m_path.string());
+        return false;
+    }
+
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listenFd < 0)
+    {
+        LOG_WARNING("ControlServer", "Failed to create control socket: " + std::string(strerror(errno)));
+        return false;
+    }
+    prepareSocket(m_listenFd);
+
+    // Only one instance runs at a time, so an existing socket is left over
+    // from a crash. The umask keeps the socket private between bind() and
+    // chmod().
+    std::error_code ignored;
+    std::filesystem::remove(m_path, ignored);
+    mode_t previousMask = umask(0177);
+    int bound = bind(m_listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    umask(previousMask);
+    if (bound < 0 || chmod(m_path.c_str(), 0600) < 0 || listen(m_listenFd, 8) < 0)
+    {
+        LOG_WARNING("ControlServer", "Failed to listen on " + m_path.string() + ": " + std::string(strerror(errno)));
+        close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+
+    m_stopSignal.reset();
+    m_thread = std::thread(&ControlServer::serveLoop, this);
+    LOG_INFO("ControlServer", "Listening on " + m_path.string());
+    return true;
+#endif
+}
+
+void ControlServer::stop()
+{
+#ifndef _WIN32
+    m_stopSignal.notify();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    if (m_listenFd >= 0)
+    {
+        close(m_listenFd);
+        m_listenFd = -1;
+        std::error_code ignored;
+        std::filesystem::remove(m_path, ignored);
+    }
+#endif
+}
+
+void ControlServer::serveLoop()
+{
+#ifndef _WIN32
+    while (!m_stopSignal.isSet())
+    {
+        struct pollfd fds[2];
+        fds[0] = {m_listenFd, POLLIN, 0};
+        fds[1] = {m_stopSignal.fd(), POLLIN, 0};
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            LOG_ERROR("ControlServer", "Error polling control socket: " + std::string(strerror(errno)));
+            return;
+        }
+        if (!(fds[0].revents & POLLIN))
+        {
+            continue;
+        }
+
+        int clientFd = accept(m_listenFd, nullptr, nullptr);
+        if (clientFd < 0)
+        {
+            continue; // The client gave up, or EINTR
+        }
+        prepareSocket(clientFd);
+        serveClient(clientFd);
+        close(clientFd);
+    }
+#endif
+}
+
+void ControlServer::serveClient(int clientFd)
+{
+#ifndef _WIN32
+    // A client that is slow to send its line must not hold up the next one
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(REQUEST_TIMEOUT_MS);
+    std::string line;
+    if (!readLine(clientFd, line, MAX_REQUEST_BYTES, deadline))
+    {
+        LOG_DEBUG("ControlServer", "Dropped a client that sent no complete request");
+        return;
+    }
+
+    std::string response = handleRequest(line) + "\n";
+    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(REQUEST_TIMEOUT_MS);
+    if (!writeAll(clientFd, response, deadline))
+    {
+        LOG_DEBUG("ControlServer", "Failed to send a response");
+    }
+#else
+    (void)clientFd;
+#endif
+}
+
+std::string ControlServer::handleRequest(const std::string &line)
+{
+    auto words = splitWords(line);
+    if (words.empty())
+    {
+        return errorResponse("Empty request");
+    }
+
+    std::string name = words.front();
+    words.erase(words.begin());
+    LOG_DEBUG("ControlServer", "Request: " + line);
+
+    if (name == "help")
+    {
+        nlohmann::json commands = nlohmann::json::object();
+        for (const auto &[commandName, command] : m_commands)
+        {
+            commands[commandName] = command.usage;
+        }
+        return nlohmann::json{{"ok", true}, {"result", commands}}.dump();
+    }
+
+    auto it = m_commands.find(name);
+    if (it == m_commands.end())
+    {
+        return errorResponse("Unknown command: " + name + " (try help)");
+    }
+
+    try
+    {
+        nlohmann::json result = it->second.handler(words);
+        return nlohmann::json{{"ok", true}, {"result", result}}.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        return errorResponse(std::string(e.what()) + "; usage: " + name + " " + it->second.usage);
+    }
+    catch (const std::exception &e)
+    {
+        LOG_WARNING("ControlServer", "Command " + name + " failed: " + e.what());
+        return errorResponse(e.what());
+    }
+}
+
+bool ControlServer::request(const std::string &line, std::string &response)
+{
+#ifdef _WIN32
+    (void)line;
+    response = "The control socket is not available on Windows";
+    return false;
+#else
+    auto path = socketPath();
+    sockaddr_un address;
+    if (!makeAddress(path, address))
+    {
+        response = "Control socket path is too long: " + path.string();
+        return false;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        response = "Failed to create socket: " + std::string(strerror(errno));
+        return false;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        response = "No running instance at " + path.string() + ": " + std::string(strerror(errno));
+        close(fd);
+        return false;
+    }
+    prepareSocket(fd);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(RESPONSE_TIMEOUT_MS);
+    response.clear();
+    bool answered = writeAll(fd, line + "\n", deadline) && readLine(fd, response, MAX_RESPONSE_BYTES, deadline);
+    close(fd);
+    if (!answered)
+    {
+        response = "The running instance did not answer";
+    }
+    return answered;
+#endif
+}
@@ -13,6 +13,14 @@ constexpr int MIN_FRAME_INTERVAL_SECONDS = 1;
 constexpr int MAX_FRAMES_SHORT_WINDOW = 3;
 constexpr int RATE_LIMIT_SHORT_WINDOW = 5;
 
+// How long Discord gets to answer a request before it is considered hung,
+// and how often an idle connection is pinged (in seconds)
+constexpr int REQUEST_TIMEOUT_SECONDS = 5;
+constexpr int HEALTH_CHECK_INTERVAL_SECONDS = 60;
+
+// PONG frames carry no nonce; the outstanding ping is tracked under this key
+constexpr const char *PING_NONCE = "ping";
+
 using json = nlohmann::json;
 
 Discord::Discord() : running(false),
@@ -40,6 +48,23 @@ void Discord::connectionThread()
 	LOG_INFO("Discord", "Connection thread started");
 	while (running)
 	{
+		if (reconnect_requested.exchange(false))
+		{
+			// stop() clears running before it notifies, so a notification
+			// swallowed by this reset is never missed
+			stop_signal.reset();
+			if (!running)
+			{
+				break;
+			}
+			LOG_INFO("Discord", "Reconnect requested");
+			if (ipc.isConnected())
+			{
+				connectionLost();
+			}
+			reconnect_attempts = 0;
+		}
+
 		// Handle connection logic
 		if (!ipc.isConnected())
 		{
@@ -52,18 +77,15 @@ void Discord::connectionThread()
 				LOG_INFO("Discord", "Reconnection attempt " + std::to_string(reconnect_attempts) +
 										", waiting " + std::to_string(delay) + " seconds");
 
-				for (int i = 0; i < delay * 2 && running; ++i)
-				{
-					std::this_thread::sleep_for(std::chrono::milliseconds(500));
-					if (i % 10 == 0)
-					{
-						processQueuedFrame(); // Process frames more frequently during wait
-					}
-				}
+				bool woken = stop_signal.waitFor(std::chrono::seconds(delay));
 				if (!running)
 				{
 					break;
 				}
+				if (woken)
+				{
+					continue; // reconnect() cut the wait short
+				}
 			}
 
 			reconnect_attempts++;
@@ -86,42 +108,186 @@ void Discord::connectionThread()
 		}
 		else
 		{
-			LOG_DEBUG("Discord", "Checking Discord connection health");
-
-			if (!isStillAlive())
+			// This thread is the only reader: it takes every frame Discord sends
+			// and matches it to its request, while other threads write freely
+			auto now = std::chrono::steady_clock::now();
+			if (now >= next_health_check)
 			{
-				LOG_INFO("Discord", "Connection to Discord lost, will reconnect");
-				if (ipc.isConnected())
+				LOG_DEBUG("Discord", "Checking Discord connection health");
+				next_health_check = now + std::chrono::seconds(HEALTH_CHECK_INTERVAL_SECONDS);
+				if (!pingIfIdle())
 				{
-					ipc.closePipe();
+					connectionLost();
+					continue;
 				}
-				needs_reconnect = true;
+			}
 
-				// Call disconnected callback if set
-				if (onDisconnected)
-				{
-					onDisconnected();
-				}
+			auto wake_at = (std::min)(next_health_check, nextRequestDeadline());
+			auto timeout = std::chrono::ceil<std::chrono::milliseconds>(wake_at - std::chrono::steady_clock::now());
+
+			int opcode;
+			std::string data;
+			switch (ipc.readFrame(opcode, data, (std::max)(timeout, std::chrono::milliseconds(0))))
+			{
+			case DiscordIPC::ReadResult::Frame:
+				handleFrame(opcode, data);
+				break;
+			case DiscordIPC::ReadResult::Interrupted:
+				continue; // stop() was called
+			case DiscordIPC::ReadResult::Closed:
+				connectionLost();
 				continue;
+			case DiscordIPC::ReadResult::Timeout:
+				break;
 			}
-			else
+
+			if (!expireRequests())
 			{
-				needs_reconnect = false;
+				connectionLost();
 			}
-
-			// Connection health check sleep
-			for (int i = 0; i < 600 && running && !needs_reconnect; ++i) // 600 * 100ms = 60s
+			else if (ipc.isConnected())
 			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(100));
-				if (i % 10 == 0)
-				{
-					processQueuedFrame();
-				}
+				needs_reconnect = false;
 			}
 		}
 	}
 }
 
+void Discord::connectionLost()
+{
+	if (!running)
+	{
+		return;
+	}
+
+	LOG_INFO("Discord", "Connection to Discord lost, will reconnect");
+	if (ipc.isConnected())
+	{
+		ipc.closePipe();
+	}
+	needs_reconnect = true;
+
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex);
+		pending_requests.clear();
+	}
+
+	// Call disconnected callback if set
+	if (onDisconnected)
+	{
+		onDisconnected();
+	}
+}
+
+void Discord::trackRequest(const std::string &nonce)
+{
+	auto now = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	pending_requests[nonce] = PendingRequest{now, now + std::chrono::seconds(REQUEST_TIMEOUT_SECONDS)};
+}
+
+void Discord::forgetRequest(const std::string &nonce)
+{
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	pending_requests.erase(nonce);
+}
+
+bool Discord::completeRequest(const std::string &nonce)
+{
+	auto now = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	auto it = pending_requests.find(nonce);
+	if (it == pending_requests.end())
+	{
+		return false;
+	}
+
+	auto round_trip = std::chrono::duration_cast<std::chrono::microseconds>(now - it->second.sent);
+	round_trips.add(round_trip);
+	++completed_requests;
+	pending_requests.erase(it);
+	LOG_DEBUG_STREAM("Discord", "Request " << nonce << " answered in " << round_trip.count() / 1000.0 << " ms");
+	return true;
+}
+
+std::chrono::steady_clock::time_point Discord::nextRequestDeadline()
+{
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	auto earliest = std::chrono::steady_clock::time_point::max();
+	for (const auto &[nonce, request] : pending_requests)
+	{
+		earliest = (std::min)(earliest, request.deadline);
+	}
+	return earliest;
+}
+
+bool Discord::expireRequests()
+{
+	auto now = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	bool healthy = true;
+	for (auto it = pending_requests.begin(); it != pending_requests.end();)
+	{
+		if (it->second.deadline > now)
+		{
+			++it;
+			continue;
+		}
+
+		LOG_WARNING_STREAM("Discord", "Discord did not answer request " << it->first << " within "
+																		<< REQUEST_TIMEOUT_SECONDS << " seconds");
+		++timed_out_requests;
+		healthy = false;
+		it = pending_requests.erase(it);
+	}
+	return healthy;
+}
+
+void Discord::handleFrame(int opcode, const std::string &data)
+{
+	switch (opcode)
+	{
+	case OP_PONG:
+		completeRequest(PING_NONCE);
+		return;
+	case OP_PING:
+		// Discord checking on us; answer with the same payload
+		ipc.writeFrame(OP_PONG, data);
+		return;
+	case OP_CLOSE:
+		// Usually an answer to the frame just sent, whose request would
+		// otherwise expire on the next connection
+		LOG_WARNING("Discord", "Discord closed the connection: " + data);
+		connectionLost();
+		return;
+	case OP_FRAME:
+		break;
+	default:
+		LOG_DEBUG_STREAM("Discord", "Ignoring frame with unknown opcode " << opcode);
+		return;
+	}
+
+	try
+	{
+		json frame = json::parse(data);
+		std::string nonce = frame.contains("nonce") && frame["nonce"].is_string() ? frame["nonce"].get<std::string>() : "";
+		bool answered = !nonce.empty() && completeRequest(nonce);
+
+		if (frame.value("evt", json()).is_string() && frame["evt"] == "ERROR")
+		{
+			LOG_WARNING_STREAM("Discord", "Discord rejected " << (answered ? "request " + nonce : "a request") << ": " << data);
+		}
+		else if (!answered)
+		{
+			LOG_DEBUG("Discord", "Unsolicited frame from Discord: " + data);
+		}
+	}
+	catch (const std::exception &e)
+	{
+		LOG_WARNING_STREAM("Discord", "Failed to parse frame from Discord: " << e.what());
+	}
+}
+
 bool Discord::attemptConnection()
 {
 	for (int i = 0; i < 10; ++i)
@@ -149,7 +315,8 @@ bool Discord::attemptConnection()
 	int opcode;
 	std::string response;
 	LOG_DEBUG("Discord", "Waiting for handshake response");
-	if (!ipc.readFrame(opcode, response) || opcode != OP_FRAME)
+	if (ipc.readFrame(opcode, response, std::chrono::seconds(REQUEST_TIMEOUT_SECONDS)) != DiscordIPC::ReadResult::Frame ||
+		opcode != OP_FRAME)
 	{
 		LOG_ERROR("Discord", "Failed to read handshake response. Opcode: " + std::to_string(opcode));
 		if (!response.empty())
@@ -206,7 +373,7 @@ bool Discord::attemptConnection()
 
 void Discord::updatePresence(const MediaInfo &info)
 {
-	LOG_DEBUG_STREAM("Discord", "updatePresence called for title: " << info.title);
+	LOG_DEBUG_STREAM("Discord", "updatePresence called for title: " << info.meta().title);
 
 	if (!ipc.isConnected())
 	{
@@ -216,25 +383,25 @@ void Discord::updatePresence(const MediaInfo &info)
 
 	std::lock_guard<std::mutex> lock(mutex);
 
-	if (info.state == PlaybackState::Playing ||
-		info.state == PlaybackState::Paused ||
-		info.state == PlaybackState::Buffering)
+	if (info.playback.state == PlaybackState::Playing ||
+		info.playback.state == PlaybackState::Paused ||
+		info.playback.state == PlaybackState::Buffering)
 	{
-		std::string stateStr = (info.state == PlaybackState::Playing) ? "playing" : (info.state == PlaybackState::Paused) ? "paused"
+		std::string stateStr = (info.playback.state == PlaybackState::Playing) ? "playing" : (info.playback.state == PlaybackState::Paused) ? "paused"
 																														  : "buffering";
 		LOG_DEBUG_STREAM("Discord", "Media is " << stateStr << ", updating presence");
 
 		is_playing = true;
 
-		std::string nonce = generateNonce();
-		std::string presence = createPresence(info, nonce);
+		Activity activity;
+		bool visible = createActivity(info, activity);
 
-		LOG_INFO_STREAM("Discord", "Queuing presence update: " << info.title << " - " << info.username
-															   << (info.state == PlaybackState::Paused ? " (Paused)" : "")
-															   << (info.state == PlaybackState::Buffering ? " (Buffering)" : ""));
+		LOG_INFO_STREAM("Discord", "Queuing presence update: " << info.meta().title << " - " << info.username.str()
+															   << (info.playback.state == PlaybackState::Paused ? " (Paused)" : "")
+															   << (info.playback.state == PlaybackState::Buffering ? " (Buffering)" : ""));
 
-		// Queue the presence update
-		queuePresenceMessage(presence);
+		// Queue the presence update; hidden media types clear the activity
+		queuePresence(visible ? &activity : nullptr);
 
 		// Attempt to send it immediately
 		processQueuedFrame();
@@ -260,36 +427,64 @@ std::string Discord::generateNonce()
 	return std::to_string(++nonce_counter);
 }
 
-std::string Discord::createPresence(const MediaInfo &info, const std::string &nonce)
+void Discord::writePresence(std::string &frame, const Activity *activity, const std::string &nonce)
 {
-	json activity = createActivity(info);
-
 #ifdef _WIN32
 	auto process_id = static_cast<int>(GetCurrentProcessId());
 #else
 	auto process_id = static_cast<int>(getpid());
 #endif
 
-	json args = {
-		{"pid", process_id},
-		{"activity", activity}};
+	JsonWriter writer(frame);
+	writer.beginObject()
+		.field("cmd", "SET_ACTIVITY")
+		.key("args")
+		.beginObject()
+		.field("pid", process_id)
+		.key("activity");
 
-	json presence = {{"cmd", "SET_ACTIVITY"}, {"args", args}, {"nonce", nonce}};
-
-	return presence.dump();
-}
-
-std::string Discord::createPresenceMetadata(const MediaInfo &info, const std::string &nonce)
-{
-	json activity = createActivity(info);
+	if (!activity)
+	{
+		writer.null();
+	}
+	else
+	{
+		writer.beginObject()
+			.field("type", activity->type)
+			.field("name", "Plex")
+			.field("state", activity->state)
+			.field("details", activity->details)
+			.key("timestamps")
+			.beginObject()
+			.field("start", activity->start)
+			.field("end", activity->end)
+			.endObject()
+			.key("assets")
+			.beginObject()
+			.field("large_image", activity->largeImage);
+		if (!activity->largeText.empty())
+		{
+			writer.field("large_text", activity->largeText);
+		}
+		if (!activity->smallImage.empty())
+		{
+			writer.field("small_image", activity->smallImage).field("small_text", activity->smallText);
+		}
+		writer.endObject().field("instance", true);
 
-	json presence = {
-		{"cmd", "SET_ACTIVITY"},
-		{"data", activity},
-		{"evt", nullptr},
-		{"nonce", nonce}};
+		if (!activity->buttons.empty())
+		{
+			writer.key("buttons").beginArray();
+			for (const auto &[label, url] : activity->buttons)
+			{
+				writer.beginObject().field("label", label).field("url", url).endObject();
+			}
+			writer.endArray();
+		}
+		writer.endObject();
+	}
 
-	return presence.dump();
+	writer.endObject().field("nonce", nonce).endObject();
 }
 
 // Helper function to format bitrate
@@ -329,46 +524,46 @@ std::string formatResolution(const std::string& resolution)
 }
 
 
-json Discord::createActivity(const MediaInfo &info)
+bool Discord::createActivity(const MediaInfo &info, Activity &activity)
 {
+	const MediaMetadata &meta = info.meta();
 	std::string state;
 	std::string details;
 	std::string large_text;
-	json assets = {};
 	int activityType = 3; // Default: Watching
 
 	// Default large image
-	assets["large_image"] = "plex";
+	activity.largeImage = "plex";
 
-	if (info.type == MediaType::Music && Config::getInstance().getGatekeepMusic())
+	if (meta.type == MediaType::Music && Config::getInstance().getGatekeepMusic())
 	{
-		if (info.mediaKey != last_media_key)
+		if (meta.mediaKey != last_media_key)
 		{
 			std::vector<std::string> art = {"gate1", "gate2", "gate3", "gate4"};
 			int randomIndex = rand() % art.size();
 			current_gate_art = art[randomIndex];
-			last_media_key = info.mediaKey;
+			last_media_key = meta.mediaKey;
 		}
-		assets["large_image"] = current_gate_art;
+		activity.largeImage = current_gate_art;
 	}
-	else if (!info.artPath.empty())
+	else if (!meta.artPath.empty())
 	{
-		assets["large_image"] = info.artPath;
-		LOG_INFO("Discord", "Using artwork URL: " + info.artPath);
+		activity.largeImage = meta.artPath;
+		LOG_INFO("Discord", "Using artwork URL: " + meta.artPath);
 	}
 	else
 	{
-		assets["large_image"] = "plex";
+		activity.largeImage = "plex";
 	}
 
-	if (info.type == MediaType::TVShow)
+	if (meta.type == MediaType::TVShow)
 	{
 		if (!Config::getInstance().getShowTVShows())
 		{
-			return {};
+			return false;
 		}
 		activityType = 3; // Watching
-		details = info.grandparentTitle; // Show Title
+		details = meta.grandparentTitle; // Show Title
 		
 		std::string tvShowFormat = Config::getInstance().getTVShowFormat();
 		std::string seasonFormat = Config::getInstance().getSeasonFormat();
@@ -377,25 +572,25 @@ json Discord::createActivity(const MediaInfo &info)
 		size_t pos = seasonFormat.find("{season_num}");
 		if (pos != std::string::npos)
 		{
-			seasonFormat.replace(pos, std::string("{season_num}").length(), std::to_string(info.season));
+			seasonFormat.replace(pos, std::string("{season_num}").length(), std::to_string(meta.season));
 		}
 
 		pos = episodeFormat.find("{episode_num}");
 		if (pos != std::string::npos)
 		{
-			episodeFormat.replace(pos, std::string("{episode_num}").length(), std::to_string(info.episode));
+			episodeFormat.replace(pos, std::string("{episode_num}").length(), std::to_string(meta.episode));
 		}
 
 		pos = tvShowFormat.find("{show_title}");
 		if (pos != std::string::npos)
 		{
-			tvShowFormat.replace(pos, std::string("{show_title}").length(), info.grandparentTitle);
+			tvShowFormat.replace(pos, std::string("{show_title}").length(), meta.grandparentTitle);
 		}
 
 		pos = tvShowFormat.find("{episode_title}");
 		if (pos != std::string::npos)
 		{
-			tvShowFormat.replace(pos, std::string("{episode_title}").length(), info.title);
+			tvShowFormat.replace(pos, std::string("{episode_title}").length(), meta.title);
 		}
 
 		pos = tvShowFormat.find("{season_episode}");
@@ -419,26 +614,26 @@ json Discord::createActivity(const MediaInfo &info)
 		state = tvShowFormat;
 		
 		std::stringstream large_text_ss;
-		if (Config::getInstance().getShowClient() && !info.client.empty())
+		if (Config::getInstance().getShowClient() && !info.client.str().empty())
 		{
-			large_text_ss << "Watching on " << info.client;
+			large_text_ss << "Watching on " << info.client.str();
 		}
 		else
 		{
-			std::string formatted_resolution = formatResolution(info.videoResolution);
+			std::string formatted_resolution = formatResolution(meta.videoResolution.str());
 			if (!formatted_resolution.empty() && Config::getInstance().getShowTVShowQuality())
 			{
 				large_text_ss << formatted_resolution;
 			}
 
-			std::string formatted_bitrate = formatBitrate(info.bitrate);
+			std::string formatted_bitrate = formatBitrate(meta.bitrate);
 			if (!formatted_bitrate.empty() && Config::getInstance().getShowTVShowBitrate())
 			{
 				if (large_text_ss.str().length() > 0) { large_text_ss << " • "; }
 				large_text_ss << formatted_bitrate;
 			}
 			
-			std::string lower_filename = info.filename;
+			std::string lower_filename = meta.filename;
 			std::transform(lower_filename.begin(), lower_filename.end(), lower_filename.begin(),
 						   [](unsigned char c){ return std::tolower(c); });
 
@@ -450,25 +645,25 @@ json Discord::createActivity(const MediaInfo &info)
 		}
 		large_text = large_text_ss.str();
 	}
-	else if (info.type == MediaType::Movie)
+	else if (meta.type == MediaType::Movie)
 	{
 		LOG_DEBUG("Discord", "Creating activity for a movie");
 		if (!Config::getInstance().getShowMovies())
 		{
 			LOG_DEBUG("Discord", "Movie activity is disabled, returning empty activity");
-			return {};
+			return false;
 		}
 		activityType = 3; // Watching
-		details = info.title + " (" + std::to_string(info.year) + ")";
+		details = meta.title + " (" + std::to_string(meta.year) + ")";
 		
 		std::stringstream state_ss;
-		std::string formatted_resolution = formatResolution(info.videoResolution);
+		std::string formatted_resolution = formatResolution(meta.videoResolution.str());
 		if (!formatted_resolution.empty() && Config::getInstance().getShowMovieQuality())
 		{
 			state_ss << formatted_resolution;
 		}
 
-		std::string formatted_bitrate = formatBitrate(info.bitrate);
+		std::string formatted_bitrate = formatBitrate(meta.bitrate);
 		if (!formatted_bitrate.empty() && Config::getInstance().getShowMovieBitrate())
 		{
 			if (state_ss.str().length() > 0) { state_ss << " • "; }
@@ -476,7 +671,7 @@ json Discord::createActivity(const MediaInfo &info)
 		}
 
         // Check for Blu-ray or REMUX in the filename
-        std::string lower_filename = info.filename;
+        std::string lower_filename = meta.filename;
         std::transform(lower_filename.begin(), lower_filename.end(), lower_filename.begin(),
                        [](unsigned char c){ return std::tolower(c); });
 
@@ -487,17 +682,17 @@ json Discord::createActivity(const MediaInfo &info)
         }
 		state = state_ss.str();
 
-        if (Config::getInstance().getShowClient() && !info.client.empty())
+        if (Config::getInstance().getShowClient() && !info.client.str().empty())
         {
-			large_text = "Watching on " + info.client;
+			large_text = "Watching on " + info.client.str();
         }
 		LOG_DEBUG_STREAM("Discord", "Movie activity created: details='" << details << "', state='" << state << "', large_text='" << large_text << "'");
 	}
-	else if (info.type == MediaType::Music)
+	else if (meta.type == MediaType::Music)
 	{
 		if (!Config::getInstance().getShowMusic())
 		{
-			return {};
+			return false;
 		}
 		activityType = 2; // Listening
 
@@ -516,13 +711,13 @@ json Discord::createActivity(const MediaInfo &info)
 		}
 		else
 		{
-			details = info.title; // Track Title
-			state = info.artist + " - " + info.album;
+			details = meta.title; // Track Title
+			state = meta.artist + " - " + meta.album;
 		}
 
 		if (Config::getInstance().getShowFlacAsCD())
 		{
-			std::string lower_filename = info.filename;
+			std::string lower_filename = meta.filename;
 			std::transform(lower_filename.begin(), lower_filename.end(), lower_filename.begin(),
 						   [](unsigned char c)
 						   { return std::tolower(c); });
@@ -530,13 +725,13 @@ json Discord::createActivity(const MediaInfo &info)
 			if (lower_filename.find("flac") != std::string::npos)
 			{
 				std::string flac_quality;
-				if (info.audioSamplingRate > 0 && info.audioBitDepth > 0)
+				if (meta.audioSamplingRate > 0 && meta.audioBitDepth > 0)
 				{
 					// Convert sampling rate to kHz if it's a large number
-					double samplingRateKHz = info.audioSamplingRate / 1000.0;
+					double samplingRateKHz = meta.audioSamplingRate / 1000.0;
 					std::stringstream ss;
 					ss << std::fixed << std::setprecision(1) << samplingRateKHz;
-					flac_quality = ss.str() + "/" + std::to_string(info.audioBitDepth) + " FLAC";
+					flac_quality = ss.str() + "/" + std::to_string(meta.audioBitDepth) + " FLAC";
 				}
 				else
 				{
@@ -549,24 +744,24 @@ json Discord::createActivity(const MediaInfo &info)
 	else // Unknown or other types
 	{
 		activityType = 0; // Playing (generic)
-		details = info.title;
+		details = meta.title;
 		state = "Playing media";
-		assets["large_text"] = info.title;
+		large_text = meta.title;
 	}
 
-	if (info.state == PlaybackState::Buffering)
+	if (info.playback.state == PlaybackState::Buffering)
 	{
 		state = "🔄 Buffering...";
 		// Keep existing details
 	}
-	else if (info.state == PlaybackState::Paused)
+	else if (info.playback.state == PlaybackState::Paused)
 	{
-		assets["small_image"] = "pause";
-		assets["small_text"] = "Paused";
+		activity.smallImage = "pause";
+		activity.smallText = "Paused";
 		// Keep existing details and state
 	}
 
-	else if (info.state == PlaybackState::Stopped)
+	else if (info.playback.state == PlaybackState::Stopped)
 	{
 		// This case might not be reached if filtering happens earlier, but good practice
 		state = "Stopped";
@@ -589,10 +784,7 @@ json Discord::createActivity(const MediaInfo &info)
 		state = "Idle"; // Fallback if state somehow ends up empty
 	}
 
-	if (!large_text.empty())
-	{
-		assets["large_text"] = large_text;
-	}
+	activity.largeText = large_text;
 
 	// Calculate timestamps for progress bar
 	auto now = std::chrono::system_clock::now();
@@ -600,117 +792,82 @@ json Discord::createActivity(const MediaInfo &info)
 	int64_t start_timestamp = 0;
 	int64_t end_timestamp = 0;
 
-	if (info.state == PlaybackState::Playing)
+	if (info.playback.state == PlaybackState::Playing)
 	{
-		start_timestamp = current_time - static_cast<int64_t>(info.progress);
-		end_timestamp = current_time + static_cast<int64_t>(info.duration - info.progress);
+		start_timestamp = current_time - static_cast<int64_t>(info.playback.progress);
+		end_timestamp = current_time + static_cast<int64_t>(meta.duration - info.playback.progress);
 	}
-	else if (info.state == PlaybackState::Paused || info.state == PlaybackState::Buffering)
+	else if (info.playback.state == PlaybackState::Paused || info.playback.state == PlaybackState::Buffering)
 	{
 		auto max_duration = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::hours(MAX_PAUSED_DURATION))
 								.count();
 		start_timestamp = current_time + max_duration;
-		end_timestamp = start_timestamp + static_cast<int64_t>(info.duration);
+		end_timestamp = start_timestamp + static_cast<int64_t>(meta.duration);
 	}
 
-	json timestamps = {
-		{"start", start_timestamp},
-		{"end", end_timestamp}};
-
-	json buttons = {};
+	activity.start = start_timestamp;
+	activity.end = end_timestamp;
 
 	// Add relevant buttons based on available IDs
-	if (info.type == MediaType::Music && !Config::getInstance().getGatekeepMusic())
-	{
-		buttons.push_back({{"label", "Search on YouTube"},
-						   {"url", "https://www.youtube.com/results?search_query=" + utils::urlEncode(info.artist + " " + info.title)}});
-	}
-	else if (!info.imdbId.empty())
-	{
-		buttons.push_back({{"label", "View on IMDb"},
-						   {"url", "https://www.imdb.com/title/" + info.imdbId}});
-	}
-	else if (!info.malId.empty())
+	if (meta.type == MediaType::Music && !Config::getInstance().getGatekeepMusic())
 	{
-		buttons.push_back({{"label", "View on MyAnimeList"},
-						   {"url", "https://myanimelist.net/anime/" + info.malId}});
+		activity.buttons.emplace_back("Search on YouTube",
+									  "https://www.youtube.com/results?search_query=" + utils::urlEncode(meta.artist + " " + meta.title));
 	}
-	else if (!info.imdbId.empty())
+	else if (!meta.imdbId.empty())
 	{
-		buttons.push_back({{"label", "View on IMDb"},
-						   {"url", "https://www.imdb.com/title/" + info.imdbId}});
+		activity.buttons.emplace_back("View on IMDb", "https://www.imdb.com/title/" + meta.imdbId);
 	}
-
-	json ret = {
-		{"type", activityType},
-		{"name", "Plex"},
-		{"state", state},
-		{"details", details},
-		{"timestamps", timestamps},
-		{"assets", assets},
-		{"instance", true}};
-
-	if (!timestamps.empty())
+	else if (!meta.malId.empty())
 	{
-		ret["timestamps"] = timestamps;
+		activity.buttons.emplace_back("View on MyAnimeList", "https://myanimelist.net/anime/" + meta.malId);
 	}
-
-	if (!buttons.empty())
+	else if (!meta.imdbId.empty())
 	{
-		ret["buttons"] = buttons;
+		activity.buttons.emplace_back("View on IMDb", "https://www.imdb.com/title/" + meta.imdbId);
 	}
 
-	return ret;
+	activity.type = activityType;
+	activity.state = std::move(state);
+	activity.details = std::move(details);
+	return true;
 }
 
-void Discord::sendPresenceMessage(const std::string &message)
+void Discord::sendPresenceFrame(std::string &frame, const std::string &nonce)
 {
-	if (!ipc.writeFrame(OP_FRAME, message))
+	// Tracked before writing so even an instant answer finds its request; the
+	// connection thread reads the answer, so the next frame needn't wait
+	trackRequest(nonce);
+	if (!ipc.writeFramed(OP_FRAME, frame))
 	{
 		LOG_WARNING("Discord", "Failed to send presence update");
+		forgetRequest(nonce);
 		needs_reconnect = true;
 		// Call disconnected callback if set
 		if (onDisconnected)
 		{
 			onDisconnected();
 		}
-		return;
-	}
-
-	int opcode;
-	std::string response;
-	if (ipc.readFrame(opcode, response))
-	{
-		try
-		{
-			json response_json = json::parse(response);
-			if (response_json.contains("evt") && response_json["evt"] == "ERROR")
-			{
-				LOG_WARNING_STREAM("Discord", "Discord rejected presence update: " << response);
-			}
-		}
-		catch (const std::exception &e)
-		{
-			LOG_WARNING_STREAM("Discord", "Failed to parse response: " << e.what());
-		}
-	}
-	else
-	{
-		LOG_WARNING("Discord", "Failed to read Discord response");
 	}
 }
 
-void Discord::queuePresenceMessage(const std::string &message)
+void Discord::queuePresence(const Activity *activity)
 {
 	std::lock_guard<std::mutex> lock(frame_queue_mutex);
-	queued_frame = message;
+
+	// Written in place after the reserved header; the buffer keeps its
+	// capacity, so once warmed up this doesn't allocate
+	queued_frame.assign(DiscordIPC::FRAME_HEADER_SIZE, '\0');
+	queued_nonce = generateNonce();
+	writePresence(queued_frame, activity, queued_nonce);
 	has_queued_frame = true;
 	LOG_DEBUG("Discord", "Frame queued for sending");
 }
 
 void Discord::processQueuedFrame()
 {
-	std::string frame_to_send;
+	// One sender at a time owns the sending buffer
+	std::lock_guard<std::mutex> send_lock(send_mutex);
 
 	{
 		std::lock_guard<std::mutex> lock(frame_queue_mutex);
@@ -722,13 +879,27 @@ void Discord::processQueuedFrame()
 		auto now = std::chrono::steady_clock::now();
 		auto now_seconds = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
 
-		// Check rate limits
+		// Check rate limits; retry once the window has moved on
 		if (!canSendFrame(now_seconds))
 		{
+			if (frame_timer == 0 && running)
+			{
+				frame_timer = TimerService::getInstance().schedule(
+					std::chrono::seconds(MIN_FRAME_INTERVAL_SECONDS), [this]()
+					{
+						{
+							std::lock_guard<std::mutex> lock(frame_queue_mutex);
+							frame_timer = 0;
+						}
+						processQueuedFrame(); },
+					std::chrono::milliseconds(250));
+			}
 			return;
 		}
 
-		frame_to_send = queued_frame;
+		// Swapped rather than copied; the queue gets the spare buffer back
+		sending_frame.swap(queued_frame);
+		sending_nonce.swap(queued_nonce);
 		has_queued_frame = false;
 
 		// Record this frame write time
@@ -737,7 +908,7 @@ void Discord::processQueuedFrame()
 	}
 
 	LOG_DEBUG("Discord", "Processing queued frame");
-	sendPresenceMessage(frame_to_send);
+	sendPresenceFrame(sending_frame, sending_nonce);
 }
 
 bool Discord::canSendFrame(int64_t current_time)
@@ -791,24 +962,12 @@ void Discord::clearPresence()
 
 	is_playing = false;
 
-#ifdef _WIN32
-	auto process_id = static_cast<int>(GetCurrentProcessId());
-#else
-	auto process_id = static_cast<int>(getpid());
-#endif
-	// Create empty presence payload to clear current presence
-	json presence = {
-		{"cmd", "SET_ACTIVITY"},
-		{"args", {{"pid", process_id}, {"activity", nullptr}}},
-		{"nonce", generateNonce()}};
-
-	std::string presence_str = presence.dump();
-
-	// Queue the clear presence message instead of sending immediately
-	queuePresenceMessage(presence_str);
+	// Queue an empty activity so clearing obeys the same rate limit
+	queuePresence(nullptr);
+	processQueuedFrame();
 }
 
-bool Discord::isStillAlive()
+bool Discord::pingIfIdle()
 {
 
 	// Get current time
@@ -817,42 +976,47 @@ bool Discord::isStillAlive()
 				   .count();
 
 	// Skip ping if there was a recent write
-	if (now - last_frame_write_time < 60)
+	if (now - last_frame_write_time < HEALTH_CHECK_INTERVAL_SECONDS)
 	{
 		LOG_DEBUG("Discord", "Skipping ping due to recent write activity");
 		return true;
 	}
 
+	// The PONG is matched up by the connection thread like any other answer
+	trackRequest(PING_NONCE);
 	if (!ipc.sendPing())
 	{
 		LOG_WARNING("Discord", "Failed to send ping");
-		return false;
-	}
-
-	// Read and process PONG response
-	int opcode;
-	std::string response;
-	if (ipc.readFrame(opcode, response))
-	{
-		if (opcode != OP_PONG)
-		{
-			LOG_WARNING_STREAM("Discord", "Unexpected response to PING. Opcode: " << opcode);
-			return false;
-		}
-	}
-	else
-	{
-		LOG_WARNING("Discord", "Failed to read PONG response");
+		forgetRequest(PING_NONCE);
 		return false;
 	}
 
 	return true;
 }
 
+void Discord::reconnect()
+{
+	reconnect_requested = true;
+	stop_signal.notify();
+}
+
+Discord::RoundTripStats Discord::getRoundTripStats()
+{
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	RoundTripStats stats;
+	stats.answered = completed_requests;
+	stats.timedOut = timed_out_requests;
+	stats.p50 = round_trips.percentile(0.5);
+	stats.p99 = round_trips.percentile(0.99);
+	return stats;
+}
+
 void Discord::start()
 {
 	LOG_INFO("Discord", "Starting Discord Rich Presence");
 	running = true;
+	stop_signal.reset();
+	ipc.setWakeSignal(&stop_signal);
 	conn_thread = std::thread(&Discord::connectionThread, this);
 }
 
@@ -860,10 +1024,27 @@ void Discord::stop()
 {
 	LOG_INFO("Discord", "Stopping Discord Rich Presence");
 	running = false;
+	stop_signal.notify();
+
+	TimerService::TimerId pending_timer;
+	{
+		std::lock_guard<std::mutex> lock(frame_queue_mutex);
+		pending_timer = frame_timer;
+		frame_timer = 0;
+	}
+	TimerService::getInstance().cancel(pending_timer);
 
 	if (conn_thread.joinable())
 	{
-		ThreadUtils::joinWithTimeout(conn_thread, std::chrono::seconds(3), "Discord connection thread");
+		conn_thread.join();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex);
+		LOG_INFO_STREAM("Discord", "IPC round trips: " << completed_requests << " answered, p50 "
+													   << round_trips.percentile(0.5).count() / 1000.0 << " ms, p99 "
+													   << round_trips.percentile(0.99).count() / 1000.0 << " ms, "
+													   << timed_out_requests << " timed out");
 	}
 
 	if (ipc.isConnected())
@@ -15,10 +15,13 @@ inline void safe_localtime(std::tm *tm_ptr, const std::time_t *time_ptr)
 
 using json = nlohmann::json;
 
-DiscordIPC::DiscordIPC() : connected(false)
+DiscordIPC::DiscordIPC() : connected(false), wake_signal(nullptr)
 {
 #ifdef _WIN32
     pipe_handle = INVALID_HANDLE_VALUE;
+    read_event = CreateEvent(NULL, TRUE, FALSE, NULL);
+    write_event = CreateEvent(NULL, TRUE, FALSE, NULL);
+    wake_event = CreateEvent(NULL, TRUE, FALSE, NULL);
 #else
     pipe_fd = -1;
 #endif
@@ -30,6 +33,11 @@ DiscordIPC::~DiscordIPC()
     {
         closePipe();
     }
+#ifdef _WIN32
+    CloseHandle(read_event);
+    CloseHandle(write_event);
+    CloseHandle(wake_event);
+#endif
 }
 
 #if defined(_WIN32)
@@ -42,13 +50,15 @@ bool DiscordIPC::openPipe(int pipeNum)
         std::string pipeName = "\\\\.\\pipe\\discord-ipc-" + std::to_string(i);
         LOG_DEBUG("DiscordIPC", "Trying pipe: " + pipeName);
 
+        // Overlapped, so a pending read neither blocks the reading thread
+        // past its deadline nor holds up writes from other threads
         pipe_handle = CreateFile(
             pipeName.c_str(),
             GENERIC_READ | GENERIC_WRITE,
             0,
             NULL,
             OPEN_EXISTING,
-            0,
+            FILE_FLAG_OVERLAPPED,
             NULL);
 
         if (pipe_handle != INVALID_HANDLE_VALUE)
@@ -63,6 +73,7 @@ bool DiscordIPC::openPipe(int pipeNum)
             }
 
             LOG_INFO("DiscordIPC", "Successfully connected to Discord pipe: " + pipeName);
+            read_buffer.clear();
             connected = true;
             return true;
         }
@@ -79,7 +90,27 @@ bool DiscordIPC::openPipe(int pipeNum)
     return false;
 }
 
-#elif defined(__APPLE__)
+#else
+bool DiscordIPC::markConnected()
+{
+    // Reads wait in poll() and writes never block for long, so a hung
+    // Discord client can't freeze the thread talking to it
+    int flags = fcntl(pipe_fd, F_GETFL, 0);
+    if (flags == -1 || fcntl(pipe_fd, F_SETFL, flags | O_NONBLOCK) == -1)
+    {
+        LOG_ERROR("DiscordIPC", "Failed to make socket non-blocking: " + std::string(strerror(errno)));
+        close(pipe_fd);
+        pipe_fd = -1;
+        return false;
+    }
+
+    read_buffer.clear();
+    connected = true;
+    return true;
+}
+#endif
+
+#if defined(__APPLE__)
 bool DiscordIPC::openPipe(int pipeNum)
 {
     const char *temp = getenv("TMPDIR");
@@ -125,8 +156,7 @@ bool DiscordIPC::openPipe(int pipeNum)
         {
             LOG_INFO("DiscordIPC", "Successfully connected to Discord socket: " + socket_path);
 
-            connected = true;
-            return true;
+            return markConnected();
         }
 
         LOG_DEBUG("DiscordIPC", "Failed to connect to socket: " + socket_path + ": " + std::string(strerror(errno)));
@@ -193,8 +223,7 @@ bool DiscordIPC::openPipe(int pipeNum)
         {
             LOG_INFO("DiscordIPC", "Successfully connected to Discord socket: " + socket_path);
 
-            connected = true;
-            return true;
+            return markConnected();
         }
 
         LOG_DEBUG("DiscordIPC", "Failed to connect to socket: " + socket_path + ": " + std::string(strerror(errno)));
@@ -218,8 +247,7 @@ bool DiscordIPC::openPipe(int pipeNum)
         if (::connect(pipe_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0)
         {
             LOG_INFO("DiscordIPC", "Successfully connected to Discord Snap socket: " + snap_path);
-            connected = true;
-            return true;
+            return markConnected();
         }
 
         LOG_DEBUG("DiscordIPC", "Failed to connect to Snap socket: " + snap_path + ": " + std::string(strerror(errno)));
@@ -242,8 +270,7 @@ bool DiscordIPC::openPipe(int pipeNum)
         if (::connect(pipe_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0)
         {
             LOG_INFO("DiscordIPC", "Successfully connected to Discord Flatpak socket: " + flatpak_path);
-            connected = true;
-            return true;
+            return markConnected();
         }
 
         LOG_DEBUG("DiscordIPC", "Failed to connect to Flatpak socket: " + flatpak_path + ": " + std::string(strerror(errno)));
@@ -284,6 +311,15 @@ bool DiscordIPC::isConnected() const
 }
 
 bool DiscordIPC::writeFrame(int opcode, const std::string &payload)
+{
+    std::string frame;
+    frame.reserve(FRAME_HEADER_SIZE + payload.size());
+    frame.assign(FRAME_HEADER_SIZE, '\0');
+    frame.append(payload);
+    return writeFramed(opcode, frame);
+}
+
+bool DiscordIPC::writeFramed(int opcode, std::string &frame)
 {
     if (!connected)
     {
@@ -291,174 +327,288 @@ bool DiscordIPC::writeFrame(int opcode, const std::string &payload)
         return false;
     }
 
-    LOG_DEBUG("DiscordIPC", "Writing frame - Opcode: " + std::to_string(opcode) + ", Data length: " + std::to_string(payload.size()));
-    LOG_DEBUG("DiscordIPC", "Writing frame data: " + payload);
+    uint32_t len = static_cast<uint32_t>(frame.size() - FRAME_HEADER_SIZE);
 
-    // Create a properly formatted Discord IPC message
-    uint32_t len = static_cast<uint32_t>(payload.size());
-    std::vector<char> buf(8 + len); // Header (8 bytes) + payload
-    auto *p = reinterpret_cast<uint32_t *>(buf.data());
-    p[0] = htole32(opcode); // First 4 bytes: opcode with proper endianness
-    p[1] = htole32(len);    // Next 4 bytes: payload length with proper endianness
-    memcpy(buf.data() + 8, payload.data(), len);
+    // Building these messages copies the payload, so only when they are shown
+    if (Logger::getInstance().getLogLevel() <= LogLevel::Debug)
+    {
+        LOG_DEBUG("DiscordIPC", "Writing frame - Opcode: " + std::to_string(opcode) + ", Data length: " + std::to_string(len));
+        LOG_DEBUG("DiscordIPC", "Writing frame data: " + frame.substr(FRAME_HEADER_SIZE));
+    }
+
+    // Fill in the header in front of the payload, so the frame goes out in one write
+    uint32_t header[2] = {htole32(static_cast<uint32_t>(opcode)), htole32(len)}; // Opcode, then payload length
+    memcpy(&frame[0], header, FRAME_HEADER_SIZE);
+
+    // Frames from different threads must not interleave
+    std::lock_guard<std::mutex> lock(write_mutex);
 
 #ifdef _WIN32
-    DWORD written;
-    if (!WriteFile(pipe_handle, buf.data(), 8 + len, &written, nullptr) ||
-        written != 8 + len)
+    // A full pipe is waited out, but only for so long, since it means
+    // Discord stopped reading
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = write_event;
+    ResetEvent(write_event);
+    DWORD written = 0;
+    bool ok = WriteFile(pipe_handle, frame.data(), static_cast<DWORD>(frame.size()), NULL, &overlapped) != FALSE;
+    if (ok || GetLastError() == ERROR_IO_PENDING)
     {
-        DWORD error = GetLastError();
-        LOG_ERROR("DiscordIPC", "Failed to write frame to pipe. Error code: " + std::to_string(error) + ", Bytes written: " + std::to_string(written));
+        ok = finishOverlapped(overlapped, WRITE_TIMEOUT_MS, NULL, written);
+    }
+    if (!ok || written != frame.size())
+    {
+        DWORD error = ok ? ERROR_SUCCESS : GetLastError();
+        LOG_ERROR("DiscordIPC", error == ERROR_OPERATION_ABORTED ? "Timed out writing frame: Discord is not reading"
+                                                                 : "Failed to write frame to pipe. Error code: " + std::to_string(error) + ", Bytes written: " + std::to_string(written));
         connected = false;
         return false;
     }
     LOG_DEBUG("DiscordIPC", "Successfully wrote " + std::to_string(written) + " bytes to pipe");
-    FlushFileBuffers(pipe_handle);
 #else
-    ssize_t n = ::write(pipe_fd, buf.data(), 8 + len);
-    if (n != 8 + len)
+    // The socket is non-blocking; a full send buffer is waited out, but only
+    // for so long, since it means Discord stopped reading
+    size_t total_written = 0;
+    while (total_written < frame.size())
     {
-        LOG_ERROR("DiscordIPC", "Failed to write frame to socket. Expected: " + std::to_string(8 + len) + ", Actual: " + std::to_string(n));
-        if (n < 0)
+        ssize_t n = ::write(pipe_fd, frame.data() + total_written, frame.size() - total_written);
+        if (n > 0)
         {
-            LOG_ERROR("DiscordIPC", "Write error: " + std::string(strerror(errno)));
+            total_written += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            struct pollfd fds = {pipe_fd, POLLOUT, 0};
+            int result = poll(&fds, 1, WRITE_TIMEOUT_MS);
+            if (result > 0 || (result < 0 && errno == EINTR))
+            {
+                continue;
+            }
+            LOG_ERROR("DiscordIPC", result == 0 ? "Timed out writing frame: Discord is not reading"
+                                                : "Error polling socket: " + std::string(strerror(errno)));
+        }
+        else
+        {
+            LOG_ERROR("DiscordIPC", "Failed to write frame to socket. Expected: " + std::to_string(frame.size()) + ", Actual: " + std::to_string(total_written));
+            if (n < 0)
+            {
+                LOG_ERROR("DiscordIPC", "Write error: " + std::string(strerror(errno)));
+            }
         }
         connected = false;
         return false;
     }
-    LOG_DEBUG("DiscordIPC", "Successfully wrote " + std::to_string(n) + " bytes to socket");
+    LOG_DEBUG("DiscordIPC", "Successfully wrote " + std::to_string(total_written) + " bytes to socket");
 #endif
     return true;
 }
 
-bool DiscordIPC::readFrame(int &opcode, std::string &data)
+void DiscordIPC::setWakeSignal(WakeSignal *signal)
 {
-    if (!connected)
+    wake_signal = signal;
+}
+
+bool DiscordIPC::takeFrame(int &opcode, std::string &data)
+{
+    if (read_buffer.size() < FRAME_HEADER_SIZE)
     {
-        LOG_DEBUG("DiscordIPC", "Can't read frame: not connected");
         return false;
     }
 
-    LOG_DEBUG("DiscordIPC", "Attempting to read frame from Discord");
-    opcode = -1;
+    // Parse the header with proper endianness handling
+    uint32_t raw0, raw1;
+    memcpy(&raw0, read_buffer.data(), 4);
+    memcpy(&raw1, read_buffer.data() + 4, 4);
+    uint32_t length = le32toh(raw1);
+    if (read_buffer.size() < FRAME_HEADER_SIZE + length)
+    {
+        return false;
+    }
 
-    // First read the 8-byte header (opcode + length)
-    char header[8];
-    int header_bytes_read = 0;
+    opcode = static_cast<int>(le32toh(raw0));
+    data.assign(read_buffer, FRAME_HEADER_SIZE, length);
+    read_buffer.erase(0, FRAME_HEADER_SIZE + length);
+    LOG_DEBUG("DiscordIPC", "Read frame - Opcode: " + std::to_string(opcode) + ", Data: " + data);
+    return true;
+}
 
 #ifdef _WIN32
-    LOG_DEBUG("DiscordIPC", "Reading header (8 bytes)...");
-    while (header_bytes_read < 8)
+bool DiscordIPC::finishOverlapped(OVERLAPPED &overlapped, DWORD timeout_ms, HANDLE extra_event, DWORD &transferred)
+{
+    // A completed operation wins over extra_event, which comes second
+    HANDLE handles[2] = {overlapped.hEvent, extra_event};
+    DWORD waited = WaitForMultipleObjects(extra_event ? 2 : 1, handles, FALSE, timeout_ms);
+    if (waited != WAIT_OBJECT_0)
     {
-        DWORD bytes_read;
-        if (!ReadFile(pipe_handle, header + header_bytes_read, 8 - header_bytes_read, &bytes_read, NULL))
-        {
-            DWORD error = GetLastError();
-            LOG_ERROR("DiscordIPC", "Failed to read header: error code " + std::to_string(error));
-            connected = false;
-            return false;
-        }
+        CancelIoEx(pipe_handle, &overlapped);
+    }
+
+    // The buffer belongs to the caller, so wait for the cancellation to land.
+    // An operation that completed just before it keeps its result.
+    return GetOverlappedResult(pipe_handle, &overlapped, &transferred, TRUE) != FALSE;
+}
+
+DiscordIPC::ReadResult DiscordIPC::fillReadBuffer(std::chrono::milliseconds timeout)
+{
+    // The read stays pending until data arrives; the wake signal and the
+    // deadline end the wait for it and cancel it
+    ResetEvent(wake_event);
+    HANDLE event = wake_event;
+    WakeListenerGuard wake(wake_signal, [event]()
+                           { SetEvent(event); });
+
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = read_event;
+    ResetEvent(read_event);
+
+    char chunk[4096];
+    DWORD bytes_read = 0;
+    BOOL ok = ReadFile(pipe_handle, chunk, sizeof(chunk), NULL, &overlapped);
+    DWORD error = ok ? ERROR_SUCCESS : GetLastError();
+    if (ok || error == ERROR_IO_PENDING || error == ERROR_MORE_DATA)
+    {
+        // Completed reads return at once; the byte count comes from here either way
+        DWORD timeout_ms = timeout.count() >= 0 ? static_cast<DWORD>(timeout.count()) : INFINITE;
+        ok = finishOverlapped(overlapped, timeout_ms, wake_event, bytes_read);
+        error = ok ? ERROR_SUCCESS : GetLastError();
+    }
 
+    // In message mode a message longer than the chunk arrives in pieces
+    if (ok || error == ERROR_MORE_DATA)
+    {
         if (bytes_read == 0)
         {
             LOG_ERROR("DiscordIPC", "Read zero bytes from pipe - connection closed");
             connected = false;
-            return false;
+            return ReadResult::Closed;
         }
-
-        header_bytes_read += bytes_read;
-        LOG_DEBUG("DiscordIPC", "Read " + std::to_string(bytes_read) + " header bytes, total: " + std::to_string(header_bytes_read) + "/8");
+        read_buffer.append(chunk, bytes_read);
+        return ReadResult::Frame;
     }
-#else
-    LOG_DEBUG("DiscordIPC", "Reading header (8 bytes)...");
-    while (header_bytes_read < 8)
+    if (error == ERROR_OPERATION_ABORTED)
     {
-        ssize_t bytes_read = read(pipe_fd, header + header_bytes_read, 8 - header_bytes_read);
-        if (bytes_read <= 0)
-        {
-            if (bytes_read < 0)
-            {
-                LOG_ERROR("DiscordIPC", "Error reading from socket: " + std::string(strerror(errno)));
-            }
-            else
-            {
-                LOG_ERROR("DiscordIPC", "Socket closed during header read");
-            }
-            connected = false;
-            return false;
-        }
-        header_bytes_read += bytes_read;
-        LOG_DEBUG("DiscordIPC", "Read " + std::to_string(bytes_read) + " header bytes, total: " + std::to_string(header_bytes_read) + "/8");
+        return wake_signal && wake_signal->isSet() ? ReadResult::Interrupted : ReadResult::Timeout;
     }
-#endif
-
-    // Parse the header with proper endianness handling
-    uint32_t raw0, raw1;
-    memcpy(&raw0, header, 4);
-    memcpy(&raw1, header + 4, 4);
-    opcode = le32toh(raw0);
-    uint32_t length = le32toh(raw1);
 
-    LOG_DEBUG("DiscordIPC", "Frame header parsed - Opcode: " + std::to_string(opcode) + ", Expected data length: " + std::to_string(length));
+    LOG_ERROR("DiscordIPC", "Failed to read from pipe: error code " + std::to_string(error));
+    connected = false;
+    return ReadResult::Closed;
+}
+#else
+DiscordIPC::ReadResult DiscordIPC::fillReadBuffer(std::chrono::milliseconds timeout)
+{
+    struct pollfd fds[2];
+    fds[0] = {pipe_fd, POLLIN, 0};
+    fds[1] = {wake_signal ? wake_signal->fd() : -1, POLLIN, 0}; // poll() skips negative fds
 
-    if (length == 0)
+    int result = poll(fds, 2, timeout.count() >= 0 ? static_cast<int>(timeout.count()) : -1);
+    if (result < 0 && errno == EINTR)
     {
-        LOG_DEBUG("DiscordIPC", "Frame has zero length, no data to read");
-        data.clear();
-        return true;
+        return ReadResult::Timeout; // The caller recomputes what is left and retries
+    }
+    if (result < 0)
+    {
+        LOG_ERROR("DiscordIPC", "Error polling socket: " + std::string(strerror(errno)));
+        connected = false;
+        return ReadResult::Closed;
+    }
+    if (fds[1].revents & POLLIN)
+    {
+        LOG_DEBUG("DiscordIPC", "Read interrupted by wake signal");
+        return ReadResult::Interrupted;
+    }
+    if (result == 0)
+    {
+        return ReadResult::Timeout;
     }
 
-    // Now read the actual payload data
-    data.resize(length);
-    uint32_t data_bytes_read = 0;
-
-#ifdef _WIN32
-    LOG_DEBUG("DiscordIPC", "Reading payload (" + std::to_string(length) + " bytes)...");
-    while (data_bytes_read < length)
+    // Readable, or an error/hangup that read() reports; take everything there is
+    char chunk[4096];
+    while (true)
     {
-        DWORD bytes_read;
-        if (!ReadFile(pipe_handle, &data[data_bytes_read], length - data_bytes_read, &bytes_read, NULL))
+        ssize_t bytes_read = read(pipe_fd, chunk, sizeof(chunk));
+        if (bytes_read > 0)
         {
-            DWORD error = GetLastError();
-            LOG_ERROR("DiscordIPC", "Failed to read data: error code " + std::to_string(error));
-            connected = false;
-            return false;
+            read_buffer.append(chunk, static_cast<size_t>(bytes_read));
+            continue;
         }
-
-        if (bytes_read == 0)
+        if (bytes_read < 0 && errno == EINTR)
         {
-            LOG_ERROR("DiscordIPC", "Read zero bytes from pipe during payload read - connection closed");
-            connected = false;
-            return false;
+            continue;
+        }
+        if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return ReadResult::Frame;
         }
 
-        data_bytes_read += bytes_read;
-        LOG_DEBUG("DiscordIPC", "Read " + std::to_string(bytes_read) + " data bytes, total: " + std::to_string(data_bytes_read) + "/" + std::to_string(length));
+        if (bytes_read < 0)
+        {
+            LOG_ERROR("DiscordIPC", "Error reading from socket: " + std::string(strerror(errno)));
+        }
+        else
+        {
+            LOG_ERROR("DiscordIPC", "Socket closed by Discord");
+        }
+        connected = false;
+        return ReadResult::Closed;
     }
-#else
-    LOG_DEBUG("DiscordIPC", "Reading payload (" + std::to_string(length) + " bytes)...");
-    while (data_bytes_read < length)
+}
+#endif
+
+DiscordIPC::ReadResult DiscordIPC::readFrame(int &opcode, std::string &data, std::chrono::milliseconds timeout)
+{
+    opcode = -1;
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true)
     {
-        ssize_t bytes_read = read(pipe_fd, &data[data_bytes_read], length - data_bytes_read);
-        if (bytes_read <= 0)
+        if (takeFrame(opcode, data))
+        {
+            return ReadResult::Frame;
+        }
+        if (read_buffer.size() >= FRAME_HEADER_SIZE)
         {
-            if (bytes_read < 0)
+            uint32_t raw1;
+            memcpy(&raw1, read_buffer.data() + 4, 4);
+            if (le32toh(raw1) > MAX_FRAME_SIZE)
             {
-                LOG_ERROR("DiscordIPC", "Error reading from socket: " + std::string(strerror(errno)));
+                LOG_ERROR("DiscordIPC", "Frame too large, closing connection: " + std::to_string(le32toh(raw1)) + " bytes");
+                connected = false;
+                return ReadResult::Closed;
             }
-            else
+        }
+        if (!connected)
+        {
+            LOG_DEBUG("DiscordIPC", "Can't read frame: not connected");
+            return ReadResult::Closed;
+        }
+        if (wake_signal && wake_signal->isSet())
+        {
+            LOG_DEBUG("DiscordIPC", "Not reading frame: wake signal is set");
+            return ReadResult::Interrupted;
+        }
+
+        // Wait for more bytes; a frame may arrive in several pieces
+        std::chrono::milliseconds remaining(-1);
+        if (timeout.count() >= 0)
+        {
+            remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0)
             {
-                LOG_ERROR("DiscordIPC", "Socket closed during payload read");
+                return ReadResult::Timeout;
             }
-            connected = false;
-            return false;
         }
-        data_bytes_read += bytes_read;
-        LOG_DEBUG("DiscordIPC", "Read " + std::to_string(bytes_read) + " data bytes, total: " + std::to_string(data_bytes_read) + "/" + std::to_string(length));
+
+        ReadResult result = fillReadBuffer(remaining);
+        if (result == ReadResult::Interrupted || result == ReadResult::Closed)
+        {
+            return result;
+        }
     }
-#endif
-    LOG_DEBUG("DiscordIPC", "Reading frame data: " + data);
-    return true;
 }
 
 bool DiscordIPC::sendHandshake(uint64_t clientId)
@@ -1,16 +1,46 @@
 #include "http_client.h"
-#include "thread_utils.h"
+#include "latency_tracker.h"
+#include "traffic_recorder.h"
+#include <algorithm>
+#include <cctype>
 
-HttpClient::HttpClient()
+namespace
+{
+    // Upper bound on a single curl_multi_poll; wakeups normally end it sooner
+    constexpr const int TRANSFER_POLL_TIMEOUT_MS = 1000;
+
+    // Downloads can take any time as long as data keeps coming
+    constexpr const long DOWNLOAD_STALL_TIMEOUT_S = 30;
+
+    std::chrono::microseconds transferTime(CURL *curl, CURLINFO info)
+    {
+        curl_off_t value = 0;
+        curl_easy_getinfo(curl, info, &value);
+        return std::chrono::microseconds(value);
+    }
+}
+
+HttpClient::HttpClient(WakeSignal *abortSignal) : m_abortSignal(abortSignal)
 {
     curl_global_init(CURL_GLOBAL_ALL);
     m_curl = curl_easy_init();
+    m_multi = curl_multi_init();
+    if (m_abortSignal)
+    {
+        m_abortListenerId = m_abortSignal->addListener([this]()
+                                                       { wakeTransfers(); });
+    }
     LOG_DEBUG("HttpClient", "HttpClient initialized");
 }
 
 HttpClient::~HttpClient()
 {
-    if (m_sseRunning)
+    if (m_abortSignal)
+    {
+        m_abortSignal->removeListener(m_abortListenerId);
+    }
+
+    if (m_sseRunning || m_sseThread.joinable())
     {
         stopSSE();
     }
@@ -21,6 +51,12 @@ HttpClient::~HttpClient()
         m_curl = nullptr;
     }
 
+    if (m_multi)
+    {
+        curl_multi_cleanup(m_multi);
+        m_multi = nullptr;
+    }
+
     curl_global_cleanup();
     LOG_DEBUG("HttpClient", "HttpClient object destroyed");
 }
@@ -33,6 +69,107 @@ size_t HttpClient::writeCallback(char *ptr, size_t size, size_t nmemb, void *use
     return totalSize;
 }
 
+bool HttpClient::aborted() const
+{
+    return m_stopFlag || (m_abortSignal && m_abortSignal->isSet());
+}
+
+void HttpClient::wakeTransfers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_transferMutex);
+        for (CURLM *multi : m_activeTransfers)
+        {
+            curl_multi_wakeup(multi);
+        }
+    }
+
+    // Also cut short a notification stream retry delay
+    std::lock_guard<std::mutex> lock(m_sseMutex);
+    m_sseCondVar.notify_all();
+}
+
+CURLcode HttpClient::performTransfer(CURLM *multi, CURL *curl, const std::function<bool()> &shouldAbort)
+{
+    if (!multi)
+    {
+        return CURLE_OUT_OF_MEMORY;
+    }
+    curl_multi_add_handle(multi, curl);
+
+    {
+        std::lock_guard<std::mutex> lock(m_transferMutex);
+        m_activeTransfers.insert(multi);
+    }
+
+    // Drive the transfer ourselves so a wakeup can end the wait immediately,
+    // rather than waiting for curl's next progress callback
+    CURLcode result = CURLE_OK;
+    int running = 1;
+    while (running)
+    {
+        if (shouldAbort())
+        {
+            result = CURLE_ABORTED_BY_CALLBACK;
+            break;
+        }
+
+        CURLMcode code = curl_multi_perform(multi, &running);
+        if (code == CURLM_OK && running)
+        {
+            code = curl_multi_poll(multi, nullptr, 0, TRANSFER_POLL_TIMEOUT_MS, nullptr);
+        }
+        if (code != CURLM_OK)
+        {
+            LOG_ERROR("HttpClient", "Transfer failed: " + std::string(curl_multi_strerror(code)));
+            result = CURLE_FAILED_INIT;
+            break;
+        }
+    }
+
+    if (!running)
+    {
+        int pending;
+        while (CURLMsg *message = curl_multi_info_read(multi, &pending))
+        {
+            if (message->msg == CURLMSG_DONE)
+            {
+                result = message->data.result;
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_transferMutex);
+        m_activeTransfers.erase(multi);
+    }
+    // The multi handle keeps the connection and DNS caches for the next transfer
+    curl_multi_remove_handle(multi, curl);
+    return result;
+}
+
+size_t HttpClient::headerCallback(char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    auto *headers = static_cast<std::map<std::string, std::string> *>(userdata);
+    size_t totalSize = size * nmemb;
+    std::string line(ptr, totalSize);
+
+    size_t colon = line.find(':');
+    if (colon != std::string::npos)
+    {
+        std::string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+
+        size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+        size_t valueEnd = line.find_last_not_of(" \t\r\n");
+        (*headers)[name] = valueStart == std::string::npos || valueEnd < valueStart
+                               ? ""
+                               : line.substr(valueStart, valueEnd - valueStart + 1);
+    }
+    return totalSize;
+}
+
 struct curl_slist *HttpClient::createHeaderList(const std::map<std::string, std::string> &headers)
 {
     struct curl_slist *curl_headers = NULL;
@@ -45,7 +182,26 @@ struct curl_slist *HttpClient::createHeaderList(const std::map<std::string, std:
     return curl_headers;
 }
 
-bool HttpClient::setupCommonOptions(const std::string &url, const std::map<std::string, std::string> &headers)
+CURLcode HttpClient::performRequest(CURL *curl, const CancellationToken *cancel)
+{
+    // Cancelling the token wakes the transfer like the abort signal does
+    CancellationToken::ListenerGuard cancelGuard(cancel, [this]()
+                                                 { wakeTransfers(); });
+    CURLcode res = performTransfer(m_multi, curl, [this, cancel]()
+                                   { return aborted() || (cancel && cancel->isCancelled()); });
+
+    // Failures other than timeouts say nothing about latency
+    if (res == CURLE_OK || res == CURLE_OPERATION_TIMEDOUT)
+    {
+        auto connectTime = (std::max)(transferTime(curl, CURLINFO_CONNECT_TIME_T),
+                                      transferTime(curl, CURLINFO_APPCONNECT_TIME_T));
+        LatencyTracker::getInstance().record(m_endpoint, connectTime, transferTime(curl, CURLINFO_TOTAL_TIME_T),
+                                             res == CURLE_OPERATION_TIMEDOUT);
+    }
+    return res;
+}
+
+bool HttpClient::setupCommonOptions(const std::string &url)
 {
     if (!m_curl)
     {
@@ -55,7 +211,19 @@ bool HttpClient::setupCommonOptions(const std::string &url, const std::map<std::
 
     curl_easy_reset(m_curl);
     curl_easy_setopt(m_curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(m_curl, CURLOPT_TIMEOUT, 10L);
+
+    // Timeouts follow what this endpoint normally takes
+    m_endpoint = LatencyTracker::endpointOf(url);
+    RequestTimeouts timeouts = LatencyTracker::getInstance().timeoutsFor(m_endpoint);
+    curl_easy_setopt(m_curl, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(timeouts.connect.count()));
+    curl_easy_setopt(m_curl, CURLOPT_TIMEOUT_MS, static_cast<long>(timeouts.total.count()));
+    curl_easy_setopt(m_curl, CURLOPT_LOW_SPEED_LIMIT, LatencyTracker::LOW_SPEED_LIMIT);
+    curl_easy_setopt(m_curl, CURLOPT_LOW_SPEED_TIME, timeouts.lowSpeedTime);
+
+    m_lastStatusCode = 0;
+    m_lastResponseHeaders.clear();
+    curl_easy_setopt(m_curl, CURLOPT_HEADERFUNCTION, headerCallback);
+    curl_easy_setopt(m_curl, CURLOPT_HEADERDATA, &m_lastResponseHeaders);
 
     LOG_DEBUG_STREAM("HttpClient", "Set up request to URL: " << url);
     return true;
@@ -63,6 +231,12 @@ bool HttpClient::setupCommonOptions(const std::string &url, const std::map<std::
 
 bool HttpClient::checkResponse(CURLcode res)
 {
+    if (res == CURLE_ABORTED_BY_CALLBACK)
+    {
+        LOG_DEBUG("HttpClient", "Request aborted");
+        return false;
+    }
+
     if (res != CURLE_OK)
     {
         LOG_ERROR("HttpClient", "Request failed: " + std::string(curl_easy_strerror(res)));
@@ -71,6 +245,13 @@ bool HttpClient::checkResponse(CURLcode res)
 
     long response_code;
     curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &response_code);
+    m_lastStatusCode = response_code;
+
+    if (response_code == 304)
+    {
+        LOG_DEBUG("HttpClient", "Resource not modified");
+        return false;
+    }
 
     if (response_code < 200 || response_code >= 300)
     {
@@ -82,26 +263,46 @@ bool HttpClient::checkResponse(CURLcode res)
     return true;
 }
 
-bool HttpClient::get(const std::string &url, const std::map<std::string, std::string> &headers, std::string &response)
+bool HttpClient::get(const std::string &url, const std::map<std::string, std::string> &headers, std::string &response,
+                     const CancellationToken *cancel)
+{
+    struct curl_slist *curl_headers = createHeaderList(headers);
+    bool success = performGet(url, curl_headers, response, cancel);
+    curl_slist_free_all(curl_headers);
+    return success;
+}
+
+bool HttpClient::get(const RequestTemplate &request, const std::string &path, std::string &response,
+                     const CancellationToken *cancel)
+{
+    return performGet(request.baseUrl() + path, request.headerList(), response, cancel);
+}
+
+bool HttpClient::performGet(const std::string &url, struct curl_slist *headers, std::string &response,
+                            const CancellationToken *cancel)
 {
     LOG_INFO_STREAM("HttpClient", "Sending GET request to: " << url);
 
-    if (!setupCommonOptions(url, headers))
+    if (TrafficReplay::getInstance().isActive())
+    {
+        return replayRequest("GET", url, &response, cancel);
+    }
+
+    if (!setupCommonOptions(url))
     {
         return false;
     }
 
     curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, writeCallback);
     curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &response);
-
-    struct curl_slist *curl_headers = createHeaderList(headers);
-    curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, curl_headers);
+    curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, headers);
 
     LOG_DEBUG("HttpClient", "Executing GET request");
-    CURLcode res = curl_easy_perform(m_curl);
-    curl_slist_free_all(curl_headers);
+    auto captureStart = TrafficRecorder::getInstance().now();
+    CURLcode res = performRequest(m_curl, cancel);
 
     bool success = checkResponse(res);
+    TrafficRecorder::getInstance().recordExchange("GET", url, captureStart, m_lastStatusCode, response);
     if (success)
     {
         LOG_DEBUG_STREAM("HttpClient", "GET request succeeded with response size: " << response.size() << " bytes");
@@ -110,12 +311,17 @@ bool HttpClient::get(const std::string &url, const std::map<std::string, std::st
 }
 
 bool HttpClient::post(const std::string &url, const std::map<std::string, std::string> &headers,
-                      const std::string &body, std::string &response)
+                      const std::string &body, std::string &response, const CancellationToken *cancel)
 {
     LOG_INFO_STREAM("HttpClient", "Sending POST request to: " << url);
     LOG_DEBUG_STREAM("HttpClient", "POST body size: " << body.size() << " bytes");
 
-    if (!setupCommonOptions(url, headers))
+    if (TrafficReplay::getInstance().isActive())
+    {
+        return replayRequest("POST", url, &response, cancel);
+    }
+
+    if (!setupCommonOptions(url))
     {
         return false;
     }
@@ -129,10 +335,12 @@ bool HttpClient::post(const std::string &url, const std::map<std::string, std::s
     curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, curl_headers);
 
     LOG_DEBUG("HttpClient", "Executing POST request");
-    CURLcode res = curl_easy_perform(m_curl);
+    auto captureStart = TrafficRecorder::getInstance().now();
+    CURLcode res = performRequest(m_curl, cancel);
     curl_slist_free_all(curl_headers);
 
     bool success = checkResponse(res);
+    TrafficRecorder::getInstance().recordExchange("POST", url, captureStart, m_lastStatusCode, response);
     if (success)
     {
         LOG_DEBUG_STREAM("HttpClient", "POST request succeeded with response size: " << response.size() << " bytes");
@@ -140,11 +348,171 @@ bool HttpClient::post(const std::string &url, const std::map<std::string, std::s
     return success;
 }
 
+bool HttpClient::head(const std::string &url, const std::map<std::string, std::string> &headers,
+                      const CancellationToken *cancel)
+{
+    struct curl_slist *curl_headers = createHeaderList(headers);
+    bool success = performHead(url, curl_headers, cancel);
+    curl_slist_free_all(curl_headers);
+    return success;
+}
+
+bool HttpClient::head(const RequestTemplate &request, const std::string &path, const CancellationToken *cancel)
+{
+    return performHead(request.baseUrl() + path, request.headerList(), cancel);
+}
+
+bool HttpClient::performHead(const std::string &url, struct curl_slist *headers, const CancellationToken *cancel)
+{
+    LOG_DEBUG_STREAM("HttpClient", "Sending HEAD request to: " << url);
+
+    if (TrafficReplay::getInstance().isActive())
+    {
+        return replayRequest("HEAD", url, nullptr, cancel);
+    }
+
+    if (!setupCommonOptions(url))
+    {
+        return false;
+    }
+
+    curl_easy_setopt(m_curl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, headers);
+
+    auto captureStart = TrafficRecorder::getInstance().now();
+    CURLcode res = performRequest(m_curl, cancel);
+    bool success = checkResponse(res);
+    TrafficRecorder::getInstance().recordExchange("HEAD", url, captureStart, m_lastStatusCode, "");
+    return success;
+}
+
+bool HttpClient::replayWait(std::chrono::microseconds delay, const std::function<bool()> &interrupted)
+{
+    std::unique_lock<std::mutex> lock(m_sseMutex);
+    return !m_sseCondVar.wait_for(lock, delay, interrupted);
+}
+
+bool HttpClient::replayRequest(const std::string &method, const std::string &url, std::string *response,
+                               const CancellationToken *cancel)
+{
+    m_lastStatusCode = 0;
+    m_lastResponseHeaders.clear();
+
+    RecordedExchange exchange;
+    auto &replay = TrafficReplay::getInstance();
+    if (!replay.takeExchange(method, url, exchange))
+    {
+        LOG_ERROR("HttpClient", "Request failed: no captured response for " + method + " " + url);
+        return false;
+    }
+
+    // Take as long as the captured request did, and abort the same way
+    CancellationToken::ListenerGuard cancelGuard(cancel, [this]()
+                                                 { wakeTransfers(); });
+    if (!replayWait(replay.scaled(exchange.duration), [this, cancel]()
+                    { return aborted() || (cancel && cancel->isCancelled()); }))
+    {
+        LOG_DEBUG("HttpClient", "Request aborted");
+        return false;
+    }
+
+    if (exchange.status == 0)
+    {
+        LOG_ERROR("HttpClient", "Request failed: captured request got no response");
+        return false;
+    }
+
+    m_lastStatusCode = exchange.status;
+    if (exchange.status == 304)
+    {
+        LOG_DEBUG("HttpClient", "Resource not modified");
+        return false;
+    }
+
+    if (exchange.status < 200 || exchange.status >= 300)
+    {
+        LOG_ERROR("HttpClient", "Request failed with HTTP status code: " + std::to_string(exchange.status));
+        return false;
+    }
+
+    if (response)
+    {
+        response->append(exchange.body);
+    }
+    return true;
+}
+
+void HttpClient::replaySSE(const UrlProvider &urlProvider, const ErrorCallback &onError)
+{
+    auto &replay = TrafficReplay::getInstance();
+    auto interrupted = [this]()
+    { return aborted() || m_reconnectFlag; };
+
+    while (!aborted())
+    {
+        // Events were captured over whichever transport was used back then
+        std::string serverUri = urlProvider();
+        std::string url;
+        m_reconnectFlag = false;
+
+        std::vector<RecordedEvent> events;
+        bool captured = false;
+        for (const auto &transport : m_transports)
+        {
+            url = transport->streamUrl(serverUri);
+            if (replay.takeEvents(url, events))
+            {
+                captured = true;
+                break;
+            }
+        }
+        if (!captured)
+        {
+            // Nothing was captured from this URL; fail like an unreachable
+            // server so the caller can move on to the URL it used back then
+            LOG_WARNING("HttpClient", "SSE connection error: no captured stream for " + url);
+            if (onError && onError())
+            {
+                continue;
+            }
+        }
+        else
+        {
+            LOG_INFO_STREAM("HttpClient", "Replaying " << events.size() << " SSE events from " << url);
+            if (m_connectedCallback)
+            {
+                m_connectedCallback();
+            }
+
+            for (const auto &event : events)
+            {
+                if (!replayWait(replay.delayUntil(event.time), interrupted))
+                {
+                    break;
+                }
+
+                auto handlingStart = std::chrono::steady_clock::now();
+                if (m_eventCallback)
+                {
+                    m_eventCallback(event.data);
+                }
+                replay.eventDelivered(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - handlingStart));
+            }
+        }
+
+        // Stay connected like an idle stream until told otherwise
+        while (replayWait(std::chrono::hours(1), interrupted))
+        {
+        }
+    }
+}
+
 bool HttpClient::downloadFile(const std::string &url, const std::map<std::string, std::string> &headers, const std::string &outputPath)
 {
     LOG_INFO_STREAM("HttpClient", "Downloading file from: " << url << " to " << outputPath);
 
-    if (!setupCommonOptions(url, headers))
+    if (!setupCommonOptions(url))
     {
         return false;
     }
@@ -158,6 +526,8 @@ bool HttpClient::downloadFile(const std::string &url, const std::map<std::string
     curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, fwrite);
     curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, fp);
     curl_easy_setopt(m_curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(m_curl, CURLOPT_TIMEOUT_MS, 0L);
+    curl_easy_setopt(m_curl, CURLOPT_LOW_SPEED_TIME, DOWNLOAD_STALL_TIMEOUT_S);
 
     std::map<std::string, std::string> modified_headers = headers;
     modified_headers["User-Agent"] = "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/58.0.3029.110 Safari/537.36";
@@ -166,7 +536,8 @@ bool HttpClient::downloadFile(const std::string &url, const std::map<std::string
     curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, curl_headers);
 
     LOG_DEBUG("HttpClient", "Executing download request");
-    CURLcode res = curl_easy_perform(m_curl);
+    CURLcode res = performTransfer(m_multi, m_curl, [this]()
+                                   { return aborted(); });
     curl_slist_free_all(curl_headers);
     fclose(fp);
 
@@ -193,176 +564,309 @@ size_t HttpClient::sseCallback(char *ptr, size_t size, size_t nmemb, void *userd
 {
     HttpClient *client = static_cast<HttpClient *>(userdata);
     size_t total_size = size * nmemb;
+    LOG_DEBUG_STREAM("HttpClient", "Stream received " << total_size << " bytes");
 
-    client->m_sseBuffer.append(ptr, total_size);
-    LOG_DEBUG_STREAM("HttpClient", "SSE received " << total_size << " bytes");
+    // Headers are complete once the body starts, so the status is known
+    client->checkStreamEstablished(client->m_sseCurl);
+    client->m_transport->consume(ptr, total_size, client->m_deliverEvent);
+    return total_size;
+}
 
-    // Process events in buffer
-    size_t pos;
-    while ((pos = client->m_sseBuffer.find("\n\n")) != std::string::npos)
+void HttpClient::checkStreamEstablished(CURL *curl)
+{
+    if (m_sseEstablished)
     {
-        std::string event = client->m_sseBuffer.substr(0, pos);
-        client->m_sseBuffer.erase(0, pos + 2); // +2 for \n\n
+        return;
+    }
 
-        size_t data_pos = event.find("data: ");
-        if (data_pos != std::string::npos)
-        {
-            std::string data = event.substr(data_pos + 6);
-            LOG_DEBUG_STREAM("HttpClient", "SSE event received, data size: " << data.size() << " bytes");
-            if (client->m_eventCallback)
-            {
-                LOG_DEBUG("HttpClient", "Calling SSE event callback");
-                client->m_eventCallback(data);
-            }
-        }
+    long responseCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    if (!m_transport->isEstablished(responseCode))
+    {
+        return;
     }
 
-    return total_size;
+    m_sseEstablished = true;
+    m_transportWorked = true;
+    LOG_INFO_STREAM("HttpClient", m_transport->name() << " stream established to " << m_sseUrl);
+    if (m_connectedCallback)
+    {
+        m_connectedCallback();
+    }
+}
+
+void HttpClient::deliverEvent(const std::string &data)
+{
+    LOG_DEBUG_STREAM("HttpClient", "Stream event received, data size: " << data.size() << " bytes");
+    TrafficRecorder::getInstance().recordEvent(m_sseUrl, data);
+    if (m_eventCallback)
+    {
+        LOG_DEBUG("HttpClient", "Calling stream event callback");
+        m_eventCallback(data);
+    }
 }
 
 int HttpClient::sseCallbackProgress(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
                                     curl_off_t ultotal, curl_off_t ulnow)
 {
     HttpClient *httpClient = static_cast<HttpClient *>(clientp);
-    if (httpClient->m_stopFlag)
+    if (httpClient->aborted())
     {
-        LOG_DEBUG("HttpClient", "SSE connection termination requested");
+        LOG_DEBUG("HttpClient", "Stream connection termination requested");
         return 1; // Abort transfer
     }
+    if (httpClient->m_reconnectFlag)
+    {
+        LOG_DEBUG("HttpClient", "Stream reconnection requested");
+        return 1; // Abort transfer, the stream loop will reconnect
+    }
     return 0; // Continue transfer
 }
 
+void HttpClient::reconnectSSE()
+{
+    if (m_sseRunning)
+    {
+        LOG_INFO("HttpClient", "Requesting stream reconnection");
+        m_reconnectFlag = true;
+        wakeTransfers();
+    }
+}
+
 bool HttpClient::stopSSE()
 {
     m_stopFlag = true;
-    LOG_INFO("HttpClient", "Requesting SSE connection termination");
+    LOG_INFO("HttpClient", "Requesting stream connection termination");
+
+    // Both the transfer and the retry delay wake up on this, so the thread
+    // notices the stop right away
+    wakeTransfers();
 
     if (m_sseThread.joinable())
     {
-        std::unique_lock<std::mutex> lock(m_sseMutex);
-        if (m_sseRunning)
-        {
-            LOG_INFO("HttpClient", "Waiting for SSE thread to stop");
-            
-            bool threadStopped = m_sseCondVar.wait_for(lock, std::chrono::seconds(5), 
-                [this] { return !m_sseRunning; });
-                
-            if (!threadStopped) {
-                LOG_WARNING("HttpClient", "SSE thread did not respond to stop request in time");
-            }
-        }
-        
-        lock.unlock();
-        ThreadUtils::joinWithTimeout(m_sseThread, std::chrono::seconds(2), "SSE thread");
+        m_sseThread.join();
     }
 
-    LOG_INFO("HttpClient", "SSE thread stopped successfully");
+    LOG_INFO("HttpClient", "Stream thread stopped successfully");
     return true;
 }
 
 bool HttpClient::startSSE(const std::string &url, const std::map<std::string, std::string> &headers,
                           EventCallback callback)
 {
-    LOG_INFO_STREAM("HttpClient", "Starting SSE connection to: " << url);
+    return startSSE([url]()
+                    { return url; },
+                    headers, callback);
+}
+
+bool HttpClient::startSSE(UrlProvider urlProvider, const std::map<std::string, std::string> &headers,
+                          EventCallback callback, ErrorCallback onError, ConnectedCallback onConnected)
+{
+    // The provider yields complete URLs, so the transport adds nothing
+    return startNotifications(urlProvider, headers, {std::make_shared<SseTransport>("")}, callback, onError,
+                              onConnected);
+}
+
+bool HttpClient::startNotifications(UrlProvider serverUriProvider, const std::map<std::string, std::string> &headers,
+                                    std::vector<std::shared_ptr<NotificationTransport>> transports,
+                                    EventCallback callback, ErrorCallback onError, ConnectedCallback onConnected)
+{
+    transports.erase(std::remove_if(transports.begin(), transports.end(), [](const auto &transport)
+                                    {
+                                        if (transport->isSupported())
+                                        {
+                                            return false;
+                                        }
+                                        LOG_INFO_STREAM("HttpClient", transport->name() << " is not supported by this libcurl, skipping it");
+                                        return true; }),
+                     transports.end());
+    if (transports.empty())
+    {
+        LOG_ERROR("HttpClient", "No supported transport for the notification stream");
+        return false;
+    }
+
+    LOG_INFO_STREAM("HttpClient", "Starting " << transports.front()->name() << " connection to: "
+                                              << transports.front()->streamUrl(serverUriProvider()));
 
     {
         std::lock_guard<std::mutex> lock(m_sseMutex);
         m_stopFlag = false;
+        m_reconnectFlag = false;
         m_sseRunning = true;
         m_eventCallback = callback;
-        m_sseBuffer.clear();
+        m_connectedCallback = onConnected;
+        m_transports = std::move(transports);
+        m_transport = m_transports.front().get();
+        m_deliverEvent = [this](const std::string &data)
+        { deliverEvent(data); };
     }
 
-    m_sseThread = std::thread([this, url, headers]()
+    m_sseThread = std::thread([this, serverUriProvider, headers, onError]()
                               {
-        LOG_INFO("HttpClient", "SSE thread starting");
-        
-        try {
-            CURL* sse_curl = curl_easy_init();
-            if (!sse_curl) {
-                LOG_ERROR("HttpClient", "Failed to initialize CURL for SSE connection");
-                std::lock_guard<std::mutex> lock(m_sseMutex);
-                m_sseRunning = false;
-                m_sseCondVar.notify_all();
-                return;
-            }
-            LOG_DEBUG("HttpClient", "CURL initialized for SSE connection");
-
-            int retryCount = 0;
-            while (!m_stopFlag) {
-                // Setup SSE connection
-                curl_easy_reset(sse_curl);
-                curl_easy_setopt(sse_curl, CURLOPT_URL, url.c_str());
-                curl_easy_setopt(sse_curl, CURLOPT_WRITEFUNCTION, sseCallback);
-                curl_easy_setopt(sse_curl, CURLOPT_WRITEDATA, this);
-                curl_easy_setopt(sse_curl, CURLOPT_TCP_NODELAY, 1L);
-                
-                // Setup progress monitoring for cancelation
-                curl_easy_setopt(sse_curl, CURLOPT_XFERINFOFUNCTION, sseCallbackProgress);
-                curl_easy_setopt(sse_curl, CURLOPT_XFERINFODATA, this);
-                curl_easy_setopt(sse_curl, CURLOPT_NOPROGRESS, 0L);
-
-                // Setup headers
-                struct curl_slist *curl_headers = createHeaderList(headers);
-                curl_headers = curl_slist_append(curl_headers, "Accept: text/event-stream");
-                curl_easy_setopt(sse_curl, CURLOPT_HTTPHEADER, curl_headers);
-
-                if (m_stopFlag) {
-                    LOG_INFO("HttpClient", "SSE connection setup aborted due to stop request");
-                    curl_slist_free_all(curl_headers);
-                    break;
-                }
-
-                // Perform request
-                LOG_INFO_STREAM("HttpClient", "Establishing SSE connection, attempt #" << (retryCount + 1));
-                CURLcode res = curl_easy_perform(sse_curl);
-                        
-                if (res == CURLE_ABORTED_BY_CALLBACK) {
-                    LOG_INFO("HttpClient", "SSE connection aborted by callback");
-                } else if (res != CURLE_OK) {
-                    retryCount++;
-                    LOG_WARNING_STREAM("HttpClient", "SSE connection error: " << curl_easy_strerror(res) 
-                                     << ", retry count: " << retryCount);
-                    if (!m_stopFlag) {
-                        int retryDelay = (std::min)(5 * retryCount, 60); // Exponential backoff with max 60 seconds
-                        LOG_DEBUG_STREAM("HttpClient", "Retrying SSE connection in " << retryDelay << " seconds");
-                        std::this_thread::sleep_for(std::chrono::seconds(retryDelay));
-                    }
-                } else {
-                    // Connection ended normally, reset retry count
-                    LOG_INFO("HttpClient", "SSE connection ended normally");
-                    retryCount = 0;
-                }
-
-                curl_slist_free_all(curl_headers);
+        LOG_INFO("HttpClient", "Stream thread starting");
 
-                if (m_stopFlag) {
-                    LOG_INFO("HttpClient", "Exiting SSE connection loop due to stop request");
-                    break;
-                }
-            }
-            
-            if (sse_curl) {
-                curl_easy_cleanup(sse_curl);
-                LOG_DEBUG("HttpClient", "Cleaned up CURL handle for SSE");
+        try {
+            if (TrafficReplay::getInstance().isActive()) {
+                replaySSE(serverUriProvider, onError);
+            } else {
+                runStream(serverUriProvider, headers, onError);
             }
         }
         catch (const std::exception& e) {
-            LOG_ERROR("HttpClient", "Exception in SSE thread: " + std::string(e.what()));
+            LOG_ERROR("HttpClient", "Exception in stream thread: " + std::string(e.what()));
         }
         catch (...) {
-            LOG_ERROR("HttpClient", "Unknown exception in SSE thread");
+            LOG_ERROR("HttpClient", "Unknown exception in stream thread");
         }
-        
+
         // Mark as not running and notify waiting threads
         {
             std::lock_guard<std::mutex> lock(m_sseMutex);
             m_sseRunning = false;
             m_sseCondVar.notify_all();
         }
-        
-        LOG_INFO("HttpClient", "SSE thread exiting"); });
 
-    LOG_DEBUG("HttpClient", "SSE thread started successfully");
+        LOG_INFO("HttpClient", "Stream thread exiting"); });
+
+    LOG_DEBUG("HttpClient", "Stream thread started successfully");
     return true;
 }
+
+void HttpClient::runStream(const UrlProvider &urlProvider, const std::map<std::string, std::string> &headers,
+                           const ErrorCallback &onError)
+{
+    CURL *sse_curl = curl_easy_init();
+    if (!sse_curl)
+    {
+        LOG_ERROR("HttpClient", "Failed to initialize CURL for stream connection");
+        return;
+    }
+    LOG_DEBUG("HttpClient", "CURL initialized for stream connection");
+    m_sseCurl = sse_curl;
+
+    // The stream runs alongside requests, so it has a multi handle of its own
+    CURLM *sse_multi = curl_multi_init();
+
+    size_t transportIndex = 0;
+    m_transportWorked = false;
+    int retryCount = 0;
+    while (!aborted())
+    {
+        // Setup the connection, asking for the URL every attempt so a
+        // failover in the caller takes effect on the next reconnect
+        m_transport = m_transports[transportIndex].get();
+        std::string url = m_transport->streamUrl(urlProvider());
+        m_sseUrl = url;
+        m_sseEstablished = false;
+        m_reconnectFlag = false;
+        curl_easy_reset(sse_curl);
+        curl_easy_setopt(sse_curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(sse_curl, CURLOPT_WRITEFUNCTION, sseCallback);
+        curl_easy_setopt(sse_curl, CURLOPT_WRITEDATA, this);
+        curl_easy_setopt(sse_curl, CURLOPT_TCP_NODELAY, 1L);
+
+        // Setup progress monitoring for cancelation
+        curl_easy_setopt(sse_curl, CURLOPT_XFERINFOFUNCTION, sseCallbackProgress);
+        curl_easy_setopt(sse_curl, CURLOPT_XFERINFODATA, this);
+        curl_easy_setopt(sse_curl, CURLOPT_NOPROGRESS, 0L);
+
+        // Setup headers
+        struct curl_slist *curl_headers = createHeaderList(headers);
+        m_transport->prepare(sse_curl, curl_headers);
+        curl_easy_setopt(sse_curl, CURLOPT_HTTPHEADER, curl_headers);
+
+        if (aborted())
+        {
+            LOG_INFO("HttpClient", "Stream connection setup aborted due to stop request");
+            curl_slist_free_all(curl_headers);
+            break;
+        }
+
+        // Perform request; the transport also gets to check the connection
+        // on every pass, at least once a second
+        LOG_INFO_STREAM("HttpClient", "Establishing " << m_transport->name() << " connection to " << url
+                                                      << ", attempt #" << (retryCount + 1));
+        bool dead = false;
+        CURLcode res = performTransfer(sse_multi, sse_curl, [this, sse_curl, &dead]()
+                                       {
+            checkStreamEstablished(sse_curl);
+            dead = m_sseEstablished && !m_transport->keepAlive();
+            return aborted() || m_reconnectFlag || dead; });
+
+        long responseCode = 0;
+        curl_easy_getinfo(sse_curl, CURLINFO_RESPONSE_CODE, &responseCode);
+        bool refused = responseCode != 0 && !m_sseEstablished;
+
+        if (res == CURLE_ABORTED_BY_CALLBACK && m_reconnectFlag && !aborted())
+        {
+            LOG_INFO("HttpClient", "Stream connection dropped for reconnection");
+            retryCount = 0;
+        }
+        else if (res == CURLE_ABORTED_BY_CALLBACK && dead && !aborted())
+        {
+            LOG_INFO("HttpClient", "Stream connection went quiet, reconnecting");
+            retryCount = 0;
+        }
+        else if (res == CURLE_ABORTED_BY_CALLBACK)
+        {
+            LOG_INFO("HttpClient", "Stream connection aborted by callback");
+        }
+        else if (refused && !m_transportWorked && transportIndex + 1 < m_transports.size())
+        {
+            // The server is there but does not speak this transport
+            LOG_INFO_STREAM("HttpClient", m_transport->name() << " refused by " << url << " (HTTP " << responseCode
+                                                              << "), falling back to "
+                                                              << m_transports[transportIndex + 1]->name());
+            ++transportIndex;
+            retryCount = 0;
+        }
+        else if (res != CURLE_OK || refused)
+        {
+            retryCount++;
+            if (res != CURLE_OK)
+            {
+                LOG_WARNING_STREAM("HttpClient", "Stream connection error: " << curl_easy_strerror(res)
+                                                                          << ", retry count: " << retryCount);
+            }
+            else
+            {
+                LOG_WARNING_STREAM("HttpClient", "Stream connection refused with HTTP " << responseCode
+                                                                                     << ", retry count: " << retryCount);
+            }
+            if (!refused && onError && onError())
+            {
+                // The caller failed over to another URL, retry right away
+                LOG_INFO("HttpClient", "Stream URL changed, reconnecting immediately");
+                retryCount = 0;
+            }
+            else if (!aborted())
+            {
+                int retryDelay = (std::min)(5 * retryCount, 60); // Exponential backoff with max 60 seconds
+                LOG_DEBUG_STREAM("HttpClient", "Retrying stream connection in " << retryDelay << " seconds");
+                std::unique_lock<std::mutex> lock(m_sseMutex);
+                m_sseCondVar.wait_for(lock, std::chrono::seconds(retryDelay), [this]()
+                                      { return aborted() || m_reconnectFlag; });
+            }
+        }
+        else
+        {
+            // Connection ended normally, reset retry count
+            LOG_INFO("HttpClient", "Stream connection ended normally");
+            retryCount = 0;
+        }
+
+        curl_slist_free_all(curl_headers);
+
+        if (aborted())
+        {
+            LOG_INFO("HttpClient", "Exiting stream connection loop due to stop request");
+            break;
+        }
+    }
+
+    m_sseCurl = nullptr;
+    curl_multi_cleanup(sse_multi);
+    curl_easy_cleanup(sse_curl);
+    LOG_DEBUG("HttpClient", "Cleaned up CURL handle for stream");
+}
@@ -0,0 +1,203 @@
+#include "latency_tracker.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+namespace
+{
+    // Smallest bucket bound; everything faster lands in the first bucket
+    constexpr double FIRST_BUCKET_US = 100.0;
+
+    // Samples an endpoint needs before its own latency is trusted
+    constexpr uint32_t MIN_SAMPLES = 20;
+
+    // Timeouts are the p99 times this factor
+    constexpr int SAFETY_FACTOR = 4;
+
+    constexpr auto DEFAULT_CONNECT_TIMEOUT = std::chrono::milliseconds(5000);
+    constexpr auto MIN_CONNECT_TIMEOUT = std::chrono::milliseconds(50);
+    constexpr auto MAX_CONNECT_TIMEOUT = std::chrono::milliseconds(5000);
+
+    constexpr auto DEFAULT_TOTAL_TIMEOUT = std::chrono::milliseconds(10000);
+    constexpr auto MIN_TOTAL_TIMEOUT = std::chrono::milliseconds(1000);
+    constexpr auto MAX_TOTAL_TIMEOUT = std::chrono::milliseconds(30000);
+
+    // Endpoints come from configured servers and a few APIs; this only guards
+    // against URLs that keep changing
+    constexpr size_t MAX_ENDPOINTS = 128;
+
+    std::chrono::milliseconds scaledTimeout(const LatencyHistogram &histogram, std::chrono::milliseconds fallback,
+                                            std::chrono::milliseconds floor, std::chrono::milliseconds ceiling)
+    {
+        if (histogram.samples() < MIN_SAMPLES)
+        {
+            return fallback;
+        }
+        auto scaled = std::chrono::duration_cast<std::chrono::milliseconds>(histogram.percentile(0.99) * SAFETY_FACTOR);
+        return (std::clamp)(scaled, floor, ceiling);
+    }
+
+    bool isNumeric(const std::string &segment)
+    {
+        return !segment.empty() && std::all_of(segment.begin(), segment.end(), [](unsigned char c)
+                                               { return std::isdigit(c) != 0; });
+    }
+}
+
+std::chrono::microseconds LatencyHistogram::upperBound(size_t bucket)
+{
+    return std::chrono::microseconds(static_cast<int64_t>(FIRST_BUCKET_US * std::pow(2.0, bucket / 4.0)));
+}
+
+void LatencyHistogram::add(std::chrono::microseconds latency)
+{
+    double ratio = (std::max)(static_cast<double>(latency.count()), FIRST_BUCKET_US) / FIRST_BUCKET_US;
+    size_t bucket = static_cast<size_t>(std::ceil(std::log2(ratio) * 4.0));
+    ++m_counts[(std::min)(bucket, BUCKETS - 1)];
+
+    if (++m_total >= WINDOW)
+    {
+        m_total = 0;
+        for (auto &count : m_counts)
+        {
+            count /= 2;
+            m_total += count;
+        }
+    }
+}
+
+std::chrono::microseconds LatencyHistogram::percentile(double quantile) const
+{
+    if (m_total == 0)
+    {
+        return std::chrono::microseconds(0);
+    }
+
+    auto rank = static_cast<uint32_t>(std::ceil(quantile * m_total));
+    uint32_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKETS; ++bucket)
+    {
+        seen += m_counts[bucket];
+        if (seen >= rank && seen > 0)
+        {
+            return upperBound(bucket);
+        }
+    }
+    return upperBound(BUCKETS - 1);
+}
+
+LatencyTracker &LatencyTracker::getInstance()
+{
+    static LatencyTracker instance;
+    return instance;
+}
+
+std::string LatencyTracker::endpointOf(const std::string &url)
+{
+    size_t schemeEnd = url.find("://");
+    size_t authorityStart = schemeEnd == std::string::npos ? 0 : schemeEnd + 3;
+    size_t pathStart = url.find_first_of("/?#", authorityStart);
+    std::string endpoint = url.substr(0, pathStart);
+    if (pathStart == std::string::npos || url[pathStart] != '/')
+    {
+        return endpoint;
+    }
+
+    size_t pathEnd = url.find_first_of("?#", pathStart);
+    std::string path = url.substr(pathStart, pathEnd == std::string::npos ? std::string::npos : pathEnd - pathStart);
+
+    // Keep the first two segments that name a resource, not an item
+    int kept = 0;
+    size_t pos = 0;
+    while (kept < 2 && pos < path.size())
+    {
+        size_t start = path.find_first_not_of('/', pos);
+        if (start == std::string::npos)
+        {
+            break;
+        }
+        size_t end = path.find('/', start);
+        std::string segment = path.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        pos = end == std::string::npos ? path.size() : end;
+        if (!isNumeric(segment))
+        {
+            endpoint += "/" + segment;
+            ++kept;
+        }
+    }
+    return endpoint;
+}
+
+RequestTimeouts LatencyTracker::timeoutsLocked(const Endpoint *endpoint) const
+{
+    RequestTimeouts timeouts{DEFAULT_CONNECT_TIMEOUT, DEFAULT_TOTAL_TIMEOUT, 0};
+    if (endpoint)
+    {
+        timeouts.connect = scaledTimeout(endpoint->connect, DEFAULT_CONNECT_TIMEOUT, MIN_CONNECT_TIMEOUT,
+                                         MAX_CONNECT_TIMEOUT);
+        timeouts.total = scaledTimeout(endpoint->total, DEFAULT_TOTAL_TIMEOUT, MIN_TOTAL_TIMEOUT, MAX_TOTAL_TIMEOUT);
+    }
+
+    // Connecting is part of the request, so the request gets at least that long
+    timeouts.total = (std::max)(timeouts.total, timeouts.connect);
+    timeouts.lowSpeedTime = static_cast<long>((timeouts.total.count() + 999) / 1000);
+    return timeouts;
+}
+
+RequestTimeouts LatencyTracker::timeoutsFor(const std::string &endpoint) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_endpoints.find(endpoint);
+    return timeoutsLocked(it == m_endpoints.end() ? nullptr : &it->second);
+}
+
+void LatencyTracker::record(const std::string &endpoint, std::chrono::microseconds connectTime,
+                            std::chrono::microseconds totalTime, bool timedOut)
+{
+    // A request that never connected says nothing about how long this
+    // endpoint takes to answer, and must not make dead paths slower to fail
+    if (timedOut && connectTime.count() == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_endpoints.find(endpoint);
+    if (it == m_endpoints.end())
+    {
+        if (m_endpoints.size() >= MAX_ENDPOINTS)
+        {
+            return;
+        }
+        it = m_endpoints.emplace(endpoint, Endpoint()).first;
+    }
+
+    // Reused connections report no connect time
+    if (connectTime.count() > 0)
+    {
+        it->second.connect.add(connectTime);
+    }
+
+    // A timed out request took at least the timeout; counting it as such
+    // raises the timeout of endpoints that are slow rather than dead
+    it->second.total.add(totalTime);
+}
+
+std::vector<EndpointLatencyStats> LatencyTracker::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<EndpointLatencyStats> result;
+    for (const auto &[name, endpoint] : m_endpoints)
+    {
+        EndpointLatencyStats stats;
+        stats.endpoint = name;
+        stats.samples = endpoint.total.samples();
+        stats.p50 = endpoint.total.percentile(0.5);
+        stats.p99 = endpoint.total.percentile(0.99);
+        stats.connectP99 = endpoint.connect.percentile(0.99);
+        stats.timeouts = timeoutsLocked(&endpoint);
+        result.push_back(stats);
+    }
+    return result;
+}
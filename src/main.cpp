@@ -1,12 +1,35 @@
 ﻿#include "main.h"
 #include "config.h"
+#include "control_server.h"
 #include "single_instance.h"
+#include "traffic_recorder.h"
 
 /**
  * Global application instance used by signal handlers
  */
 static Application *g_app = nullptr;
 
+/**
+ * Set by signal handlers to end a replay
+ */
+static WakeSignal *g_replayStop = nullptr;
+
+/**
+ * How long a replay waits for events past the last captured one
+ */
+static constexpr auto REPLAY_GRACE = std::chrono::seconds(10);
+
+/**
+ * Command line options
+ */
+struct Options
+{
+    std::string capturePath;
+    std::string replayPath;
+    double replaySpeed = 1.0; // 0 replays as fast as possible
+    std::string statusRequest; // Sent to the running instance; empty if not --status
+};
+
 /**
  * Signal handler for clean application shutdown
  * @param sig Signal number that triggered the handler
@@ -18,14 +41,241 @@ void signalHandler(int sig)
     {
         g_app->stop();
     }
+    if (g_replayStop)
+    {
+        g_replayStop->notify();
+    }
+}
+
+/**
+ * Register the handlers for a clean shutdown
+ * @return false if a handler could not be registered
+ */
+static bool registerSignalHandlers()
+{
+#ifndef _WIN32
+    return signal(SIGINT, signalHandler) != SIG_ERR &&
+           signal(SIGTERM, signalHandler) != SIG_ERR;
+#else
+    return signal(SIGINT, signalHandler) != SIG_ERR &&
+           signal(SIGBREAK, signalHandler) != SIG_ERR;
+#endif
+}
+
+static void printUsage()
+{
+    fprintf(stderr,
+            "Usage: PresenceForPlex [--capture FILE] [--replay FILE [--replay-speed N|max]]\n"
+            "       PresenceForPlex --status [COMMAND [ARGS...]]\n"
+            "  --capture FILE       Write Plex traffic, tokens removed, to FILE while running\n"
+            "  --replay FILE        Run the Plex pipeline against FILE instead of the network\n"
+            "  --replay-speed N     Replay N times faster than captured (default 1), or max\n"
+            "  --status [COMMAND]   Ask the running instance; COMMAND defaults to status,\n"
+            "                       --status help lists the commands\n");
+}
+
+/**
+ * Parse the command line
+ * @return false if the arguments are invalid
+ */
+static bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--capture" && hasValue)
+        {
+            options.capturePath = argv[++i];
+        }
+        else if (arg == "--replay" && hasValue)
+        {
+            options.replayPath = argv[++i];
+        }
+        else if (arg == "--status")
+        {
+            // Everything after --status is the request
+            options.statusRequest = "status";
+            if (hasValue)
+            {
+                options.statusRequest = argv[++i];
+                while (++i < argc)
+                {
+                    options.statusRequest += std::string(" ") + argv[i];
+                }
+            }
+        }
+        else if (arg == "--replay-speed" && hasValue)
+        {
+            std::string speed = argv[++i];
+            if (speed == "max")
+            {
+                options.replaySpeed = 0;
+                continue;
+            }
+            char *end = nullptr;
+            options.replaySpeed = std::strtod(speed.c_str(), &end);
+            if (end == speed.c_str() || *end != '\0' || !(options.replaySpeed > 0))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return options.capturePath.empty() || options.replayPath.empty();
+}
+
+/**
+ * Point the configuration at an empty scratch directory, so a replay
+ * neither reads nor changes the user's settings and caches
+ */
+static void useScratchConfigDirectory()
+{
+    auto scratch = std::filesystem::temp_directory_path() / "presence-for-plex-replay";
+    std::error_code error;
+    std::filesystem::remove_all(scratch, error);
+    std::filesystem::create_directories(scratch, error);
+#ifdef _WIN32
+    _putenv_s("APPDATA", scratch.string().c_str());
+#else
+    setenv("XDG_CONFIG_DIR", scratch.string().c_str(), 1);
+#endif
+}
+
+/**
+ * Feed a capture through the Plex pipeline and report how it kept up
+ * @return Exit code
+ */
+static int runReplay(const Options &options)
+{
+    useScratchConfigDirectory();
+
+    auto &config = Config::getInstance();
+    Logger::getInstance().setLogLevel(static_cast<LogLevel>(config.getLogLevel()));
+
+    auto &replay = TrafficReplay::getInstance();
+    if (!replay.load(options.replayPath, options.replaySpeed))
+    {
+        return 1;
+    }
+
+    // Tokens were removed from the capture, and the replay matches requests
+    // with their tokens removed, so any token will do
+    config.setPlexAuthToken(TrafficRecorder::REDACTED);
+    config.setPlexUsername(replay.username());
+    for (const auto &server : replay.servers())
+    {
+        config.addPlexServer(server.name, server.clientIdentifier, server.localUri, server.publicUri,
+                             TrafficRecorder::REDACTED, server.owned);
+    }
+
+    WakeSignal stop;
+    g_replayStop = &stop;
+
+    std::atomic<uint64_t> playbackChanges{0};
+    Plex plex;
+    plex.setPlaybackChangedCallback([&playbackChanges]()
+                                    { ++playbackChanges; });
+
+    auto start = std::chrono::steady_clock::now();
+    if (!plex.init())
+    {
+        LOG_ERROR("Main", "Plex failed to initialize from the capture");
+        g_replayStop = nullptr;
+        return 1;
+    }
+
+    // Events for streams the replay never opens are never delivered, so
+    // stop waiting some time after the last one was due
+    auto deadline = start + replay.scaled(replay.lastEventTime()) + REPLAY_GRACE;
+    while (!stop.isSet() && !replay.waitForEvents(std::chrono::milliseconds(100)) &&
+           std::chrono::steady_clock::now() < deadline)
+    {
+    }
+
+    // Let the work the last events started finish; stopping would cancel it
+    while (!stop.isSet() && !plex.waitForSessionWork(std::chrono::milliseconds(100)))
+    {
+    }
+    plex.stop();
+    g_replayStop = nullptr;
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t delivered = replay.deliveredEvents();
+    LOG_INFO_STREAM("Main", "Replay finished: " << delivered << "/" << replay.totalEvents() << " events in "
+                                                << std::fixed << std::setprecision(3) << elapsed << " s ("
+                                                << (elapsed > 0 ? delivered / elapsed : 0.0) << " events/s), "
+                                                << playbackChanges.load() << " playback changes");
+    LOG_INFO_STREAM("Main", "Event handling: p50 " << replay.handlingPercentile(0.5).count() / 1000.0 << " ms, p99 "
+                                                   << replay.handlingPercentile(0.99).count() / 1000.0 << " ms; "
+                                                   << replay.unmatchedRequests() << " requests not in the capture");
+    return delivered == replay.totalEvents() ? 0 : 1;
+}
+
+/**
+ * Send a request to the running instance and print its answer
+ * @return Exit code
+ */
+static int runStatus(const Options &options)
+{
+    std::string response;
+    if (!ControlServer::request(options.statusRequest, response))
+    {
+        fprintf(stderr, "%s\n", response.c_str());
+        return 1;
+    }
+
+    try
+    {
+        auto answer = nlohmann::json::parse(response);
+        if (!answer.value("ok", false))
+        {
+            fprintf(stderr, "%s\n", answer.value("error", std::string("Request failed")).c_str());
+            return 1;
+        }
+        std::cout << answer["result"].dump(2) << std::endl;
+        return 0;
+    }
+    catch (const nlohmann::json::exception &e)
+    {
+        fprintf(stderr, "Invalid response from the running instance: %s\n", e.what());
+        return 1;
+    }
 }
 
 /**
  * Main program entry point
  * @return Exit code (0 for success, non-zero for errors)
  */
-int main()
+int main(int argc, char *argv[])
 {
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 2;
+    }
+
+    if (!options.statusRequest.empty())
+    {
+        return runStatus(options);
+    }
+
+    // A replay never touches Discord or the user's config, so it can run
+    // next to a normal instance
+    if (!options.replayPath.empty())
+    {
+        if (!registerSignalHandlers())
+        {
+            LOG_ERROR("Main", "Failed to register signal handlers");
+            return 1;
+        }
+        return runReplay(options);
+    }
+
     // Check for an existing instance
     SingleInstance singleInstance("PresenceForPlex");
     if (!singleInstance.isFirstInstance()) {
@@ -43,21 +293,11 @@ int main()
     }
 
     // Register signal handlers for graceful shutdown
-#ifndef _WIN32
-    if (signal(SIGINT, signalHandler) == SIG_ERR ||
-        signal(SIGTERM, signalHandler) == SIG_ERR)
-    {
-        LOG_ERROR("Main", "Failed to register signal handlers");
-        return 1;
-    }
-#else
-    if (signal(SIGINT, signalHandler) == SIG_ERR ||
-        signal(SIGBREAK, signalHandler) == SIG_ERR)
+    if (!registerSignalHandlers())
     {
         LOG_ERROR("Main", "Failed to register signal handlers");
         return 1;
     }
-#endif
 
     // Initialize application
     Application app;
@@ -66,6 +306,20 @@ int main()
     auto &config = Config::getInstance();
     LOG_INFO("Application", "Starting Presence For Plex v" + config.getVersionString());
 
+    if (!options.capturePath.empty())
+    {
+        std::vector<RecordedServer> servers;
+        for (const auto &[id, server] : config.getPlexServers())
+        {
+            servers.push_back({server->name, server->clientIdentifier, server->localUri, server->publicUri,
+                               server->owned});
+        }
+        if (!TrafficRecorder::getInstance().start(options.capturePath, config.getPlexUsername(), servers))
+        {
+            return 1;
+        }
+    }
+
     if (!app.initialize())
     {
         LOG_ERROR("Main", "Application failed to initialize");
@@ -74,6 +328,7 @@ int main()
 
     // Run main application loop
     app.run();
+    TrafficRecorder::getInstance().stop();
     return 0;
 }
 
@@ -84,6 +339,6 @@ int main()
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
 {
     // Delegate to the platform-independent main function
-    return main();
+    return main(__argc, __argv);
 }
 #endif
\ No newline at end of file
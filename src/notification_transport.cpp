@@ -0,0 +1,167 @@
+#include "notification_transport.h"
+#include "logger.h"
+
+#include <cstring>
+
+// curl_ws_meta() and the frame flags appeared in 7.86.0
+#if LIBCURL_VERSION_NUM >= 0x075600
+#define HAVE_CURL_WEBSOCKETS 1
+#endif
+
+namespace
+{
+    // Quiet time after which the WebSocket transport pings the server
+    constexpr auto WEBSOCKET_PING_INTERVAL = std::chrono::seconds(30);
+
+    // How long a ping may go unanswered before the connection counts as dead
+    constexpr auto WEBSOCKET_PONG_TIMEOUT = std::chrono::seconds(10);
+}
+
+void SseTransport::prepare(CURL *, struct curl_slist *&headers)
+{
+    m_buffer.clear();
+    headers = curl_slist_append(headers, "Accept: text/event-stream");
+}
+
+void SseTransport::consume(const char *data, size_t size, const EventCallback &onEvent)
+{
+    m_buffer.append(data, size);
+
+    // Process events in buffer
+    size_t pos;
+    while ((pos = m_buffer.find("\n\n")) != std::string::npos)
+    {
+        std::string event = m_buffer.substr(0, pos);
+        m_buffer.erase(0, pos + 2); // +2 for \n\n
+
+        size_t data_pos = event.find("data: ");
+        if (data_pos != std::string::npos)
+        {
+            onEvent(event.substr(data_pos + 6));
+        }
+    }
+}
+
+bool WebSocketTransport::isSupported() const
+{
+#ifdef HAVE_CURL_WEBSOCKETS
+    // The headers may know WebSockets while the library in use was built without
+    static const bool supported = []()
+    {
+        const curl_version_info_data *info = curl_version_info(CURLVERSION_NOW);
+        for (const char *const *protocol = info->protocols; *protocol; ++protocol)
+        {
+            if (std::strcmp(*protocol, "ws") == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+std::string WebSocketTransport::streamUrl(const std::string &serverUri) const
+{
+    if (serverUri.compare(0, 4, "http") == 0)
+    {
+        return "ws" + serverUri.substr(4) + m_endpoint;
+    }
+    return serverUri + m_endpoint;
+}
+
+void WebSocketTransport::prepare(CURL *curl, struct curl_slist *&)
+{
+    m_curl = curl;
+    m_message.clear();
+    m_binary = false;
+    m_lastReceived = Clock::now();
+    m_pingSent = Clock::time_point();
+}
+
+void WebSocketTransport::consume(const char *data, size_t size, const EventCallback &onEvent)
+{
+#ifdef HAVE_CURL_WEBSOCKETS
+    m_lastReceived = Clock::now();
+    m_pingSent = Clock::time_point();
+
+    const struct curl_ws_frame *frame = curl_ws_meta(m_curl);
+    if (!frame)
+    {
+        return;
+    }
+
+    // libcurl answers pings itself, a close ends the transfer, and a pong
+    // has already cleared the pending ping above
+    if (frame->flags & (CURLWS_PING | CURLWS_PONG | CURLWS_CLOSE))
+    {
+        return;
+    }
+
+    // The first fragment says whether the message is text; continuation
+    // fragments carry neither flag
+    if (m_message.empty() && frame->offset == 0 && (frame->flags & (CURLWS_TEXT | CURLWS_BINARY)))
+    {
+        m_binary = (frame->flags & CURLWS_BINARY) != 0;
+    }
+    if (!m_binary)
+    {
+        m_message.append(data, size);
+    }
+
+    // Complete once the last fragment has been read to its end
+    if (frame->bytesleft == 0 && !(frame->flags & CURLWS_CONT))
+    {
+        if (!m_binary && !m_message.empty())
+        {
+            onEvent(m_message);
+        }
+        m_message.clear();
+        m_binary = false;
+    }
+#else
+    (void)data;
+    (void)size;
+    (void)onEvent;
+#endif
+}
+
+bool WebSocketTransport::keepAlive()
+{
+#ifdef HAVE_CURL_WEBSOCKETS
+    auto now = Clock::now();
+    if (m_pingSent != Clock::time_point())
+    {
+        if (now - m_pingSent > WEBSOCKET_PONG_TIMEOUT)
+        {
+            LOG_WARNING("WebSocketTransport", "Server did not answer a ping, dropping the connection");
+            return false;
+        }
+        return true;
+    }
+
+    if (!m_pingUnsupported && now - m_lastReceived >= WEBSOCKET_PING_INTERVAL)
+    {
+        size_t sent = 0;
+        CURLcode result = curl_ws_send(m_curl, "", 0, &sent, 0, CURLWS_PING);
+        if (result == CURLE_AGAIN)
+        {
+            // Send buffer full; try again on the next call
+            return true;
+        }
+        if (result != CURLE_OK)
+        {
+            // Some libcurl versions only send from inside callbacks; streams
+            // then go without liveness checks, like SSE
+            LOG_DEBUG("WebSocketTransport", "Failed to send ping: " + std::string(curl_easy_strerror(result)));
+            m_pingUnsupported = true;
+            return true;
+        }
+        m_pingSent = now;
+    }
+#endif
+    return true;
+}
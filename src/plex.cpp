@@ -12,52 +12,87 @@ namespace
     constexpr const char *JIKAN_API_URL = "https://api.jikan.moe/v4/anime";
     constexpr const char *TMDB_IMAGE_BASE_URL = "https://image.tmdb.org/t/p/w400";
     constexpr const char *SSE_NOTIFICATIONS_ENDPOINT = "/:/eventsource/notifications?filters=playing";
+    constexpr const char *WEBSOCKET_NOTIFICATIONS_ENDPOINT = "/:/websockets/notifications?filters=playing";
     constexpr const char *SESSION_ENDPOINT = "/status/sessions";
+    constexpr const char *IDENTITY_ENDPOINT = "/identity";
+
+    // Published third-party API quotas: Jikan allows 3 requests/s and 60/min,
+    // TMDB has no hard quota but starts answering 429 at around 50 requests/s.
+    // A bucket admits its capacity plus what refills during a window, so
+    // Jikan gets a burst of 3 and 57 more per minute: never over 60 in any
+    // 60 s, nor over 3 in any second
+    const std::vector<RateLimit> JIKAN_RATE_LIMITS = {{3, 57.0 / 60.0}};
+    const std::vector<RateLimit> TMDB_RATE_LIMITS = {{40, 40.0}};
+
+    // A session not heard from for this long is checked against the server,
+    // and all servers are reconciled at this interval (in seconds)
+    constexpr const int SESSION_TTL = 60;
+    constexpr const int SESSION_RECONCILE_INTERVAL = 300;
+
+    // How often better-ranked URIs are probed while failed over (in seconds)
+    constexpr const int FAILBACK_PROBE_INTERVAL = 60;
+
+    // How often the server list is refreshed from plex.tv (in seconds); the
+    // first refresh comes sooner when the list was loaded from the config file
+    constexpr const int RESOURCE_REFRESH_INTERVAL = 3600;
+    constexpr const int RESOURCE_REFRESH_INITIAL_DELAY = 30;
 
     // Cache timeouts (in seconds)
     constexpr const int TMDB_CACHE_TIMEOUT = 86400;  // 24 hours
     constexpr const int MAL_CACHE_TIMEOUT = 86400;   // 24 hours
+    constexpr const int NOT_FOUND_TIMEOUT = 3600;    // 1 hour, doubling per repeated miss up to the found timeout
+    constexpr const int TRANSIENT_TIMEOUT = 120;     // 2 minutes
     constexpr const int MEDIA_CACHE_TIMEOUT = 3600;  // 1 hour
     constexpr const int SESSION_CACHE_TIMEOUT = 300; // 5 minutes
-}
-
-// Cache structures
-struct TimedCacheEntry
-{
-    time_t timestamp;
-    bool valid() const { return (std::time(nullptr) - timestamp) < MEDIA_CACHE_TIMEOUT; }
-};
 
-struct TMDBCacheEntry : TimedCacheEntry
-{
-    std::string artPath;
-    bool valid() const { return (std::time(nullptr) - timestamp) < TMDB_CACHE_TIMEOUT; }
-};
+    // Request templates kept before the table is cleared; a few URIs per server
+    constexpr const size_t MAX_REQUEST_TEMPLATES = 64;
+}
 
-struct MALCacheEntry : TimedCacheEntry
+namespace
 {
-    std::string malId;
-    bool valid() const { return (std::time(nullptr) - timestamp) < MAL_CACHE_TIMEOUT; }
-};
+    // Share of the cache memory budget given to each cache
+    constexpr const size_t MEDIA_CACHE_BUDGET_SHARE = 2;      // 1/2
+    constexpr const size_t TMDB_CACHE_BUDGET_SHARE = 8;       // 1/8
+    constexpr const size_t MAL_CACHE_BUDGET_SHARE = 8;        // 1/8
+    constexpr const size_t SERVER_URI_CACHE_BUDGET_SHARE = 8; // 1/8
+    constexpr const size_t ARTWORK_CACHE_BUDGET_SHARE = 8;    // 1/8
 
-struct MediaCacheEntry : TimedCacheEntry
-{
-    MediaInfo info;
-};
-
-struct SessionUserCacheEntry : TimedCacheEntry
-{
-    std::string username;
-    bool valid() const { return (std::time(nullptr) - timestamp) < SESSION_CACHE_TIMEOUT; }
-};
+    size_t stringSize(const std::string &value)
+    {
+        return value.capacity();
+    }
 
-struct ServerUriCacheEntry : TimedCacheEntry
-{
-    std::string uri;
-    bool valid() const { return (std::time(nullptr) - timestamp) < SESSION_CACHE_TIMEOUT; } // Reuse session timeout
-};
+    size_t mediaMetadataSize(const std::shared_ptr<const MediaMetadata> &metadata)
+    {
+        // Interned strings are shared process-wide and not charged to the cache
+        size_t bytes = sizeof(MediaMetadata) + metadata->genres.capacity() * sizeof(InternedString);
+        for (const std::string *field : {&metadata->title, &metadata->originalTitle, &metadata->artPath,
+                                         &metadata->thumbPath, &metadata->summary, &metadata->imdbId,
+                                         &metadata->tmdbId, &metadata->tvdbId, &metadata->malId,
+                                         &metadata->grandparentTitle, &metadata->grandparentArt,
+                                         &metadata->grandparentKey, &metadata->album, &metadata->artist,
+                                         &metadata->plexampUrl, &metadata->filename, &metadata->mediaKey})
+        {
+            bytes += field->capacity();
+        }
+        return bytes;
+    }
+}
 
-Plex::Plex() : m_initialized(false), m_shuttingDown(false)
+Plex::Plex() : m_initialized(false), m_shuttingDown(false),
+               m_tmdbArtworkCache("tmdb_artwork", Config::getInstance().getCacheMemoryBudget() / TMDB_CACHE_BUDGET_SHARE, stringSize,
+                                  {std::chrono::seconds(TMDB_CACHE_TIMEOUT), std::chrono::seconds(NOT_FOUND_TIMEOUT),
+                                   std::chrono::seconds(TMDB_CACHE_TIMEOUT), std::chrono::seconds(TRANSIENT_TIMEOUT)}),
+               m_malIdCache("mal_id", Config::getInstance().getCacheMemoryBudget() / MAL_CACHE_BUDGET_SHARE, stringSize,
+                            {std::chrono::seconds(MAL_CACHE_TIMEOUT), std::chrono::seconds(NOT_FOUND_TIMEOUT),
+                             std::chrono::seconds(MAL_CACHE_TIMEOUT), std::chrono::seconds(TRANSIENT_TIMEOUT)}),
+               m_mediaInfoCache("media_info", Config::getInstance().getCacheMemoryBudget() / MEDIA_CACHE_BUDGET_SHARE, mediaMetadataSize),
+               m_serverUriCache("server_uri", Config::getInstance().getCacheMemoryBudget() / SERVER_URI_CACHE_BUDGET_SHARE, stringSize),
+               m_artworkResolver(Config::getInstance().getCacheMemoryBudget() / ARTWORK_CACHE_BUDGET_SHARE, &m_stopSignal),
+               m_jikanClient("Jikan", JIKAN_RATE_LIMITS),
+               m_tmdbClient("TMDB", TMDB_RATE_LIMITS),
+               m_sessionTimers(std::chrono::seconds(1), 64)
 {
     LOG_INFO("Plex", "Plex object created");
 }
@@ -77,6 +112,7 @@ bool Plex::init()
     }
     m_initialized = false;
     m_shuttingDown = false;
+    m_stopSignal.reset();
 
     // Check if we have a Plex auth token
     auto &config = Config::getInstance();
@@ -110,6 +146,22 @@ bool Plex::init()
     // Set up SSE connections to each server
     setupServerConnections();
 
+    // Start probing for better connections to fail back to
+    m_failbackThread = std::thread(&Plex::failbackLoop, this);
+
+    // Pick up new shares, changed addresses and rotated tokens in the background
+    m_resourceRefreshThread = std::thread(&Plex::resourceRefreshLoop, this);
+
+    // Expire ghost sessions and resync after stream reconnects
+    m_reconcileThread = std::thread(&Plex::sessionReconcileLoop, this);
+    m_reconcileTimer = TimerService::getInstance().scheduleRepeating(
+        std::chrono::seconds(SESSION_RECONCILE_INTERVAL), [this]()
+        {
+            std::lock_guard<std::mutex> lock(m_reconcileMutex);
+            m_reconcileAllDue = true;
+            m_reconcileCv.notify_one(); },
+        std::chrono::seconds(SESSION_RECONCILE_INTERVAL / 10));
+
     m_initialized = true;
     return true;
 }
@@ -118,27 +170,68 @@ bool Plex::init()
 // Standard headers helper method
 std::map<std::string, std::string> Plex::getStandardHeaders(const std::string &token)
 {
-    std::map<std::string, std::string> headers = {
-        {"X-Plex-Client-Identifier", getClientIdentifier()},
-        {"X-Plex-Product", "Presence For Plex"},
-        {"X-Plex-Version", Config::getInstance().getVersionString()},
-        {"X-Plex-Device", "PC"},
+    std::map<std::string, std::string> headers;
+    {
+        std::lock_guard<std::mutex> lock(m_templateMutex);
+        headers = standardHeadersLocked();
+    }
+
+    // Add token if provided
+    if (!token.empty())
+    {
+        headers["X-Plex-Token"] = token;
+    }
+
+    return headers;
+}
+
+const std::map<std::string, std::string> &Plex::standardHeadersLocked()
+{
+    // The client identifier and version never change while we run
+    if (m_standardHeaders.empty())
+    {
+        m_standardHeaders = {
+            {"X-Plex-Client-Identifier", getClientIdentifier()},
+            {"X-Plex-Product", "Presence For Plex"},
+            {"X-Plex-Version", Config::getInstance().getVersionString()},
+            {"X-Plex-Device", "PC"},
 #if defined(_WIN32)
-        {"X-Plex-Platform", "Windows"},
+            {"X-Plex-Platform", "Windows"},
 #elif defined(__APPLE__)
-        {"X-Plex-Platform", "macOS"},
+            {"X-Plex-Platform", "macOS"},
 #else
-        {"X-Plex-Platform", "Linux"},
+            {"X-Plex-Platform", "Linux"},
 #endif
-        {"Accept", "application/json"}};
+            {"Accept", "application/json"}};
+    }
+    return m_standardHeaders;
+}
 
-    // Add token if provided
+std::shared_ptr<const RequestTemplate> Plex::requestTemplate(const std::string &serverUri, const std::string &token)
+{
+    std::lock_guard<std::mutex> lock(m_templateMutex);
+    auto key = std::make_pair(serverUri, token);
+    auto it = m_requestTemplates.find(key);
+    if (it != m_requestTemplates.end())
+    {
+        return it->second;
+    }
+
+    // Old URIs and tokens only pile up if they keep changing; requests still
+    // holding a dropped template keep it alive until they finish
+    if (m_requestTemplates.size() >= MAX_REQUEST_TEMPLATES)
+    {
+        m_requestTemplates.clear();
+    }
+
+    auto headers = standardHeadersLocked();
     if (!token.empty())
     {
         headers["X-Plex-Token"] = token;
     }
-
-    return headers;
+    auto request = std::make_shared<const RequestTemplate>(serverUri, std::move(headers));
+    m_requestTemplates.emplace(std::move(key), request);
+    return request;
 }
 
 bool Plex::acquireAuthToken()
@@ -151,7 +244,7 @@ bool Plex::acquireAuthToken()
 #endif
 
     std::string clientId = getClientIdentifier();
-    HttpClient client;
+    HttpClient client(&m_stopSignal);
     std::map<std::string, std::string> headers = getStandardHeaders();
 
     // Request a PIN from Plex
@@ -232,7 +325,6 @@ bool Plex::pollForPinAuthorization(const std::string &pinId, const std::string &
 {
     const int maxAttempts = 30;  // Try for about 5 minutes
     const int pollInterval = 10; // seconds
-    const int sleepChunks = 10;  // Break sleep into smaller chunks
 
     LOG_INFO("Plex", "Waiting for user to authorize PIN...");
 
@@ -245,13 +337,8 @@ bool Plex::pollForPinAuthorization(const std::string &pinId, const std::string &
             return false;
         }
 
-        // Wait before polling, but check for shutdown more frequently
-        for (int i = 0; i < sleepChunks && !m_shuttingDown; ++i)
-        {
-            std::this_thread::sleep_for(std::chrono::seconds(pollInterval / sleepChunks));
-        }
-
-        if (m_shuttingDown)
+        // Wait before polling; stop() cuts the wait short
+        if (m_stopSignal.waitFor(std::chrono::seconds(pollInterval)))
         {
             LOG_INFO("Plex", "Application is shutting down, aborting PIN authorization");
             return false;
@@ -317,7 +404,7 @@ bool Plex::fetchAndSaveUsername(const std::string &authToken, const std::string
     LOG_INFO("Plex", "Fetching Plex username");
 
     // Create HTTP client
-    HttpClient client;
+    HttpClient client(&m_stopSignal);
     std::map<std::string, std::string> headers = getStandardHeaders(authToken);
 
     // Make the request to fetch account information
@@ -382,6 +469,21 @@ bool Plex::fetchServers()
 {
     LOG_INFO("Plex", "Fetching Plex servers");
 
+    std::string response;
+    if (!fetchServerResources(response, false))
+    {
+        return false;
+    }
+
+    LOG_DEBUG("Plex", "Received server response: " + response);
+    m_resourcesHash = std::hash<std::string>{}(response);
+
+    // Parse the JSON response
+    return parseServerJson(response);
+}
+
+bool Plex::fetchServerResources(std::string &response, bool conditional)
+{
     auto &config = Config::getInstance();
     std::string authToken = config.getPlexAuthToken();
     std::string clientId = config.getPlexClientIdentifier();
@@ -393,36 +495,79 @@ bool Plex::fetchServers()
     }
 
     // Create HTTP client and headers
-    HttpClient client;
+    HttpClient client(&m_stopSignal);
     std::map<std::string, std::string> headers = getStandardHeaders(authToken);
+    if (conditional && !m_resourcesEtag.empty())
+    {
+        headers["If-None-Match"] = m_resourcesEtag;
+    }
+    if (conditional && !m_resourcesLastModified.empty())
+    {
+        headers["If-Modified-Since"] = m_resourcesLastModified;
+    }
 
     // Make the request to Plex.tv
-    std::string response;
-
-    if (!client.get(PLEX_RESOURCES_URL, headers, response))
+    bool success = client.get(PLEX_RESOURCES_URL, headers, response);
+    if (client.lastStatusCode() == 304)
+    {
+        // Not modified: report success with an empty response
+        response.clear();
+        return true;
+    }
+    if (!success)
     {
         LOG_ERROR("Plex", "Failed to fetch servers from Plex.tv");
         return false;
     }
 
-    LOG_DEBUG("Plex", "Received server response: " + response);
-
-    // Parse the JSON response
-    return parseServerJson(response);
+    // Remember the validators, if plex.tv sent any, for the next conditional request
+    const auto &responseHeaders = client.lastResponseHeaders();
+    auto etag = responseHeaders.find("etag");
+    m_resourcesEtag = etag != responseHeaders.end() ? etag->second : "";
+    auto lastModified = responseHeaders.find("last-modified");
+    m_resourcesLastModified = lastModified != responseHeaders.end() ? lastModified->second : "";
+    return true;
 }
 
 bool Plex::parseServerJson(const std::string &jsonStr)
 {
     LOG_INFO("Plex", "Parsing server JSON");
 
-    try
+    std::map<std::string, std::shared_ptr<PlexServer>> servers;
+    if (!parseServerResources(jsonStr, servers))
     {
-        auto json = nlohmann::json::parse(jsonStr);
+        return false;
+    }
 
-        auto &config = Config::getInstance();
+    auto &config = Config::getInstance();
+
+    // Keep the per-server settings that plex.tv does not know about
+    for (const auto &[id, server] : servers)
+    {
+        if (auto previous = config.getPlexServer(id))
+        {
+            server->notifications = previous->notifications;
+        }
+    }
+
+    // Replace existing servers in config
+    config.clearPlexServers();
+    for (const auto &[id, server] : servers)
+    {
+        config.setPlexServer(server);
+    }
 
-        // Clear existing servers in config
-        config.clearPlexServers();
+    config.saveConfig();
+
+    LOG_INFO("Plex", "Found " + std::to_string(servers.size()) + " Plex servers");
+    return !servers.empty();
+}
+
+bool Plex::parseServerResources(const std::string &jsonStr, std::map<std::string, std::shared_ptr<PlexServer>> &servers)
+{
+    try
+    {
+        auto json = nlohmann::json::parse(jsonStr);
 
         // Process each resource (server)
         for (const auto &resource : json)
@@ -441,9 +586,9 @@ bool Plex::parseServerJson(const std::string &jsonStr)
             server->running = false;
             server->owned = resource.value("owned", false);
 
-            LOG_INFO("Plex", "Found server: " + server->name +
-                                 " (" + server->clientIdentifier + ")" +
-                                 (server->owned ? " [owned]" : " [shared]"));
+            LOG_DEBUG("Plex", "Found server: " + server->name +
+                                  " (" + server->clientIdentifier + ")" +
+                                  (server->owned ? " [owned]" : " [shared]"));
 
             // Process connections (we want both local and remote)
             if (resource.contains("connections") && resource["connections"].is_array())
@@ -456,30 +601,23 @@ bool Plex::parseServerJson(const std::string &jsonStr)
                     if (isLocal)
                     {
                         server->localUri = uri;
-                        LOG_INFO("Plex", "  Local URI: " + uri);
+                        LOG_DEBUG("Plex", "  Local URI: " + uri);
                     }
                     else
                     {
                         server->publicUri = uri;
-                        LOG_INFO("Plex", "  Public URI: " + uri);
+                        LOG_DEBUG("Plex", "  Public URI: " + uri);
                     }
                 }
             }
 
-            // Add server to our map and config
+            // Only keep servers we can connect to
             if (!server->localUri.empty() || !server->publicUri.empty())
             {
-                // Save to config with ownership status
-                config.addPlexServer(server->name, server->clientIdentifier,
-                                     server->localUri, server->publicUri,
-                                     server->accessToken, server->owned);
+                servers[server->clientIdentifier] = server;
             }
         }
-
-        config.saveConfig();
-
-        LOG_INFO("Plex", "Found " + std::to_string(config.getPlexServers().size()) + " Plex servers");
-        return !config.getPlexServers().empty();
+        return true;
     }
     catch (const std::exception &e)
     {
@@ -488,28 +626,394 @@ bool Plex::parseServerJson(const std::string &jsonStr)
     }
 }
 
+void Plex::resourceRefreshLoop()
+{
+    LOG_DEBUG("Plex", "Server resource refresh thread started");
+
+    while (!m_shuttingDown)
+    {
+        int delay = m_resourcesHash == 0 ? RESOURCE_REFRESH_INITIAL_DELAY : RESOURCE_REFRESH_INTERVAL;
+        if (m_stopSignal.waitFor(std::chrono::seconds(delay)))
+        {
+            break;
+        }
+
+        refreshServers();
+    }
+
+    LOG_DEBUG("Plex", "Server resource refresh thread exiting");
+}
+
+void Plex::refreshServers()
+{
+    LOG_DEBUG("Plex", "Refreshing Plex servers from Plex.tv");
+
+    std::string response;
+    if (!fetchServerResources(response, true))
+    {
+        return;
+    }
+    if (response.empty())
+    {
+        LOG_DEBUG("Plex", "Server resources not modified");
+        return;
+    }
+
+    // plex.tv does not always send validators, so also skip identical bodies
+    size_t hash = std::hash<std::string>{}(response);
+    if (hash == m_resourcesHash)
+    {
+        LOG_DEBUG("Plex", "Server resources unchanged");
+        return;
+    }
+
+    std::map<std::string, std::shared_ptr<PlexServer>> servers;
+    if (!parseServerResources(response, servers))
+    {
+        return;
+    }
+    m_resourcesHash = hash;
+
+    if (servers.empty())
+    {
+        // More likely a bad response than the user losing every server
+        LOG_WARNING("Plex", "Plex.tv returned no servers, keeping the current list");
+        return;
+    }
+
+    applyServerChanges(servers);
+}
+
+void Plex::applyServerChanges(const std::map<std::string, std::shared_ptr<PlexServer>> &servers)
+{
+    auto &config = Config::getInstance();
+    auto current = config.getPlexServers();
+    bool changed = false;
+
+    for (const auto &[id, server] : current)
+    {
+        if (servers.find(id) == servers.end())
+        {
+            LOG_INFO("Plex", "Server no longer available: " + server->name);
+            stopServerSSEConnection(server);
+            config.removePlexServer(id);
+            forgetServer(id);
+            changed = true;
+        }
+    }
+
+    for (const auto &[id, server] : servers)
+    {
+        auto existing = current.find(id);
+        if (existing == current.end())
+        {
+            LOG_INFO("Plex", "New server available: " + server->name);
+            config.setPlexServer(server);
+            setupServerSSEConnection(server);
+            changed = true;
+            continue;
+        }
+
+        const auto &old = existing->second;
+        server->notifications = old->notifications;
+        if (old->name == server->name && old->localUri == server->localUri &&
+            old->publicUri == server->publicUri && old->accessToken == server->accessToken &&
+            old->owned == server->owned)
+        {
+            continue;
+        }
+
+        // Replace rather than mutate, so threads still holding the old
+        // object never see a half-updated server
+        LOG_INFO("Plex", "Server details changed, reconnecting: " + server->name);
+        stopServerSSEConnection(old);
+        forgetServer(id);
+        config.setPlexServer(server);
+        setupServerSSEConnection(server);
+        changed = true;
+    }
+
+    if (changed)
+    {
+        config.saveConfig();
+    }
+}
+
+void Plex::forgetServer(const std::string &serverId)
+{
+    std::vector<std::string> uris;
+    {
+        std::lock_guard<std::mutex> connectionLock(m_connectionMutex);
+        auto connection = m_serverConnections.find(serverId);
+        if (connection != m_serverConnections.end())
+        {
+            uris = connection->second->candidates();
+            m_serverConnections.erase(connection);
+        }
+    }
+    if (auto cachedUri = m_serverUriCache.get(serverId))
+    {
+        uris.push_back(*cachedUri);
+    }
+    m_serverUriCache.erase(serverId);
+
+    // Cached metadata embeds the server's token in its artwork URL, and the
+    // token may be what changed
+    for (const auto &uri : uris)
+    {
+        if (!uri.empty())
+        {
+            m_mediaInfoCache.erasePrefix(uri + "/");
+            m_artworkResolver.forgetServer(uri);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> bringUpLock(m_bringUpMutex);
+        m_deferredServers.erase(serverId);
+        if (m_pendingStreams.erase(serverId) > 0)
+        {
+            reportBringUpLocked();
+        }
+    }
+
+    // Session IDs sort by server first, so the server's sessions are one range
+    std::lock_guard<std::mutex> sessionLock(m_sessionMutex);
+    auto first = m_sessionLatestEvent.lower_bound(SessionId(serverId, ""));
+    auto last = first;
+    while (last != m_sessionLatestEvent.end() && last->first.first == serverId)
+    {
+        ++last;
+    }
+
+    for (auto it = first; it != last; ++it)
+    {
+        m_sessionTimers.cancel(it->first);
+    }
+    m_sessionLatestEvent.erase(first, last);
+
+    auto work = m_sessionWork.lower_bound(SessionId(serverId, ""));
+    auto workEnd = work;
+    while (workEnd != m_sessionWork.end() && workEnd->first.first == serverId)
+    {
+        ++workEnd;
+    }
+    cancelSessionWorkLocked(work, workEnd);
+
+    for (auto it = m_activeSessions.lower_bound(SessionId(serverId, ""));
+         it != m_activeSessions.end() && it->first.first == serverId;)
+    {
+        m_sessionsByStart.erase({it->second.playback.startTime, it->first});
+        it = m_activeSessions.erase(it);
+    }
+    publishCurrentSessionLocked();
+}
+
 void Plex::setupServerConnections()
 {
     LOG_INFO("Plex", "Setting up server connections");
 
-    for (auto &[id, server] : Config::getInstance().getPlexServers())
+    std::vector<std::shared_ptr<PlexServer>> servers;
     {
-        setupServerSSEConnection(server);
+        std::lock_guard<std::mutex> lock(m_bringUpMutex);
+        m_bringUpStart = std::chrono::steady_clock::now();
+        m_pendingStreams.clear();
+        m_deferredServers.clear();
+        for (auto &[id, server] : Config::getInstance().getPlexServers())
+        {
+            m_pendingStreams.insert(id);
+            servers.push_back(server);
+        }
+        m_bringUpServerCount = servers.size();
+        m_bringUpReported = servers.empty();
+    }
+
+    bringUpServers(servers);
+}
+
+void Plex::bringUpServers(const std::vector<std::shared_ptr<PlexServer>> &servers)
+{
+    // Probing an unreachable server can take a full request timeout per URI,
+    // so every server gets its own thread and no server waits on another
+    std::vector<std::thread> threads;
+    threads.reserve(servers.size());
+    for (const auto &server : servers)
+    {
+        threads.emplace_back([this, server]()
+                             {
+            try
+            {
+                setupServerSSEConnection(server);
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR("Plex", "Failed to bring up server " + server->name + ": " + e.what());
+                deferServer(server);
+            } });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void Plex::retryDeferredServers()
+{
+    std::vector<std::shared_ptr<PlexServer>> servers;
+    {
+        std::lock_guard<std::mutex> lock(m_bringUpMutex);
+        for (const auto &id : m_deferredServers)
+        {
+            if (auto server = Config::getInstance().getPlexServer(id))
+            {
+                servers.push_back(server);
+            }
+        }
+    }
+
+    if (servers.empty() || m_shuttingDown)
+    {
+        return;
+    }
+
+    LOG_DEBUG("Plex", "Retrying " + std::to_string(servers.size()) + " offline server(s)");
+    bringUpServers(servers);
+}
+
+void Plex::markStreamConnected(const std::string &serverId)
+{
+    std::lock_guard<std::mutex> lock(m_bringUpMutex);
+    if (m_pendingStreams.erase(serverId) > 0)
+    {
+        reportBringUpLocked();
+    }
+}
+
+void Plex::deferServer(const std::shared_ptr<PlexServer> &server)
+{
+    LOG_WARNING("Plex", "No reachable URI for server " + server->name + ", retrying in the background");
+
+    std::lock_guard<std::mutex> lock(m_bringUpMutex);
+    m_deferredServers.insert(server->clientIdentifier);
+    if (m_pendingStreams.erase(server->clientIdentifier) > 0)
+    {
+        reportBringUpLocked();
+    }
+}
+
+void Plex::reportBringUpLocked()
+{
+    if (m_bringUpReported || !m_pendingStreams.empty())
+    {
+        return;
+    }
+    m_bringUpReported = true;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - m_bringUpStart);
+    size_t deferred = m_deferredServers.size();
+    LOG_INFO("Plex", "All reachable server streams connected in " + std::to_string(elapsed.count()) + " ms (" +
+                         std::to_string(m_bringUpServerCount - deferred) + " connected, " +
+                         std::to_string(deferred) + " offline)");
+}
+
+std::shared_ptr<ServerConnection> Plex::getServerConnection(const std::shared_ptr<PlexServer> &server)
+{
+    std::lock_guard<std::mutex> lock(m_connectionMutex);
+    auto &connection = m_serverConnections[server->clientIdentifier];
+    if (!connection)
+    {
+        // Same ranking as the initial probe: public first, local as fallback
+        connection = std::make_shared<ServerConnection>(
+            std::vector<std::string>{server->publicUri, server->localUri});
+    }
+    return connection;
+}
+
+void Plex::reportServerFailure(const std::shared_ptr<PlexServer> &server)
+{
+    auto connection = getServerConnection(server);
+    if (connection->reportFailure())
+    {
+        LOG_INFO("Plex", "Server " + server->name + " failed over to " + connection->activeUri());
+        if (auto client = server->streamClient())
+        {
+            client->reconnectSSE();
+        }
+    }
+}
+
+bool Plex::probeServerUri(const std::string &uri, const std::string &accessToken)
+{
+    HttpClient probeClient(&m_stopSignal);
+    std::string response;
+    return probeClient.get(*requestTemplate(uri, accessToken), IDENTITY_ENDPOINT, response);
+}
+
+void Plex::failbackLoop()
+{
+    LOG_DEBUG("Plex", "Fail-back probe thread started");
+
+    while (!m_shuttingDown)
+    {
+        if (m_stopSignal.waitFor(std::chrono::seconds(FAILBACK_PROBE_INTERVAL)))
+        {
+            break;
+        }
+
+        // Servers that were unreachable so far get another chance first
+        retryDeferredServers();
+
+        for (auto &[id, server] : Config::getInstance().getPlexServers())
+        {
+            auto connection = getServerConnection(server);
+            if (!connection->isFailedOver())
+            {
+                continue;
+            }
+
+            for (const auto &candidate : connection->betterCandidates())
+            {
+                if (m_shuttingDown)
+                {
+                    break;
+                }
+
+                LOG_DEBUG("Plex", "Probing preferred URI for server " + server->name + ": " + candidate);
+                if (probeServerUri(candidate, server->accessToken))
+                {
+                    LOG_INFO("Plex", "Preferred URI reachable again, failing back: " + candidate);
+                    auto client = server->streamClient();
+                    if (connection->setActive(candidate) && client)
+                    {
+                        client->reconnectSSE();
+                    }
+                    break;
+                }
+            }
+        }
     }
+
+    LOG_DEBUG("Plex", "Fail-back probe thread exiting");
 }
 
 std::string Plex::getPreferredServerUri(const std::shared_ptr<PlexServer> &server)
 {
+    // Follow the connection the server is currently using, if one has been picked
+    auto connection = getServerConnection(server);
+    std::string activeUri = connection->activeUri();
+    if (!activeUri.empty())
+    {
+        return activeUri;
+    }
+
     // Check if we have a cached URI that's still valid
     std::string serverId = server->clientIdentifier;
+    if (auto cachedUri = m_serverUriCache.get(serverId))
     {
-        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-        auto cacheIt = m_serverUriCache.find(serverId);
-        if (cacheIt != m_serverUriCache.end() && cacheIt->second.valid())
-        {
-            LOG_DEBUG("Plex", "Using cached URI for server " + server->name + ": " + cacheIt->second.uri);
-            return cacheIt->second.uri;
-        }
+        LOG_DEBUG("Plex", "Using cached URI for server " + server->name + ": " + *cachedUri);
+        connection->setActive(*cachedUri);
+        return *cachedUri;
     }
 
     // No valid cache entry, determine the best URI to use
@@ -519,7 +1023,7 @@ std::string Plex::getPreferredServerUri(const std::shared_ptr<PlexServer> &serve
     if (!server->publicUri.empty())
     {
         LOG_DEBUG("Plex", "Testing public URI accessibility: " + server->publicUri);
-        HttpClient testClient;
+        HttpClient testClient(&m_stopSignal);
         std::map<std::string, std::string> headers = getStandardHeaders(server->accessToken);
         std::string response;
 
@@ -560,22 +1064,25 @@ std::string Plex::getPreferredServerUri(const std::shared_ptr<PlexServer> &serve
         serverUri = server->localUri;
     }
 
-    // Cache the result
+    if (serverUri.empty())
     {
-        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-        ServerUriCacheEntry entry;
-        entry.timestamp = std::time(nullptr);
-        entry.uri = serverUri;
-        m_serverUriCache[serverId] = entry;
+        return serverUri;
     }
 
+    // Cache the result; failures are not cached so a retry probes again
+    m_serverUriCache.put(serverId, serverUri, std::chrono::seconds(SESSION_CACHE_TIMEOUT)); // Reuse session timeout
+    connection->setActive(serverUri);
+
     return serverUri;
 }
 
-void Plex::setupServerSSEConnection(const std::shared_ptr<PlexServer> &server)
+bool Plex::setupServerSSEConnection(const std::shared_ptr<PlexServer> &server)
 {
-    // Create a new HTTP client for this server
-    server->httpClient = std::make_unique<HttpClient>();
+    // Create a new HTTP client for this server. Should another thread set the
+    // server up at the same time, the client replaced last is stopped once
+    // its set-up lets go of it
+    auto client = std::make_shared<HttpClient>(&m_stopSignal);
+    server->replaceStreamClient(client);
     server->running = true;
 
     // Get the preferred URI
@@ -583,18 +1090,38 @@ void Plex::setupServerSSEConnection(const std::shared_ptr<PlexServer> &server)
 
     if (serverUri.empty())
     {
-        LOG_WARNING("Plex", "No URI available for server: " + server->name);
-        return;
+        deferServer(server);
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_bringUpMutex);
+        m_deferredServers.erase(server->clientIdentifier);
     }
+    auto connection = getServerConnection(server);
 
-    LOG_INFO("Plex", "Setting up SSE connection to server: " + server->name + " using " +
+    LOG_INFO("Plex", "Setting up notification stream to server: " + server->name + " using " +
                          (serverUri == server->localUri ? "local" : "public") + " URI");
 
     // Set up headers
     std::map<std::string, std::string> headers = getStandardHeaders(server->accessToken);
 
-    // Set up SSE endpoint URL
-    std::string sseUrl = serverUri + SSE_NOTIFICATIONS_ENDPOINT;
+    // The stream follows whichever URI the connection currently considers active
+    auto urlProvider = [connection]()
+    {
+        return connection->activeUri();
+    };
+
+    // Transports in order of preference; the client skips what its libcurl
+    // cannot do and falls back when a server refuses WebSockets
+    std::vector<std::shared_ptr<NotificationTransport>> transports;
+    if (server->notifications != NotificationProtocol::SSE)
+    {
+        transports.push_back(std::make_shared<WebSocketTransport>(WEBSOCKET_NOTIFICATIONS_ENDPOINT));
+    }
+    if (server->notifications != NotificationProtocol::WebSocket || !transports.front()->isSupported())
+    {
+        transports.push_back(std::make_shared<SseTransport>(SSE_NOTIFICATIONS_ENDPOINT));
+    }
 
     // Set up callback for SSE events
     auto callback = [this, id = server->clientIdentifier](const std::string &event)
@@ -602,10 +1129,44 @@ void Plex::setupServerSSEConnection(const std::shared_ptr<PlexServer> &server)
         this->handleSSEEvent(id, event);
     };
 
-    // Start SSE connection
-    if (!server->httpClient->startSSE(sseUrl, headers, callback))
+    auto onError = [connection, name = server->name]()
+    {
+        bool failedOver = connection->reportFailure();
+        if (failedOver)
+        {
+            LOG_INFO("Plex", "SSE for server " + name + " failing over to " + connection->activeUri());
+        }
+        return failedOver;
+    };
+
+    auto onConnected = [this, connection, id = server->clientIdentifier]()
     {
-        LOG_ERROR("Plex", "Failed to set up SSE connection for server: " + server->name);
+        connection->reportSuccess();
+        markStreamConnected(id);
+
+        // Events may have been missed while the stream was down
+        requestSessionSweep(id);
+    };
+
+    // Start the notification stream
+    if (!client->startNotifications(urlProvider, headers, transports, callback, onError, onConnected))
+    {
+        LOG_ERROR("Plex", "Failed to set up notification stream for server: " + server->name);
+        return false;
+    }
+    return true;
+}
+
+void Plex::stopServerSSEConnection(const std::shared_ptr<PlexServer> &server)
+{
+    if (auto client = server->replaceStreamClient(nullptr))
+    {
+        LOG_INFO("Plex", "Stopping SSE connection for server: " + server->name);
+        server->running = false;
+
+        // Stops the stream, unless a thread nudging it still holds a
+        // reference; that thread then stops it when it lets go
+        client.reset();
     }
 }
 
@@ -613,64 +1174,351 @@ void Plex::handleSSEEvent(const std::string &serverId, const std::string &event)
 {
     try
     {
-        auto json = nlohmann::json::parse(event);
-
-        LOG_DEBUG("Plex", "Received event from server " + serverId + ": " + event);
-
-        // Check for PlaySessionStateNotification
-        if (json.contains("PlaySessionStateNotification"))
+        auto json = nlohmann::json::parse(event);
+
+        LOG_DEBUG("Plex", "Received event from server " + serverId + ": " + event);
+
+        // WebSocket messages wrap a list of notifications in a container,
+        // SSE events carry a single one
+        const auto &notifications = json.contains("NotificationContainer") ? json["NotificationContainer"] : json;
+
+        // Check for PlaySessionStateNotification
+        auto playing = notifications.find("PlaySessionStateNotification");
+        if (playing != notifications.end() && playing->is_array())
+        {
+            for (const auto &notification : *playing)
+            {
+                processPlaySessionStateNotification(serverId, notification);
+            }
+        }
+        else if (playing != notifications.end())
+        {
+            processPlaySessionStateNotification(serverId, *playing);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR("Plex", "Error parsing SSE event: " + std::string(e.what()) +
+                              ", Event: " + event.substr(0, 100) + (event.length() > 100 ? "..." : ""));
+    }
+}
+
+void Plex::processPlaySessionStateNotification(const std::string &serverId, const nlohmann::json &notification)
+{
+    LOG_DEBUG("Plex", "Processing PlaySessionStateNotification: " + notification.dump());
+
+    // Find the server
+    auto server = Config::getInstance().getPlexServer(serverId);
+    if (!server)
+    {
+        LOG_ERROR("Plex", "Unknown server ID: " + serverId);
+        return;
+    }
+
+    // Extract essential session information
+    std::string sessionKey = notification.value("sessionKey", "");
+    std::string state = notification.value("state", "");
+    std::string mediaKey = notification.value("key", "");
+    int64_t viewOffset = notification.value("viewOffset", 0);
+
+    LOG_DEBUG("Plex", "Playback state update received: " + state + " sessionKey: " + sessionKey);
+
+    bool active = state == "playing" || state == "paused" || state == "buffering";
+    SessionId sessionId(serverId, sessionKey);
+    uint64_t eventSeq;
+    std::optional<CancellationToken> cancel; // Only events that fetch need one
+    {
+        std::lock_guard<std::mutex> lock(m_sessionMutex);
+        if (m_shuttingDown)
+        {
+            return;
+        }
+        eventSeq = ++m_sessionEventSeq;
+
+        if (active)
+        {
+            m_sessionLatestEvent[sessionId] = eventSeq;
+            touchSession(sessionId);
+
+            // Progress updates for the same item keep the running fetch (and
+            // anyone sharing its flight) alive; a new item abandons it
+            auto work = m_sessionWork.find(sessionId);
+            if (work != m_sessionWork.end() && work->second.mediaKey != mediaKey)
+            {
+                LOG_DEBUG("Plex", "Session " + sessionKey + " moved on, cancelling its stale fetches");
+                work->second.cancel.cancel();
+                m_sessionWork.erase(work);
+                work = m_sessionWork.end();
+            }
+            if (work == m_sessionWork.end())
+            {
+                work = m_sessionWork.emplace(sessionId, SessionWork{mediaKey, CancellationToken()}).first;
+            }
+            cancel = work->second.cancel;
+            ++m_sessionTasks;
+        }
+        else if (state == "stopped")
+        {
+            // Forgetting the session also discards updates still being fetched for it
+            m_sessionLatestEvent.erase(sessionId);
+            m_sessionTimers.cancel(sessionId);
+            auto work = m_sessionWork.find(sessionId);
+            if (work != m_sessionWork.end())
+            {
+                cancelSessionWorkLocked(work, std::next(work));
+            }
+
+            // Remove the session if it exists
+            if (m_activeSessions.find(sessionId) != m_activeSessions.end())
+            {
+                LOG_INFO("Plex", "Removing stopped session: " + sessionKey);
+                eraseSessionLocked(sessionId);
+                publishCurrentSessionLocked();
+            }
+        }
+    }
+
+    // Fetch on the session pool so the stream keeps reading events and a newer
+    // event can cancel this fetch while it is still running
+    if (active)
+    {
+        m_sessionPool.post([this, serverId, sessionKey, state, mediaKey, viewOffset, server, eventSeq, token = *cancel]()
+                                       {
+            try
+            {
+                updateSessionInfo(serverId, sessionKey, state, mediaKey, viewOffset, server, eventSeq, token);
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR("Plex", "Error updating session " + sessionKey + ": " + std::string(e.what()));
+            }
+
+            std::lock_guard<std::mutex> lock(m_sessionMutex);
+            if (--m_sessionTasks == 0)
+            {
+                m_sessionTasksCv.notify_all();
+            } });
+    }
+}
+
+void Plex::cancelSessionWorkLocked(std::map<SessionId, SessionWork>::iterator first,
+                                   std::map<SessionId, SessionWork>::iterator last)
+{
+    for (auto it = first; it != last; ++it)
+    {
+        it->second.cancel.cancel();
+    }
+    m_sessionWork.erase(first, last);
+}
+
+void Plex::requestSessionSweep(const std::string &serverId)
+{
+    std::lock_guard<std::mutex> lock(m_reconcileMutex);
+    m_pendingSweeps.insert(serverId);
+    m_reconcileCv.notify_one();
+}
+
+void Plex::touchSession(const SessionId &id)
+{
+    m_sessionTimers.schedule(id, std::chrono::seconds(SESSION_TTL));
+    armSessionExpiry();
+}
+
+void Plex::armSessionExpiry()
+{
+    // One timer covers the whole wheel: when it fires the wheel is advanced
+    // and the timer re-armed while sessions remain, so an expired session is
+    // noticed within two TTLs and nothing wakes up while nothing plays
+    std::lock_guard<std::mutex> lock(m_reconcileMutex);
+    if (m_sessionExpiryTimer != 0 || m_shuttingDown)
+    {
+        return;
+    }
+
+    m_sessionExpiryTimer = TimerService::getInstance().schedule(
+        std::chrono::seconds(SESSION_TTL), [this]()
+        {
+            std::lock_guard<std::mutex> lock(m_reconcileMutex);
+            m_sessionExpiryTimer = 0;
+            m_sessionExpiryDue = true;
+            m_reconcileCv.notify_one(); },
+        std::chrono::seconds(SESSION_TTL / 4));
+}
+
+void Plex::sessionReconcileLoop()
+{
+    LOG_DEBUG("Plex", "Session reconcile thread started");
+
+    while (true)
+    {
+        // Servers to check, with the sessions whose deadline passed on each
+        std::map<std::string, std::set<SessionId>> work;
+        bool reconcileAll;
+        {
+            std::unique_lock<std::mutex> lock(m_reconcileMutex);
+            m_reconcileCv.wait(lock, [this]()
+                               { return m_shuttingDown || m_sessionExpiryDue || m_reconcileAllDue || !m_pendingSweeps.empty(); });
+            if (m_shuttingDown)
+            {
+                break;
+            }
+
+            for (const auto &serverId : m_pendingSweeps)
+            {
+                work[serverId];
+            }
+            m_pendingSweeps.clear();
+            reconcileAll = m_reconcileAllDue;
+            m_reconcileAllDue = false;
+            m_sessionExpiryDue = false;
+        }
+
+        for (const auto &id : m_sessionTimers.advance())
+        {
+            work[id.first].insert(id);
+        }
+        if (reconcileAll)
+        {
+            for (const auto &[serverId, server] : Config::getInstance().getPlexServers())
+            {
+                work[serverId];
+            }
+        }
+
+        for (const auto &[serverId, expired] : work)
+        {
+            if (m_shuttingDown)
+            {
+                break;
+            }
+            reconcileServerSessions(serverId, expired);
+        }
+
+        // Sessions still being tracked need the expiry timer again
+        if (m_sessionTimers.size() > 0)
+        {
+            armSessionExpiry();
+        }
+    }
+
+    LOG_DEBUG("Plex", "Session reconcile thread exiting");
+}
+
+void Plex::reconcileServerSessions(const std::string &serverId, const std::set<SessionId> &expired)
+{
+    auto server = Config::getInstance().getPlexServer(serverId);
+    if (!server)
+    {
+        return;
+    }
+
+    // Differences are fed through the normal notification path, so they are
+    // handled exactly like the events that were missed
+    auto notifyStopped = [&](const std::string &sessionKey)
+    {
+        processPlaySessionStateNotification(serverId, {{"sessionKey", sessionKey}, {"state", "stopped"}});
+    };
+
+    // Only use a URI the stream already settled on; probing here would stall
+    // the other servers behind an unreachable one
+    std::string serverUri = getServerConnection(server)->activeUri();
+    std::string response;
+    HttpClient client(&m_stopSignal);
+    if (serverUri.empty() || !client.get(*requestTemplate(serverUri, server->accessToken), SESSION_ENDPOINT, response))
+    {
+        // Sessions that went quiet on an unreachable server are stale
+        for (const auto &id : expired)
+        {
+            LOG_INFO("Plex", "Session " + id.second + " timed out on unreachable server " + server->name);
+            notifyStopped(id.second);
+        }
+        return;
+    }
+
+    std::map<std::string, nlohmann::json> remote;
+    try
+    {
+        auto json = nlohmann::json::parse(response);
+        if (json.contains("MediaContainer") && json["MediaContainer"].contains("Metadata"))
         {
-            processPlaySessionStateNotification(serverId, json["PlaySessionStateNotification"]);
+            for (const auto &session : json["MediaContainer"]["Metadata"])
+            {
+                remote[session.value("sessionKey", "")] = session;
+            }
         }
     }
     catch (const std::exception &e)
     {
-        LOG_ERROR("Plex", "Error parsing SSE event: " + std::string(e.what()) +
-                              ", Event: " + event.substr(0, 100) + (event.length() > 100 ? "..." : ""));
+        LOG_ERROR("Plex", "Error parsing session data during reconciliation: " + std::string(e.what()));
+        return;
     }
-}
-
-void Plex::processPlaySessionStateNotification(const std::string &serverId, const nlohmann::json &notification)
-{
-    LOG_DEBUG("Plex", "Processing PlaySessionStateNotification: " + notification.dump());
 
-    // Find the server
-    auto server_itr = Config::getInstance().getPlexServers().find(serverId);
-    if (server_itr == Config::getInstance().getPlexServers().end())
+    std::map<std::string, PlaybackState> local;
     {
-        LOG_ERROR("Plex", "Unknown server ID: " + serverId);
-        return;
+        std::lock_guard<std::mutex> lock(m_sessionMutex);
+        for (auto it = m_activeSessions.lower_bound(SessionId(serverId, ""));
+             it != m_activeSessions.end() && it->first.first == serverId; ++it)
+        {
+            local[it->first.second] = it->second.playback.state;
+        }
     }
-    auto server = server_itr->second;
-
-    // Extract essential session information
-    std::string sessionKey = notification.value("sessionKey", "");
-    std::string state = notification.value("state", "");
-    std::string mediaKey = notification.value("key", "");
-    int64_t viewOffset = notification.value("viewOffset", 0);
-
-    LOG_DEBUG("Plex", "Playback state update received: " + state + " sessionKey: " + sessionKey);
-
-    std::lock_guard<std::mutex> lock(m_sessionMutex);
 
-    if (state == "playing" || state == "paused" || state == "buffering")
+    // Local or timed-out sessions the server no longer has
+    std::set<std::string> checked;
+    for (const auto &[sessionKey, state] : local)
     {
-        updateSessionInfo(serverId, sessionKey, state, mediaKey, viewOffset, server);
+        checked.insert(sessionKey);
     }
-    else if (state == "stopped")
+    for (const auto &id : expired)
     {
-        // Remove the session if it exists
-        if (m_activeSessions.find(sessionKey) != m_activeSessions.end())
+        checked.insert(id.second);
+    }
+    for (const auto &sessionKey : checked)
+    {
+        if (remote.find(sessionKey) == remote.end())
+        {
+            LOG_INFO("Plex", "Session " + sessionKey + " is gone from server " + server->name + ", removing it");
+            notifyStopped(sessionKey);
+        }
+    }
+
+    // Sessions of this user that are new or whose state drifted
+    std::string username = Config::getInstance().getPlexUsername();
+    for (const auto &[sessionKey, session] : remote)
+    {
+        std::string state = session.value("Player", nlohmann::json::object()).value("state", "");
+        PlaybackStatus remoteStatus;
+        updatePlaybackState(remoteStatus, state, 0);
+
+        auto known = local.find(sessionKey);
+        if (known != local.end() && known->second == remoteStatus.state)
         {
-            LOG_INFO("Plex", "Removing stopped session: " + sessionKey);
-            m_activeSessions.erase(sessionKey);
+            // Still playing; the server just had nothing new to say
+            touchSession(SessionId(serverId, sessionKey));
+            continue;
+        }
+        if (known == local.end() &&
+            session.value("User", nlohmann::json::object()).value("title", "") != username)
+        {
+            if (expired.count(SessionId(serverId, sessionKey)) > 0)
+            {
+                touchSession(SessionId(serverId, sessionKey));
+            }
+            continue;
         }
+
+        LOG_INFO("Plex", "Resyncing session " + sessionKey + " from server " + server->name);
+        processPlaySessionStateNotification(serverId, {{"sessionKey", sessionKey},
+                                                       {"state", state},
+                                                       {"key", session.value("key", "")},
+                                                       {"viewOffset", session.value("viewOffset", int64_t{0})}});
     }
 }
 
 void Plex::updateSessionInfo(const std::string &serverId, const std::string &sessionKey,
                              const std::string &state, const std::string &mediaKey,
-                             int64_t viewOffset, const std::shared_ptr<PlexServer> &server)
+                             int64_t viewOffset, const std::shared_ptr<PlexServer> &server,
+                             uint64_t eventSeq, const CancellationToken &cancel)
 {
     // Get the preferred URI
     std::string serverUri = getPreferredServerUri(server);
@@ -678,13 +1526,12 @@ void Plex::updateSessionInfo(const std::string &serverId, const std::string &ses
     std::string clientName;
 
     // Fetch session data to get username and client
-    HttpClient client;
-    std::map<std::string, std::string> headers = getStandardHeaders(server->accessToken);
-    std::string url = serverUri + SESSION_ENDPOINT;
+    HttpClient client(&m_stopSignal);
     std::string response;
 
-        if (client.get(url, headers, response))
+        if (client.get(*requestTemplate(serverUri, server->accessToken), SESSION_ENDPOINT, response, &cancel))
         {
+            getServerConnection(server)->reportSuccess();
             try
             {
                 auto json = nlohmann::json::parse(response);
@@ -706,9 +1553,15 @@ void Plex::updateSessionInfo(const std::string &serverId, const std::string &ses
                 LOG_ERROR("Plex", "Error parsing session data: " + std::string(e.what()));
             }
         }
+        else if (cancel.isCancelled())
+        {
+            LOG_DEBUG("Plex", "Session " + sessionKey + " update cancelled");
+            return;
+        }
         else
         {
             LOG_ERROR("Plex", "Failed to fetch session information for user/client check");
+            reportServerFailure(server);
         }
 
     // Skip sessions that don't belong to the current user
@@ -721,87 +1574,109 @@ void Plex::updateSessionInfo(const std::string &serverId, const std::string &ses
     // Create a cache key for media info
     std::string mediaInfoCacheKey = serverUri + mediaKey;
 
-    // Check if we have cached media info that's still valid
+    // Reuse the shared metadata if we have a valid cache entry; concurrent
+    // misses for the same item share a single fetch
     MediaInfo info;
-    bool needMediaFetch = true;
-
+    auto loadMetadata = [&]()
     {
-        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-        auto cacheIt = m_mediaInfoCache.find(mediaInfoCacheKey);
-        if (cacheIt != m_mediaInfoCache.end() && cacheIt->second.valid())
+        if (auto cachedMetadata = m_mediaInfoCache.get(mediaInfoCacheKey))
         {
-            info = cacheIt->second.info;
-            needMediaFetch = false;
             LOG_DEBUG("Plex", "Using cached media info for key: " + mediaKey);
+            return std::move(*cachedMetadata);
         }
-    }
 
-    // Fetch media details if needed
-    if (needMediaFetch)
-    {
-        info = fetchMediaDetails(serverUri, server->accessToken, mediaKey);
+        auto metadata = fetchMediaDetails(serverUri, server->accessToken, mediaKey, cancel);
+
+        // A cancelled fetch may have stopped half way; don't let it linger
+        if (cancel.isCancelled())
+        {
+            return std::shared_ptr<const MediaMetadata>();
+        }
 
         // Cache the result
-        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-        MediaCacheEntry entry;
-        entry.timestamp = std::time(nullptr);
-        entry.info = info;
-        m_mediaInfoCache[mediaInfoCacheKey] = entry;
+        m_mediaInfoCache.put(mediaInfoCacheKey, metadata, std::chrono::seconds(MEDIA_CACHE_TIMEOUT));
+        return metadata;
+    };
+    info.metadata = m_mediaInfoFlights.run(mediaInfoCacheKey, loadMetadata);
+
+    // We may have joined the flight of another session that got cancelled;
+    // fetch again on our own unless we were cancelled ourselves
+    if (!info.metadata && !cancel.isCancelled())
+    {
+        info.metadata = m_mediaInfoFlights.run(mediaInfoCacheKey, loadMetadata);
+    }
+    if (!info.metadata || cancel.isCancelled())
+    {
+        LOG_DEBUG("Plex", "Session " + sessionKey + " update cancelled");
+        return;
+    }
+
+    // Get the server to transcode the artwork before Discord's proxy asks for it
+    if (!info.meta().artPath.empty())
+    {
+        m_artworkResolver.prewarm(info.meta().artPath);
     }
 
     // Update playback state
-    updatePlaybackState(info, state, viewOffset);
+    updatePlaybackState(info.playback, state, viewOffset);
 
-    // Update session key and server ID
+    // Update session key, server ID and client (interned, so no string copies)
     info.sessionKey = sessionKey;
-    info.serverId = serverId;
-    info.mediaKey = mediaKey;
-    info.client = clientName;
+    info.serverId = InternedString(serverId);
+    info.username = InternedString(username);
+    info.client = InternedString(clientName);
 
-    // Store the updated info
-    m_activeSessions[sessionKey] = info;
+    // Store the updated info unless a newer event for the session arrived meanwhile
+    std::lock_guard<std::mutex> lock(m_sessionMutex);
+    SessionId sessionId(serverId, sessionKey);
+    auto latest = m_sessionLatestEvent.find(sessionId);
+    if (latest == m_sessionLatestEvent.end() || latest->second != eventSeq)
+    {
+        LOG_DEBUG("Plex", "Dropping superseded update for session " + sessionKey);
+        return;
+    }
+    storeSessionLocked(sessionId, info);
+    publishCurrentSessionLocked();
 
-    LOG_INFO("Plex", "Updated session " + sessionKey + ": " + info.title +
-                         " (" + std::to_string(info.progress) + "/" + std::to_string(info.duration) + "s)");
+    LOG_INFO("Plex", "Updated session " + sessionKey + ": " + info.meta().title +
+                         " (" + std::to_string(info.playback.progress) + "/" + std::to_string(info.meta().duration) + "s)");
 }
 
-void Plex::updatePlaybackState(MediaInfo &info, const std::string &state, int64_t viewOffset)
+void Plex::updatePlaybackState(PlaybackStatus &status, const std::string &state, int64_t viewOffset)
 {
     if (state == "playing")
     {
-        info.state = PlaybackState::Playing;
+        status.state = PlaybackState::Playing;
     }
     else if (state == "paused")
     {
-        info.state = PlaybackState::Paused;
+        status.state = PlaybackState::Paused;
     }
     else if (state == "buffering")
     {
-        info.state = PlaybackState::Buffering;
+        status.state = PlaybackState::Buffering;
     }
 
-    info.progress = viewOffset / 1000.0; // Convert from milliseconds to seconds
-    info.startTime = std::time(nullptr) - static_cast<time_t>(info.progress);
+    status.progress = viewOffset / 1000.0; // Convert from milliseconds to seconds
+    status.startTime = std::time(nullptr) - static_cast<time_t>(status.progress);
 }
 
-MediaInfo Plex::fetchMediaDetails(const std::string &serverUri, const std::string &accessToken,
-                                  const std::string &mediaKey)
+std::shared_ptr<const MediaMetadata> Plex::fetchMediaDetails(const std::string &serverUri, const std::string &accessToken,
+                                                             const std::string &mediaKey, const CancellationToken &cancel)
 {
     LOG_DEBUG("Plex", "Fetching media details for key: " + mediaKey);
 
-    MediaInfo info;
-    info.state = PlaybackState::Stopped;
-
-    HttpClient client;
-    std::map<std::string, std::string> headers = getStandardHeaders(accessToken);
+    auto result = std::make_shared<MediaMetadata>();
+    MediaMetadata &info = *result;
+    info.mediaKey = mediaKey;
 
-    std::string url = serverUri + mediaKey;
+    HttpClient client(&m_stopSignal);
     std::string response;
 
-    if (!client.get(url, headers, response))
+    if (!client.get(*requestTemplate(serverUri, accessToken), mediaKey, response, &cancel))
     {
         LOG_ERROR("Plex", "Failed to fetch media details");
-        return info;
+        return result;
     }
 
     try
@@ -812,7 +1687,7 @@ MediaInfo Plex::fetchMediaDetails(const std::string &serverUri, const std::strin
             json["MediaContainer"]["Metadata"].empty())
         {
             LOG_ERROR("Plex", "Invalid media details response");
-            return info;
+            return result;
         }
 
         auto metadata = json["MediaContainer"]["Metadata"][0];
@@ -823,7 +1698,7 @@ MediaInfo Plex::fetchMediaDetails(const std::string &serverUri, const std::strin
         if (metadata.contains("Media") && metadata["Media"].is_array() && !metadata["Media"].empty())
         {
             auto media = metadata["Media"][0];
-            info.videoResolution = media.value("videoResolution", "");
+            info.videoResolution = InternedString(media.value("videoResolution", ""));
             info.bitrate = media.value("bitrate", 0);
 
             if (media.contains("Part") && media["Part"].is_array() && !media["Part"].empty())
@@ -849,17 +1724,17 @@ MediaInfo Plex::fetchMediaDetails(const std::string &serverUri, const std::strin
         std::string type = metadata.value("type", "unknown");
         if (type == "movie")
         {
-            extractMovieSpecificInfo(metadata, info, serverUri, accessToken);
+            extractMovieSpecificInfo(metadata, info, serverUri, accessToken, cancel);
         }
         else if (type == "episode")
         {
             extractTVShowSpecificInfo(metadata, info);
             // Fetch grandparent metadata for GUIDs and Genres if needed
-            fetchGrandparentMetadata(serverUri, accessToken, info);
+            fetchGrandparentMetadata(serverUri, accessToken, info, cancel);
         }
         else if (type == "track")
         {
-            extractMusicSpecificInfo(metadata, info, serverUri, accessToken, info.serverId);
+            extractMusicSpecificInfo(metadata, info, serverUri, accessToken, cancel);
         }
         else
         {
@@ -875,10 +1750,10 @@ MediaInfo Plex::fetchMediaDetails(const std::string &serverUri, const std::strin
         LOG_ERROR("Plex", "Error parsing media details: " + std::string(e.what()));
     }
 
-    return info;
+    return result;
 }
 
-void Plex::extractBasicMediaInfo(const nlohmann::json &metadata, MediaInfo &info)
+void Plex::extractBasicMediaInfo(const nlohmann::json &metadata, MediaMetadata &info)
 {
     // Set basic info common to all media types
     info.title = metadata.value("title", "Unknown");
@@ -887,19 +1762,21 @@ void Plex::extractBasicMediaInfo(const nlohmann::json &metadata, MediaInfo &info
     info.summary = metadata.value("summary", "No summary available");
     info.year = metadata.value("year", 0);
     info.thumbPath = metadata.value("thumb", "");
+    info.updatedAt = metadata.value("updatedAt", static_cast<int64_t>(0));
     // Extract potential album/parent title
     info.album = metadata.value("parentTitle", "");       // Often the album for music
     info.artist = metadata.value("grandparentTitle", ""); // Often the artist for music
 }
 
-void Plex::extractMovieSpecificInfo(const nlohmann::json &metadata, MediaInfo &info, const std::string &serverUri, const std::string &accessToken)
+void Plex::extractMovieSpecificInfo(const nlohmann::json &metadata, MediaMetadata &info, const std::string &serverUri, const std::string &accessToken,
+                                    const CancellationToken &cancel)
 {
     info.type = MediaType::Movie;
-    parseGuid(metadata, info, serverUri, accessToken);
-    parseGenres(metadata, info);
+    parseGuid(metadata, info, serverUri, accessToken, cancel);
+    parseGenres(metadata, info, cancel);
 }
 
-void Plex::extractTVShowSpecificInfo(const nlohmann::json &metadata, MediaInfo &info)
+void Plex::extractTVShowSpecificInfo(const nlohmann::json &metadata, MediaMetadata &info)
 {
     info.type = MediaType::TVShow;
     info.grandparentTitle = metadata.value("grandparentTitle", "Unknown");
@@ -913,8 +1790,9 @@ void Plex::extractTVShowSpecificInfo(const nlohmann::json &metadata, MediaInfo &
     }
 }
 
-void Plex::extractMusicSpecificInfo(const nlohmann::json &metadata, MediaInfo &info,
-                                    const std::string &serverUri, const std::string &accessToken, const std::string &serverId)
+void Plex::extractMusicSpecificInfo(const nlohmann::json &metadata, MediaMetadata &info,
+                                    const std::string &serverUri, const std::string &accessToken,
+                                    const CancellationToken &cancel)
 {
     info.type = MediaType::Music;
     info.thumbPath = metadata.value("parentThumb", "");
@@ -953,12 +1831,12 @@ void Plex::extractMusicSpecificInfo(const nlohmann::json &metadata, MediaInfo &i
         }
     }
 
-    parseGuid(metadata, info, serverUri, accessToken);
-    parseGenres(metadata, info);
+    parseGuid(metadata, info, serverUri, accessToken, cancel);
+    parseGenres(metadata, info, cancel);
 }
 
 void Plex::fetchGrandparentMetadata(const std::string &serverUrl, const std::string &accessToken,
-                                    MediaInfo &info)
+                                    MediaMetadata &info, const CancellationToken &cancel)
 {
 
     if (info.grandparentKey.empty())
@@ -970,16 +1848,12 @@ void Plex::fetchGrandparentMetadata(const std::string &serverUrl, const std::str
     LOG_DEBUG("Plex", "Fetching TV show metadata for key: " + info.grandparentKey);
 
     // Create HTTP client
-    HttpClient client;
-
-    // Set up headers
-    std::map<std::string, std::string> headers = getStandardHeaders(accessToken);
+    HttpClient client(&m_stopSignal);
 
     // Make the request
-    std::string url = serverUrl + info.grandparentKey;
     std::string response;
 
-    if (!client.get(url, headers, response))
+    if (!client.get(*requestTemplate(serverUrl, accessToken), info.grandparentKey, response, &cancel))
     {
         LOG_ERROR("Plex", "Failed to fetch TV show metadata");
         return;
@@ -998,10 +1872,10 @@ void Plex::fetchGrandparentMetadata(const std::string &serverUrl, const std::str
 
         auto metadata = json["MediaContainer"]["Metadata"][0];
 
-        parseGuid(metadata, info, serverUrl, accessToken);
+        parseGuid(metadata, info, serverUrl, accessToken, cancel);
 
         // Parse genres
-        parseGenres(metadata, info);
+        parseGenres(metadata, info, cancel);
     }
     catch (const std::exception &e)
     {
@@ -1009,7 +1883,8 @@ void Plex::fetchGrandparentMetadata(const std::string &serverUrl, const std::str
     }
 }
 
-void Plex::parseGuid(const nlohmann::json &metadata, MediaInfo &info, const std::string &serverUri, const std::string &accessToken)
+void Plex::parseGuid(const nlohmann::json &metadata, MediaMetadata &info, const std::string &serverUri, const std::string &accessToken,
+                     const CancellationToken &cancel)
 {
     if (metadata.contains("Guid") && metadata["Guid"].is_array())
     {
@@ -1024,54 +1899,79 @@ void Plex::parseGuid(const nlohmann::json &metadata, MediaInfo &info, const std:
             else if (id.find("tmdb://") == 0)
             {
                 info.tmdbId = id.substr(7);
+                LOG_INFO("Plex", "Found TMDB ID: " + info.tmdbId);
 
-                // Check TMDB artwork cache
-                bool needArtworkFetch = true;
+                // Items with their own thumbnail use the server's transcoder
+                // instead, see buildArtworkUrl()
+                if (!info.thumbPath.empty() && !serverUri.empty() && !accessToken.empty())
                 {
-                    std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-                    auto cacheIt = m_tmdbArtworkCache.find(info.tmdbId);
-                    if (cacheIt != m_tmdbArtworkCache.end() && cacheIt->second.valid())
-                    {
-                        info.artPath = cacheIt->second.artPath;
-                        needArtworkFetch = false;
-                        LOG_DEBUG("Plex", "Using cached TMDB artwork for ID: " + info.tmdbId);
-                    }
+                    continue;
                 }
 
-                if (needArtworkFetch)
+                // Check TMDB artwork cache; misses are cached too
+                Lookup<std::string> artwork;
+                if (auto cachedArtwork = m_tmdbArtworkCache.get(info.tmdbId))
                 {
-                    fetchTMDBArtwork(info.tmdbId, info, serverUri, accessToken);
-
-                    // Cache the result if we found artwork
-                    if (!info.artPath.empty())
+                    artwork = std::move(*cachedArtwork);
+                    LOG_DEBUG("Plex", "Using cached TMDB artwork lookup for ID: " + info.tmdbId);
+                }
+                else
+                {
+                    // The flight is shared by every caller with this TMDB ID,
+                    // so it sees nothing of the caller's metadata but the ID
+                    // and type, and yields only what TMDB returned
+                    auto lookupArtwork = [tmdbId = info.tmdbId, type = info.type, &cancel, this]() -> std::optional<Lookup<std::string>>
+                    {
+                        std::string artPath;
+                        Lookup<std::string> result{fetchTMDBArtwork(tmdbId, type, artPath, cancel), ""};
+                        if (cancel.isCancelled())
+                        {
+                            return std::nullopt;
+                        }
+                        if (result.found())
+                        {
+                            result.value = artPath;
+                        }
+                        m_tmdbArtworkCache.put(tmdbId, result);
+                        return result;
+                    };
+                    auto flight = m_tmdbArtworkFlights.run(info.tmdbId, lookupArtwork);
+
+                    // We may have joined the flight of another session that got
+                    // cancelled; look up again on our own unless we were
+                    // cancelled ourselves
+                    if (!flight && !cancel.isCancelled())
+                    {
+                        flight = m_tmdbArtworkFlights.run(info.tmdbId, lookupArtwork);
+                    }
+                    if (flight)
                     {
-                        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-                        TMDBCacheEntry entry;
-                        entry.timestamp = std::time(nullptr);
-                        entry.artPath = info.artPath;
-                        m_tmdbArtworkCache[info.tmdbId] = entry;
+                        artwork = std::move(*flight);
                     }
                 }
 
-                LOG_INFO("Plex", "Found TMDB ID: " + info.tmdbId);
+                if (artwork.found())
+                {
+                    info.artPath = artwork.value;
+                }
             }
         }
     }
 }
 
-void Plex::parseGenres(const nlohmann::json &metadata, MediaInfo &info)
+void Plex::parseGenres(const nlohmann::json &metadata, MediaMetadata &info, const CancellationToken &cancel)
 {
     if (metadata.contains("Genre") && metadata["Genre"].is_array())
     {
         for (const auto &genre : metadata["Genre"])
         {
-            info.genres.push_back(genre.value("tag", ""));
+            info.genres.emplace_back(genre.value("tag", ""));
         }
     }
 
     if (isAnimeContent(metadata))
     {
-        fetchAnimeMetadata(metadata, info);
+        fetchAnimeMetadata(metadata, info, cancel);
     }
 }
 
@@ -1091,7 +1991,7 @@ bool Plex::isAnimeContent(const nlohmann::json &metadata)
     return false;
 }
 
-void Plex::fetchAnimeMetadata(const nlohmann::json &metadata, MediaInfo &info)
+void Plex::fetchAnimeMetadata(const nlohmann::json &metadata, MediaMetadata &info, const CancellationToken &cancel)
 {
     LOG_INFO("Plex", "Anime detected, searching MyAnimeList via Jikan API");
 
@@ -1099,115 +1999,105 @@ void Plex::fetchAnimeMetadata(const nlohmann::json &metadata, MediaInfo &info)
     std::string cacheKey = metadata.value("title", "Unknown") + "_" +
                            std::to_string(metadata.value("year", 0));
 
-    // Check if we have cached MAL info
-    bool needMALFetch = true;
+    // Check if we have a cached MAL lookup; misses are cached too
+    Lookup<std::string> malLookup;
+    if (auto cachedMalId = m_malIdCache.get(cacheKey))
     {
-        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-        auto cacheIt = m_malIdCache.find(cacheKey);
-        if (cacheIt != m_malIdCache.end() && cacheIt->second.valid())
-        {
-            info.malId = cacheIt->second.malId;
-            needMALFetch = false;
-            LOG_DEBUG("Plex", "Using cached MAL ID for: " + cacheKey);
-        }
+        malLookup = std::move(*cachedMalId);
+        LOG_DEBUG("Plex", "Using cached MAL lookup for: " + cacheKey);
     }
-
-    if (needMALFetch)
+    else
     {
-        HttpClient jikanClient;
-        std::string encodedTitle = cacheKey;
-        std::string::size_type pos = 0;
-
-        encodedTitle = utils::urlEncode(encodedTitle);
+        auto lookupMalId = [&]() -> std::optional<Lookup<std::string>>
+        {
+            Lookup<std::string> result;
+            std::string encodedTitle = utils::urlEncode(cacheKey);
 
-        std::string jikanUrl = std::string(JIKAN_API_URL) + "?q=" + encodedTitle;
+            std::string jikanUrl = std::string(JIKAN_API_URL) + "?q=" + encodedTitle;
 
-        std::string jikanResponse;
-        if (jikanClient.get(jikanUrl, {}, jikanResponse))
-        {
-            try
+            ApiResponse jikanResponse = m_jikanClient.get(jikanUrl, {}, ApiPriority::High, &cancel);
+            if (jikanResponse.success())
             {
-                auto jikanJson = nlohmann::json::parse(jikanResponse);
-                if (jikanJson.contains("data") && !jikanJson["data"].empty())
+                try
                 {
-                    auto firstResult = jikanJson["data"][0];
-                    if (firstResult.contains("mal_id"))
+                    auto jikanJson = nlohmann::json::parse(jikanResponse.body);
+                    result.status = LookupStatus::NotFound;
+                    if (jikanJson.contains("data") && !jikanJson["data"].empty())
                     {
-                        info.malId = std::to_string(firstResult["mal_id"].get<int>());
-                        LOG_INFO("Plex", "Found MyAnimeList ID: " + info.malId);
-
-                        // Cache the result
-                        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-                        MALCacheEntry entry;
-                        entry.timestamp = std::time(nullptr);
-                        entry.malId = info.malId;
-                        m_malIdCache[cacheKey] = entry;
+                        auto firstResult = jikanJson["data"][0];
+                        if (firstResult.contains("mal_id"))
+                        {
+                            result = {LookupStatus::Found, std::to_string(firstResult["mal_id"].get<int>())};
+                            LOG_INFO("Plex", "Found MyAnimeList ID: " + result.value);
+                        }
                     }
                 }
+                catch (const std::exception &e)
+                {
+                    LOG_ERROR("Plex", "Error parsing Jikan API response: " + std::string(e.what()));
+                    result.status = LookupStatus::Transient;
+                }
             }
-            catch (const std::exception &e)
+            else
             {
-                LOG_ERROR("Plex", "Error parsing Jikan API response: " + std::string(e.what()));
+                LOG_ERROR("Plex", "Failed to fetch data from Jikan API (HTTP " + std::to_string(jikanResponse.statusCode) + ")");
+                result.status = jikanResponse.transient() ? LookupStatus::Transient : LookupStatus::NotFound;
             }
+
+            // Cache the result, whether found or not, unless the lookup was abandoned
+            if (cancel.isCancelled())
+            {
+                return std::nullopt;
+            }
+            m_malIdCache.put(cacheKey, result);
+            return result;
+        };
+        auto flight = m_malIdFlights.run(cacheKey, lookupMalId);
+
+        // We may have joined the flight of another session that got cancelled;
+        // look up again on our own unless we were cancelled ourselves
+        if (!flight && !cancel.isCancelled())
+        {
+            flight = m_malIdFlights.run(cacheKey, lookupMalId);
         }
-        else
+        if (flight)
         {
-            LOG_ERROR("Plex", "Failed to fetch data from Jikan API");
+            malLookup = std::move(*flight);
         }
     }
+
+    if (malLookup.found())
+    {
+        info.malId = malLookup.value;
+    }
 }
 
-void Plex::buildArtworkUrl(MediaInfo &info, const std::string &serverUri, const std::string &accessToken)
+void Plex::buildArtworkUrl(MediaMetadata &info, const std::string &serverUri, const std::string &accessToken)
 {
-    if (!info.thumbPath.empty() && !serverUri.empty() && !accessToken.empty())
+    std::string url = m_artworkResolver.resolve(info.thumbPath, info.updatedAt, serverUri, accessToken);
+    if (!url.empty())
     {
-        // Generate cache-busting timestamp to bypass Discord's aggressive caching
-        auto now = std::chrono::system_clock::now();
-        auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
-        
-        // Ensure HTTPS for Discord compatibility
-        std::string baseUri = serverUri;
-        if (baseUri.substr(0, 7) == "http://") {
-            baseUri = "https://" + baseUri.substr(7);
-            LOG_INFO("Plex", "Converting HTTP to HTTPS for Discord compatibility");
-        }
-        
-        // Build URL with Discord-friendly parameters
-        info.artPath = baseUri + "/photo/:/transcode?width=256&height=256&minSize=1&upscale=1&format=webp&url=" 
-                     + utils::urlEncode(info.thumbPath) + "&X-Plex-Token=" + accessToken 
-                     + "&cb=" + std::to_string(timestamp);
-        
-        LOG_INFO("Plex", "Built Discord-compatible artwork URL: " + info.artPath);
+        info.artPath = url;
     }
 }
 
-void Plex::fetchTMDBArtwork(const std::string &tmdbId, MediaInfo &info, const std::string &serverUri, const std::string &plexAccessToken)
+LookupStatus Plex::fetchTMDBArtwork(const std::string &tmdbId, MediaType type, std::string &artPath, const CancellationToken &cancel)
 {
     LOG_DEBUG("Plex", "Fetching TMDB artwork for ID: " + tmdbId);
 
-    if (!info.thumbPath.empty() && !serverUri.empty() && !plexAccessToken.empty())
-    {
-        // Use the improved buildArtworkUrl method for Discord compatibility
-        buildArtworkUrl(info, serverUri, plexAccessToken);
-        LOG_INFO("Plex", "Using Discord-compatible Plex transcoder for artwork: " + info.artPath);
-        return;
-    }
-
     // TMDB API requires an access token - get it from config
     std::string accessToken = Config::getInstance().getTMDBAccessToken();
 
     if (accessToken.empty())
     {
         LOG_INFO("Plex", "No TMDB access token available");
-        return;
+        return LookupStatus::Transient;
     }
 
-    // Create HTTP client
-    HttpClient client;
     std::string url;
 
     // Construct proper endpoint URL based on media type
-    if (info.type == MediaType::Movie)
+    if (type == MediaType::Movie)
     {
         url = "https://api.themoviedb.org/3/movie/" + tmdbId + "/images";
     }
@@ -1222,89 +2112,122 @@ void Plex::fetchTMDBArtwork(const std::string &tmdbId, MediaInfo &info, const st
         {"Content-Type", "application/json;charset=utf-8"}};
 
     // Make the request
-    std::string response;
-    if (!client.get(url, headers, response))
+    ApiResponse response = m_tmdbClient.get(url, headers, ApiPriority::High, &cancel);
+    if (!response.success())
     {
-        LOG_ERROR("Plex", "Failed to fetch TMDB images");
-        return;
+        LOG_ERROR("Plex", "Failed to fetch TMDB images (HTTP " + std::to_string(response.statusCode) + ")");
+        return response.transient() ? LookupStatus::Transient : LookupStatus::NotFound;
     }
 
     try
     {
-        auto json = nlohmann::json::parse(response);
+        auto json = nlohmann::json::parse(response.body);
 
         // First try to get a poster
         if (json.contains("posters") && !json["posters"].empty())
         {
             std::string posterPath = json["posters"][0]["file_path"];
-            info.artPath = std::string(TMDB_IMAGE_BASE_URL) + posterPath;
-            LOG_INFO("Plex", "Found TMDB poster: " + info.artPath);
+            artPath = std::string(TMDB_IMAGE_BASE_URL) + posterPath;
+            LOG_INFO("Plex", "Found TMDB poster: " + artPath);
         }
         // Fallback to backdrops
         else if (json.contains("backdrops") && !json["backdrops"].empty())
         {
             std::string backdropPath = json["backdrops"][0]["file_path"];
-            info.artPath = std::string(TMDB_IMAGE_BASE_URL) + backdropPath;
-            LOG_INFO("Plex", "Found TMDB backdrop: " + info.artPath);
+            artPath = std::string(TMDB_IMAGE_BASE_URL) + backdropPath;
+            LOG_INFO("Plex", "Found TMDB backdrop: " + artPath);
+        }
+        else
+        {
+            LOG_INFO("Plex", "No TMDB artwork for ID: " + tmdbId);
+            return LookupStatus::NotFound;
         }
+        return LookupStatus::Found;
     }
     catch (const std::exception &e)
     {
         LOG_ERROR("Plex", "Error parsing TMDB response: " + std::string(e.what()));
+        return LookupStatus::Transient;
     }
 }
 
-MediaInfo Plex::getCurrentPlayback()
+void Plex::storeSessionLocked(const SessionId &id, const MediaInfo &info)
 {
-    if (!m_initialized)
+    auto it = m_activeSessions.find(id);
+    if (it != m_activeSessions.end())
     {
-        LOG_WARNING("Plex", "Plex not initialized");
-        MediaInfo info;
-        info.state = PlaybackState::NotInitialized;
-        return info;
+        m_sessionsByStart.erase({it->second.playback.startTime, id});
+        it->second = info;
     }
+    else
+    {
+        m_activeSessions.emplace(id, info);
+    }
+    m_sessionsByStart.insert({info.playback.startTime, id});
+}
 
-    std::lock_guard<std::mutex> lock(m_sessionMutex);
-
-    // If no active sessions, return stopped state
-    if (m_activeSessions.empty())
+void Plex::eraseSessionLocked(const SessionId &id)
+{
+    auto it = m_activeSessions.find(id);
+    if (it == m_activeSessions.end())
     {
-        LOG_DEBUG("Plex", "No active sessions");
-        MediaInfo info;
-        info.state = PlaybackState::Stopped;
-        return info;
+        return;
     }
+    m_sessionsByStart.erase({it->second.playback.startTime, id});
+    m_activeSessions.erase(it);
+}
 
-    // Find the oldest playing/paused/buffering session
-    MediaInfo newest;
-    time_t newestTime = (std::numeric_limits<time_t>::min)();
+void Plex::publishCurrentSessionLocked()
+{
+    // Only playing/paused/buffering sessions are stored, so the current
+    // session is simply the one that started most recently
+    std::shared_ptr<const MediaInfo> current;
+    if (!m_sessionsByStart.empty())
+    {
+        current = std::make_shared<const MediaInfo>(m_activeSessions.at(m_sessionsByStart.rbegin()->second));
+    }
+    std::atomic_store(&m_currentSession, std::move(current));
 
-    for (const auto &[key, info] : m_activeSessions)
+    if (m_playbackChangedCallback)
     {
-        if (info.state == PlaybackState::Playing ||
-            info.state == PlaybackState::Paused ||
-            info.state == PlaybackState::Buffering)
-        {
+        m_playbackChangedCallback();
+    }
+}
 
-            if (info.startTime > newestTime)
-            {
-                newest = info;
-                newestTime = info.startTime;
-            }
-        }
+void Plex::setPlaybackChangedCallback(PlaybackChangedCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_sessionMutex);
+    m_playbackChangedCallback = std::move(callback);
+}
+
+MediaInfo Plex::getCurrentPlayback()
+{
+    if (!m_initialized)
+    {
+        LOG_WARNING("Plex", "Plex not initialized");
+        MediaInfo info;
+        info.playback.state = PlaybackState::NotInitialized;
+        return info;
     }
 
-    if (newestTime == (std::numeric_limits<time_t>::min)())
+    auto current = std::atomic_load(&m_currentSession);
+    if (!current)
     {
-        // No playing/paused/buffering sessions
-        LOG_DEBUG("Plex", "No active playing sessions");
+        LOG_DEBUG("Plex", "No active sessions");
         MediaInfo info;
-        info.state = PlaybackState::Stopped;
+        info.playback.state = PlaybackState::Stopped;
         return info;
     }
 
-    LOG_DEBUG("Plex", "Returning playback info for: " + newest.title + " (" + std::to_string(static_cast<int>(newest.state)) + ")");
-    return newest;
+    LOG_DEBUG("Plex", "Returning playback info for: " + current->meta().title + " (" + std::to_string(static_cast<int>(current->playback.state)) + ")");
+    return *current;
+}
+
+bool Plex::waitForSessionWork(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_sessionMutex);
+    return m_sessionTasksCv.wait_for(lock, timeout, [this]()
+                                     { return m_sessionTasks == 0; });
 }
 
 void Plex::stop()
@@ -1313,27 +2236,201 @@ void Plex::stop()
 
     m_shuttingDown = true;
 
+    // Wakes the background loops and PIN polling, and aborts every request
+    // made on behalf of this object
+    m_stopSignal.notify();
+    m_jikanClient.cancelPending();
+    m_tmdbClient.cancelPending();
+
+    // Abandon session fetches and wait for the workers to drop them
+    {
+        std::unique_lock<std::mutex> lock(m_sessionMutex);
+        cancelSessionWorkLocked(m_sessionWork.begin(), m_sessionWork.end());
+        m_sessionTasksCv.wait(lock, [this]()
+                              { return m_sessionTasks == 0; });
+    }
+
+    // Stop the background loops before tearing down the clients they may poke
+    if (m_failbackThread.joinable())
+    {
+        m_failbackThread.join();
+    }
+    if (m_resourceRefreshThread.joinable())
+    {
+        m_resourceRefreshThread.join();
+    }
+    TimerService::getInstance().cancel(m_reconcileTimer);
+    m_reconcileTimer = 0;
+    TimerService::TimerId expiryTimer;
+    {
+        std::lock_guard<std::mutex> lock(m_reconcileMutex);
+        expiryTimer = m_sessionExpiryTimer;
+        m_sessionExpiryTimer = 0;
+        m_reconcileCv.notify_all();
+    }
+    TimerService::getInstance().cancel(expiryTimer);
+    if (m_reconcileThread.joinable())
+    {
+        m_reconcileThread.join();
+    }
+    m_sessionTimers.clear();
+
     // Stop all SSE connections with a very short timeout since we're shutting down
     for (auto &[id, server] : Config::getInstance().getPlexServers())
     {
-        if (server->httpClient)
-        {
-            LOG_INFO("Plex", "Stopping SSE connection for server: " + server->name);
-            server->running = false;
-
-            // Explicitly reset the client to ensure destruction
-            server->httpClient.reset();
-        }
+        stopServerSSEConnection(server);
     }
 
     // Clear any cached data
-    std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+    logCacheStats();
     m_tmdbArtworkCache.clear();
     m_malIdCache.clear();
     m_mediaInfoCache.clear();
-    m_sessionUserCache.clear();
     m_serverUriCache.clear();
+    {
+        std::lock_guard<std::mutex> templateLock(m_templateMutex);
+        m_requestTemplates.clear();
+    }
+    m_artworkResolver.stop();
+    m_artworkResolver.clear();
+
+    {
+        std::lock_guard<std::mutex> connectionLock(m_connectionMutex);
+        m_serverConnections.clear();
+    }
 
     m_initialized = false;
     LOG_INFO("Plex", "All Plex connections stopped");
 }
+
+std::vector<CacheStats> Plex::getCacheStats() const
+{
+    std::vector<CacheStats> stats = {m_mediaInfoCache.stats(), m_tmdbArtworkCache.stats(),
+                                     m_malIdCache.stats(), m_serverUriCache.stats()};
+    for (auto &resolverStats : m_artworkResolver.stats())
+    {
+        stats.push_back(std::move(resolverStats));
+    }
+    return stats;
+}
+
+bool Plex::getCacheKeys(const std::string &cacheName, size_t limit, std::vector<std::string> &keys) const
+{
+    if (cacheName == m_mediaInfoCache.name())
+    {
+        keys = m_mediaInfoCache.keys(limit);
+    }
+    else if (cacheName == m_tmdbArtworkCache.name())
+    {
+        keys = m_tmdbArtworkCache.keys(limit);
+    }
+    else if (cacheName == m_malIdCache.name())
+    {
+        keys = m_malIdCache.keys(limit);
+    }
+    else if (cacheName == m_serverUriCache.name())
+    {
+        keys = m_serverUriCache.keys(limit);
+    }
+    else
+    {
+        return m_artworkResolver.keys(cacheName, limit, keys);
+    }
+    return true;
+}
+
+void Plex::clearCaches()
+{
+    logCacheStats();
+    m_tmdbArtworkCache.clear();
+    m_malIdCache.clear();
+    m_mediaInfoCache.clear();
+    m_serverUriCache.clear();
+    m_artworkResolver.clear();
+    LOG_INFO("Plex", "Caches cleared");
+}
+
+std::vector<MediaInfo> Plex::getActiveSessions()
+{
+    std::lock_guard<std::mutex> lock(m_sessionMutex);
+    std::vector<MediaInfo> sessions;
+    sessions.reserve(m_activeSessions.size());
+    for (const auto &[id, info] : m_activeSessions)
+    {
+        sessions.push_back(info);
+    }
+    return sessions;
+}
+
+std::vector<Plex::ServerStatus> Plex::getServerStatus()
+{
+    std::vector<ServerStatus> result;
+    for (const auto &[id, server] : Config::getInstance().getPlexServers())
+    {
+        ServerStatus status;
+        status.id = id;
+        status.name = server->name;
+        status.owned = server->owned;
+        status.state = server->running ? "connected" : "stopped";
+        {
+            std::lock_guard<std::mutex> lock(m_bringUpMutex);
+            if (m_deferredServers.count(id) > 0)
+            {
+                status.state = "deferred";
+            }
+            else if (m_pendingStreams.count(id) > 0)
+            {
+                status.state = "connecting";
+            }
+        }
+
+        std::shared_ptr<ServerConnection> connection;
+        {
+            std::lock_guard<std::mutex> lock(m_connectionMutex);
+            auto it = m_serverConnections.find(id);
+            if (it != m_serverConnections.end())
+            {
+                connection = it->second;
+            }
+        }
+        if (connection)
+        {
+            status.activeUri = connection->activeUri();
+            status.candidates = connection->candidates();
+            status.failedOver = connection->isFailedOver();
+        }
+        result.push_back(std::move(status));
+    }
+    return result;
+}
+
+bool Plex::resyncSessions()
+{
+    if (!m_initialized || m_shuttingDown)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_reconcileMutex);
+    m_reconcileAllDue = true;
+    m_reconcileCv.notify_one();
+    LOG_INFO("Plex", "Session resync requested");
+    return true;
+}
+
+void Plex::logCacheStats() const
+{
+    for (const auto &stats : getCacheStats())
+    {
+        LOG_INFO_STREAM("Plex", "Cache " << stats.name << ": " << stats.entries << " entries, "
+                                         << stats.bytes << "/" << stats.byteBudget << " bytes, hit ratio "
+                                         << std::fixed << std::setprecision(2) << stats.hitRatio()
+                                         << " (" << stats.hits << " hits, " << stats.misses << " misses, "
+                                         << stats.evictions << " evictions, " << stats.expirations << " expirations)");
+    }
+
+    LOG_INFO_STREAM("Plex", "Collapsed duplicate fetches: "
+                                << m_mediaInfoFlights.name() << " " << m_mediaInfoFlights.collapsed() << ", "
+                                << m_tmdbArtworkFlights.name() << " " << m_tmdbArtworkFlights.collapsed() << ", "
+                                << m_malIdFlights.name() << " " << m_malIdFlights.collapsed());
+}
@@ -0,0 +1,106 @@
+#include "server_connection.h"
+#include "logger.h"
+
+namespace
+{
+    std::vector<std::string> dropEmpty(const std::vector<std::string> &uris)
+    {
+        std::vector<std::string> result;
+        for (const auto &uri : uris)
+        {
+            if (!uri.empty())
+            {
+                result.push_back(uri);
+            }
+        }
+        return result;
+    }
+}
+
+ServerConnection::ServerConnection(const std::vector<std::string> &candidates)
+    : m_candidates(dropEmpty(candidates)),
+      m_activeIndex(0),
+      m_hasActive(false),
+      m_consecutiveErrors(0)
+{
+}
+
+std::string ServerConnection::activeUri() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_hasActive)
+    {
+        return "";
+    }
+    return m_candidates[m_activeIndex];
+}
+
+bool ServerConnection::setActive(const std::string &uri)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_candidates.size(); ++i)
+    {
+        if (m_candidates[i] == uri)
+        {
+            bool changed = !m_hasActive || m_activeIndex != i;
+            m_activeIndex = i;
+            m_hasActive = true;
+            m_consecutiveErrors = 0;
+            return changed;
+        }
+    }
+
+    LOG_WARNING("ServerConnection", "Ignoring unknown candidate URI: " + uri);
+    return false;
+}
+
+bool ServerConnection::reportFailure()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_hasActive || m_candidates.size() < 2)
+    {
+        return false;
+    }
+
+    if (++m_consecutiveErrors < MAX_CONSECUTIVE_ERRORS)
+    {
+        return false;
+    }
+
+    // Rotate to the next candidate; wrapping around lets a connection that has
+    // fallen all the way down the list try the preferred URI again
+    const std::string &failed = m_candidates[m_activeIndex];
+    m_activeIndex = (m_activeIndex + 1) % m_candidates.size();
+    m_consecutiveErrors = 0;
+
+    LOG_WARNING("ServerConnection", "URI " + failed + " failed " + std::to_string(MAX_CONSECUTIVE_ERRORS) +
+                                        " times in a row, failing over to " + m_candidates[m_activeIndex]);
+    return true;
+}
+
+void ServerConnection::reportSuccess()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_consecutiveErrors = 0;
+}
+
+std::vector<std::string> ServerConnection::betterCandidates() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_hasActive)
+    {
+        return {};
+    }
+    return std::vector<std::string>(m_candidates.begin(), m_candidates.begin() + m_activeIndex);
+}
+
+const std::vector<std::string> &ServerConnection::candidates() const
+{
+    return m_candidates;
+}
+
+bool ServerConnection::isFailedOver() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hasActive && m_activeIndex > 0;
+}
@@ -0,0 +1,244 @@
+#include "timer_service.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+namespace
+{
+    // Default slack: 5% of the delay, clamped to this range
+    constexpr auto MIN_DEFAULT_SLACK = std::chrono::milliseconds(1);
+    constexpr auto MAX_DEFAULT_SLACK = std::chrono::seconds(5);
+}
+
+TimerService &TimerService::getInstance()
+{
+    static TimerService instance;
+    return instance;
+}
+
+TimerService::TimerService() : m_started(Clock::now())
+{
+}
+
+TimerService::~TimerService()
+{
+    shutdown();
+}
+
+TimerService::Clock::duration TimerService::defaultSlack(Clock::duration delay)
+{
+    Clock::duration slack = delay / 20;
+    return (std::clamp)(slack, Clock::duration(MIN_DEFAULT_SLACK), Clock::duration(MAX_DEFAULT_SLACK));
+}
+
+TimerService::TimerId TimerService::schedule(Clock::duration delay, Callback callback, Clock::duration slack)
+{
+    return add(delay, Clock::duration::zero(), std::move(callback), slack);
+}
+
+TimerService::TimerId TimerService::scheduleRepeating(Clock::duration interval, Callback callback, Clock::duration slack)
+{
+    return add(interval, (std::max)(interval, Clock::duration(MIN_DEFAULT_SLACK)), std::move(callback), slack);
+}
+
+TimerService::TimerId TimerService::add(Clock::duration delay, Clock::duration interval, Callback callback,
+                                        Clock::duration slack)
+{
+    if (slack < Clock::duration::zero())
+    {
+        slack = defaultSlack(interval > Clock::duration::zero() ? interval : delay);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping)
+    {
+        return 0;
+    }
+
+    // Started on first use, so programs that never schedule a timer pay nothing
+    if (!m_thread.joinable())
+    {
+        m_thread = std::thread(&TimerService::run, this);
+        m_threadId = m_thread.get_id();
+    }
+
+    TimerId id = m_nextId++;
+    insertLocked(id, Timer{Clock::now() + delay, slack, interval, std::move(callback)});
+    return id;
+}
+
+void TimerService::insertLocked(TimerId id, Timer timer)
+{
+    // Only a new earliest latest-time changes how long the thread may sleep
+    auto latest = timer.deadline + timer.slack;
+    if (m_byLatest.empty() || latest < m_byLatest.begin()->first)
+    {
+        m_changed = true;
+        m_cv.notify_one();
+    }
+
+    m_byDeadline.insert({timer.deadline, id});
+    m_byLatest.insert({latest, id});
+    m_timers.emplace(id, std::move(timer));
+}
+
+void TimerService::eraseLocked(std::map<TimerId, Timer>::iterator it)
+{
+    m_byDeadline.erase({it->second.deadline, it->first});
+    m_byLatest.erase({it->second.deadline + it->second.slack, it->first});
+    m_timers.erase(it);
+}
+
+bool TimerService::cancel(TimerId id)
+{
+    if (id == 0)
+    {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    bool scheduled = false;
+    auto it = m_timers.find(id);
+    if (it != m_timers.end())
+    {
+        // Let the thread sleep longer instead of waking up for nothing
+        if (m_byLatest.begin()->second == id)
+        {
+            m_changed = true;
+            m_cv.notify_one();
+        }
+        eraseLocked(it);
+        scheduled = true;
+    }
+    if (m_batch.erase(id) > 0)
+    {
+        scheduled = true;
+    }
+
+    if (std::this_thread::get_id() != m_threadId)
+    {
+        m_callbackDone.wait(lock, [this, id]
+                            { return m_runningId != id; });
+    }
+    return scheduled;
+}
+
+TimerStats TimerService::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TimerStats stats;
+    stats.pending = m_timers.size();
+    stats.fired = m_fired;
+    stats.wakeups = m_wakeups;
+    stats.idleWakeups = m_idleWakeups;
+
+    double uptime = std::chrono::duration<double>(Clock::now() - m_started).count();
+    if (uptime > 0)
+    {
+        stats.wakeupsPerSecond = m_wakeups / uptime;
+        stats.idleWakeupsPerSecond = m_idleWakeups / uptime;
+    }
+    return stats;
+}
+
+void TimerService::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_timers.clear();
+        m_byDeadline.clear();
+        m_byLatest.clear();
+    }
+    m_cv.notify_all();
+
+    if (m_thread.joinable() && std::this_thread::get_id() != m_threadId)
+    {
+        m_thread.join();
+    }
+}
+
+void TimerService::run()
+{
+    LOG_DEBUG("TimerService", "Timer thread started");
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping)
+    {
+        m_changed = false;
+        if (m_byLatest.empty())
+        {
+            m_cv.wait(lock, [this]
+                      { return m_stopping || m_changed; });
+            continue;
+        }
+
+        // Sleep until the first timer runs out of slack; any other timer
+        // whose deadline has passed by then fires in the same wakeup
+        auto wakeAt = m_byLatest.begin()->first;
+        if (m_cv.wait_until(lock, wakeAt, [this]
+                            { return m_stopping || m_changed; }))
+        {
+            continue;
+        }
+
+        ++m_wakeups;
+        auto now = Clock::now();
+        std::vector<std::pair<TimerId, Callback>> due;
+        while (!m_byDeadline.empty() && m_byDeadline.begin()->first <= now)
+        {
+            TimerId id = m_byDeadline.begin()->second;
+            auto it = m_timers.find(id);
+            Timer timer = std::move(it->second);
+            eraseLocked(it);
+
+            due.emplace_back(id, timer.callback);
+            m_batch.insert(id);
+            if (timer.interval > Clock::duration::zero())
+            {
+                // Keep the period, but don't try to catch up on missed runs
+                timer.deadline += timer.interval;
+                if (timer.deadline <= now)
+                {
+                    timer.deadline = now + timer.interval;
+                }
+                insertLocked(id, std::move(timer));
+            }
+        }
+
+        if (due.empty())
+        {
+            ++m_idleWakeups;
+            continue;
+        }
+
+        for (auto &[id, callback] : due)
+        {
+            // Skip timers cancelled by an earlier callback of this batch
+            if (m_stopping || m_batch.erase(id) == 0)
+            {
+                continue;
+            }
+
+            m_runningId = id;
+            ++m_fired;
+            lock.unlock();
+            try
+            {
+                callback();
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR("TimerService", "Timer callback threw: " + std::string(e.what()));
+            }
+            lock.lock();
+            m_runningId = 0;
+            m_callbackDone.notify_all();
+        }
+        m_batch.clear();
+    }
+
+    LOG_DEBUG("TimerService", "Timer thread exiting");
+}
@@ -0,0 +1,328 @@
+#include "traffic_recorder.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <regex>
+#include <sstream>
+#include <utility>
+
+#include <nlohmann/json.hpp>
+
+namespace
+{
+    constexpr int CAPTURE_VERSION = 1;
+
+    struct ScrubRule
+    {
+        std::regex pattern;
+        std::string replacement;
+    };
+
+    const std::vector<ScrubRule> &scrubRules()
+    {
+        static const std::vector<ScrubRule> rules = {
+            // Query parameters, also inside thumb URLs in response bodies and
+            // percent-encoded inside transcoder URLs
+            {std::regex(R"((X-Plex-Token(?:=|%3D))[^&%"'\s<>]+)", std::regex::icase), "$1"},
+            // JSON fields from plex.tv (resources, PINs, user) and servers
+            {std::regex(R"re(("(?:accessToken|authToken|authenticationToken|token)"\s*:\s*")[^"]*)re"), "$1"},
+            // The same fields as XML attributes
+            {std::regex(R"re(\b((?:accessToken|authToken|authenticationToken|token)=")[^"]*)re"), "$1"},
+        };
+        return rules;
+    }
+
+    long long toMicros(std::chrono::microseconds value)
+    {
+        return static_cast<long long>(value.count());
+    }
+}
+
+TrafficRecorder &TrafficRecorder::getInstance()
+{
+    static TrafficRecorder instance;
+    return instance;
+}
+
+TrafficRecorder::~TrafficRecorder()
+{
+    stop();
+}
+
+std::string TrafficRecorder::scrub(const std::string &text)
+{
+    std::string result = text;
+    for (const auto &rule : scrubRules())
+    {
+        result = std::regex_replace(result, rule.pattern, rule.replacement + REDACTED);
+    }
+    return result;
+}
+
+bool TrafficRecorder::start(const std::string &path, const std::string &username,
+                            const std::vector<RecordedServer> &servers)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_file.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!m_file)
+    {
+        LOG_ERROR("TrafficRecorder", "Failed to open capture file: " + path);
+        return false;
+    }
+
+    nlohmann::json header = {{"type", "header"},
+                             {"version", CAPTURE_VERSION},
+                             {"username", username},
+                             {"servers", nlohmann::json::array()}};
+    for (const auto &server : servers)
+    {
+        header["servers"].push_back({{"name", server.name},
+                                     {"clientIdentifier", server.clientIdentifier},
+                                     {"localUri", server.localUri},
+                                     {"publicUri", server.publicUri},
+                                     {"owned", server.owned}});
+    }
+    m_file << header.dump() << '\n';
+
+    m_start = std::chrono::steady_clock::now();
+    m_records = 0;
+    m_recording = true;
+    LOG_INFO("TrafficRecorder", "Capturing traffic to " + path);
+    return true;
+}
+
+void TrafficRecorder::stop()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_recording)
+    {
+        return;
+    }
+    m_recording = false;
+    m_file.close();
+    LOG_INFO_STREAM("TrafficRecorder", "Capture finished with " << m_records << " records");
+}
+
+std::chrono::microseconds TrafficRecorder::now() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start);
+}
+
+void TrafficRecorder::recordExchange(const std::string &method, const std::string &url,
+                                     std::chrono::microseconds start, long status, const std::string &body)
+{
+    if (!isRecording())
+    {
+        return;
+    }
+
+    nlohmann::json record = {{"type", "http"},
+                             {"t", toMicros(start)},
+                             {"d", toMicros(now() - start)},
+                             {"method", method},
+                             {"url", scrub(url)},
+                             {"status", status},
+                             {"body", scrub(body)}};
+    writeLine(record.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace));
+}
+
+void TrafficRecorder::recordEvent(const std::string &url, const std::string &data)
+{
+    if (!isRecording())
+    {
+        return;
+    }
+
+    nlohmann::json record = {{"type", "sse"}, {"t", toMicros(now())}, {"url", scrub(url)}, {"data", scrub(data)}};
+    writeLine(record.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace));
+}
+
+void TrafficRecorder::writeLine(const std::string &line)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_recording)
+    {
+        return;
+    }
+    m_file << line << '\n';
+    ++m_records;
+}
+
+TrafficReplay &TrafficReplay::getInstance()
+{
+    static TrafficReplay instance;
+    return instance;
+}
+
+bool TrafficReplay::load(const std::string &path, double speed)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        LOG_ERROR("TrafficReplay", "Failed to open capture file: " + path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::pair<std::string, RecordedExchange>> exchanges;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+        if (line.empty())
+        {
+            continue;
+        }
+
+        try
+        {
+            auto record = nlohmann::json::parse(line);
+            std::string type = record.value("type", "");
+            if (type == "header")
+            {
+                m_username = record.value("username", "");
+                for (const auto &server : record.value("servers", nlohmann::json::array()))
+                {
+                    m_servers.push_back({server.value("name", ""), server.value("clientIdentifier", ""),
+                                         server.value("localUri", ""), server.value("publicUri", ""),
+                                         server.value("owned", false)});
+                }
+            }
+            else if (type == "http")
+            {
+                RecordedExchange exchange;
+                exchange.start = std::chrono::microseconds(record.value("t", 0LL));
+                exchange.duration = std::chrono::microseconds(record.value("d", 0LL));
+                exchange.status = record.value("status", 0L);
+                exchange.body = record.value("body", "");
+                exchanges.emplace_back(record.value("method", "") + " " + record.value("url", ""), std::move(exchange));
+            }
+            else if (type == "sse")
+            {
+                m_events[record.value("url", "")].push_back(
+                    {std::chrono::microseconds(record.value("t", 0LL)), record.value("data", "")});
+                m_lastEvent = (std::max)(m_lastEvent, std::chrono::microseconds(record.value("t", 0LL)));
+                ++m_totalEvents;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            LOG_WARNING_STREAM("TrafficReplay", "Skipping malformed capture line " << lineNumber << ": " << e.what());
+        }
+    }
+
+    // Records are written when they complete; hand them out in the order
+    // the requests were made and the events arrived
+    std::stable_sort(exchanges.begin(), exchanges.end(), [](const auto &a, const auto &b)
+                     { return a.second.start < b.second.start; });
+    for (auto &[key, exchange] : exchanges)
+    {
+        m_exchanges[key].push_back(std::move(exchange));
+    }
+    for (auto &[url, events] : m_events)
+    {
+        std::stable_sort(events.begin(), events.end(), [](const auto &a, const auto &b)
+                         { return a.time < b.time; });
+    }
+
+    m_speed = speed;
+    m_start = std::chrono::steady_clock::now();
+    m_active = true;
+    std::ostringstream pace;
+    if (speed > 0)
+    {
+        pace << speed << "x";
+    }
+    else
+    {
+        pace << "maximum";
+    }
+    LOG_INFO_STREAM("TrafficReplay", "Replaying " << exchanges.size() << " exchanges and " << m_totalEvents
+                                                  << " events from " << path << " at " << pace.str() << " speed");
+    return true;
+}
+
+bool TrafficReplay::takeExchange(const std::string &method, const std::string &url, RecordedExchange &exchange)
+{
+    std::string key = method + " " + TrafficRecorder::scrub(url);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_exchanges.find(key);
+    if (it == m_exchanges.end() || it->second.empty())
+    {
+        ++m_unmatched;
+        LOG_DEBUG("TrafficReplay", "No captured exchange for " + key);
+        return false;
+    }
+
+    exchange = it->second.front();
+    if (it->second.size() > 1)
+    {
+        it->second.pop_front();
+    }
+    return true;
+}
+
+bool TrafficReplay::takeEvents(const std::string &url, std::vector<RecordedEvent> &events)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_events.find(TrafficRecorder::scrub(url));
+    if (it == m_events.end())
+    {
+        return false;
+    }
+    events = std::exchange(it->second, {});
+    return true;
+}
+
+std::chrono::microseconds TrafficReplay::delayUntil(std::chrono::microseconds captured) const
+{
+    if (m_speed <= 0)
+    {
+        return std::chrono::microseconds(0);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start);
+    return (std::max)(scaled(captured) - elapsed, std::chrono::microseconds(0));
+}
+
+std::chrono::microseconds TrafficReplay::scaled(std::chrono::microseconds captured) const
+{
+    if (m_speed <= 0)
+    {
+        return std::chrono::microseconds(0);
+    }
+    return std::chrono::microseconds(static_cast<int64_t>(captured.count() / m_speed));
+}
+
+void TrafficReplay::eventDelivered(std::chrono::microseconds handlingTime)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_handling.add(handlingTime);
+    ++m_delivered;
+    m_eventsCv.notify_all();
+}
+
+bool TrafficReplay::waitForEvents(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_eventsCv.wait_for(lock, timeout, [this]()
+                               { return m_delivered >= m_totalEvents; });
+}
+
+size_t TrafficReplay::deliveredEvents() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_delivered;
+}
+
+size_t TrafficReplay::unmatchedRequests() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_unmatched;
+}
+
+std::chrono::microseconds TrafficReplay::handlingPercentile(double quantile) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_handling.percentile(quantile);
+}
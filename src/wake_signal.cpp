@@ -0,0 +1,99 @@
+#include "wake_signal.h"
+#include "logger.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+WakeSignal::WakeSignal()
+{
+#ifndef _WIN32
+    if (pipe(m_pipe) != 0)
+    {
+        LOG_ERROR("WakeSignal", "Failed to create wake pipe");
+        m_pipe[0] = m_pipe[1] = -1;
+        return;
+    }
+    for (int fd : m_pipe)
+    {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+}
+
+WakeSignal::~WakeSignal()
+{
+#ifndef _WIN32
+    for (int fd : m_pipe)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+#endif
+}
+
+void WakeSignal::notify()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_set.exchange(true))
+    {
+#ifndef _WIN32
+        // One byte keeps the read end readable until reset() drains it
+        if (m_pipe[1] >= 0)
+        {
+            char byte = 1;
+            ssize_t ignored = write(m_pipe[1], &byte, 1);
+            (void)ignored;
+        }
+#endif
+    }
+
+    m_cv.notify_all();
+    for (auto &[id, listener] : m_listeners)
+    {
+        listener();
+    }
+}
+
+void WakeSignal::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_set.exchange(false))
+    {
+#ifndef _WIN32
+        char buffer[16];
+        while (m_pipe[0] >= 0 && read(m_pipe[0], buffer, sizeof(buffer)) > 0)
+        {
+        }
+#endif
+    }
+}
+
+bool WakeSignal::waitFor(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_cv.wait_for(lock, timeout, [this]
+                         { return m_set.load(); });
+}
+
+size_t WakeSignal::addListener(Listener listener)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t id = m_nextListenerId++;
+    if (m_set)
+    {
+        listener();
+    }
+    m_listeners.emplace(id, std::move(listener));
+    return id;
+}
+
+void WakeSignal::removeListener(size_t id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_listeners.erase(id);
+}
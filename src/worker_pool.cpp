@@ -0,0 +1,198 @@
+#include "worker_pool.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <exception>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace
+{
+    // A handful of threads is plenty for cleanup, update checks and timeouts
+    constexpr size_t MIN_WORKERS = 2;
+    constexpr size_t MAX_WORKERS = 4;
+
+    // The pool and index of the worker running on this thread; null and -1
+    // elsewhere
+    thread_local const WorkerPool *t_pool = nullptr;
+    thread_local int t_workerIndex = -1;
+
+    void setCurrentThreadName(const std::string &name)
+    {
+#if defined(_WIN32)
+        std::wstring wideName(name.begin(), name.end());
+        SetThreadDescription(GetCurrentThread(), wideName.c_str());
+#elif defined(__APPLE__)
+        pthread_setname_np(name.c_str());
+#else
+        // Linux limits thread names to 15 characters
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#endif
+    }
+}
+
+WorkerPool &WorkerPool::getInstance()
+{
+    static WorkerPool instance("worker", (std::clamp)(static_cast<size_t>(std::thread::hardware_concurrency()),
+                                                      MIN_WORKERS, MAX_WORKERS));
+    return instance;
+}
+
+WorkerPool::WorkerPool(const std::string &name, size_t threads)
+{
+    size_t count = (std::max)(threads, static_cast<size_t>(1));
+    for (size_t i = 0; i < count; ++i)
+    {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        m_workers[i]->thread = std::thread(&WorkerPool::workerLoop, this, i, name + "-" + std::to_string(i));
+    }
+    LOG_DEBUG("WorkerPool", "Started " + std::to_string(count) + " " + name + " threads");
+}
+
+WorkerPool::~WorkerPool()
+{
+    shutdown();
+}
+
+void WorkerPool::post(Task task)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        if (m_stopping)
+        {
+            // Nobody would ever run it; better late than never
+            lock.unlock();
+            task();
+            return;
+        }
+    }
+
+    // Workers keep their own tasks local; everyone else spreads them out
+    size_t index = t_pool == this ? static_cast<size_t>(t_workerIndex)
+                                  : m_nextWorker.fetch_add(1) % m_workers.size();
+
+    // Counted before it becomes visible so a worker never takes it while the
+    // count still says the queues are empty
+    size_t queued = ++m_queued;
+    size_t maxQueued = m_maxQueued.load();
+    while (queued > maxQueued && !m_maxQueued.compare_exchange_weak(maxQueued, queued))
+    {
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->tasks.push_back(std::move(task));
+    }
+
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_sleepCv.notify_one();
+}
+
+bool WorkerPool::isWorkerThread() const
+{
+    return t_pool == this;
+}
+
+bool WorkerPool::popLocal(size_t index, Task &task)
+{
+    auto &worker = *m_workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty())
+    {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool WorkerPool::steal(size_t index, Task &task)
+{
+    for (size_t offset = 1; offset < m_workers.size(); ++offset)
+    {
+        auto &victim = *m_workers[(index + offset) % m_workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            ++m_stolen;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::workerLoop(size_t index, const std::string &threadName)
+{
+    t_pool = this;
+    t_workerIndex = static_cast<int>(index);
+    setCurrentThreadName(threadName);
+
+    while (true)
+    {
+        Task task;
+        if (popLocal(index, task) || steal(index, task))
+        {
+            --m_queued;
+            ++m_executed;
+            try
+            {
+                task();
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR("WorkerPool", "Task threw: " + std::string(e.what()));
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepCv.wait(lock, [this]()
+                       { return m_stopping || m_queued.load() > 0; });
+        if (m_stopping && m_queued.load() == 0)
+        {
+            break;
+        }
+    }
+}
+
+WorkerPoolStats WorkerPool::stats() const
+{
+    WorkerPoolStats stats;
+    stats.threads = m_workers.size();
+    stats.queued = m_queued.load();
+    stats.maxQueued = m_maxQueued.load();
+    stats.executed = m_executed.load();
+    stats.stolen = m_stolen.load();
+    return stats;
+}
+
+void WorkerPool::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        if (m_stopping)
+        {
+            return;
+        }
+        m_stopping = true;
+    }
+    m_sleepCv.notify_all();
+
+    for (auto &worker : m_workers)
+    {
+        if (worker->thread.joinable() && worker->thread.get_id() != std::this_thread::get_id())
+        {
+            worker->thread.join();
+        }
+    }
+}
@@ -0,0 +1,190 @@
+// Asserts that shutdown is bounded: HttpClient, Plex and Discord must stop
+// within tens of milliseconds even while every one of their transfers and
+// reads is stuck on a peer that never answers.
+
+#include "config.h"
+#include "discord.h"
+#include "http_client.h"
+#include "logger.h"
+#include "plex.h"
+#include "wake_signal.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // The bound under test; generous against scheduler noise, far below the
+    // seconds-long waits shutdown used to take
+    constexpr auto STOP_BOUND = std::chrono::milliseconds(100);
+
+    // How long everything runs before being stopped, so transfers are in flight
+    constexpr auto SETTLE_TIME = std::chrono::milliseconds(300);
+
+    int failures = 0;
+
+    void expectStopsQuickly(const std::string &what, const std::function<void()> &stop)
+    {
+        auto start = std::chrono::steady_clock::now();
+        stop();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        bool ok = elapsed <= STOP_BOUND;
+        std::cout << (ok ? "PASS " : "FAIL ") << what << " stopped in " << elapsed.count() << " ms (bound "
+                  << STOP_BOUND.count() << " ms)" << std::endl;
+        if (!ok)
+        {
+            ++failures;
+        }
+    }
+
+#ifndef _WIN32
+    // Listens without ever accepting: connections complete in the backlog
+    // and then hear nothing back
+    class SilentTcpListener
+    {
+    public:
+        SilentTcpListener()
+        {
+            m_fd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t length = sizeof(address);
+            bind(m_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+            listen(m_fd, 64);
+            getsockname(m_fd, reinterpret_cast<sockaddr *>(&address), &length);
+            m_port = ntohs(address.sin_port);
+        }
+        ~SilentTcpListener() { close(m_fd); }
+
+        std::string uri() const { return "http://127.0.0.1:" + std::to_string(m_port); }
+
+    private:
+        int m_fd = -1;
+        int m_port = 0;
+    };
+
+    class SilentUnixListener
+    {
+    public:
+        explicit SilentUnixListener(const std::filesystem::path &path) : m_path(path)
+        {
+            m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::string native = path.string();
+            native.copy(address.sun_path, sizeof(address.sun_path) - 1);
+            bind(m_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+            listen(m_fd, 16);
+        }
+        ~SilentUnixListener()
+        {
+            close(m_fd);
+            std::filesystem::remove(m_path);
+        }
+
+    private:
+        std::filesystem::path m_path;
+        int m_fd = -1;
+    };
+#endif
+
+    void writeConfig(const std::filesystem::path &configDir, const std::string &serverUri)
+    {
+        std::filesystem::create_directories(configDir);
+        std::ofstream config(configDir / "config.yaml");
+        config << "log_level: 2\n"
+                  "plex:\n"
+                  "  auth_token: shutdown-test-token\n"
+                  "  client_identifier: shutdown-test\n"
+                  "  username: tester\n"
+                  "plex_servers:\n"
+                  "  - name: Silent\n"
+                  "    client_identifier: silent\n"
+                  "    local_uri: "
+               << serverUri << "\n"
+                               "    public_uri: \"\"\n"
+                               "    access_token: server-token\n"
+                               "    owned: true\n";
+    }
+}
+
+int main()
+{
+#ifdef _WIN32
+    std::cout << "SKIP shutdown test needs Unix sockets" << std::endl;
+    return 0;
+#else
+    auto root = std::filesystem::temp_directory_path() / ("presence-shutdown-test-" + std::to_string(getpid()));
+    std::filesystem::create_directories(root);
+
+    SilentTcpListener plexServer;
+    SilentUnixListener discordClient(root / "discord-ipc-0");
+
+    // Both must be in place before Config is first used
+    setenv("XDG_CONFIG_DIR", root.c_str(), 1);
+    setenv("XDG_RUNTIME_DIR", root.c_str(), 1);
+    writeConfig(root / "presence-for-plex", plexServer.uri());
+    Logger::getInstance().setLogLevel(LogLevel::Warning);
+
+    // A request and a stream, both waiting on a server that never answers
+    {
+        WakeSignal abort;
+        HttpClient requestClient(&abort);
+        HttpClient streamClient;
+        std::thread request([&]()
+                            {
+            std::string response;
+            requestClient.get(plexServer.uri() + "/identity", {}, response); });
+        streamClient.startSSE(plexServer.uri() + "/:/eventsource/notifications", {}, [](const std::string &) {});
+        std::this_thread::sleep_for(SETTLE_TIME);
+
+        expectStopsQuickly("HttpClient request", [&]()
+                           {
+            abort.notify();
+            request.join(); });
+        expectStopsQuickly("HttpClient stream", [&]()
+                           { streamClient.stopSSE(); });
+    }
+
+    // Plex with its stream, background loops and plex.tv refresh running
+    {
+        Plex plex;
+        if (!plex.init())
+        {
+            std::cout << "FAIL Plex did not initialize" << std::endl;
+            ++failures;
+        }
+        std::this_thread::sleep_for(SETTLE_TIME);
+        expectStopsQuickly("Plex", [&]()
+                           { plex.stop(); });
+    }
+
+    // Discord waiting for the answer to its handshake
+    {
+        Discord discord;
+        discord.start();
+        std::this_thread::sleep_for(SETTLE_TIME);
+        expectStopsQuickly("Discord", [&]()
+                           { discord.stop(); });
+    }
+
+    std::error_code ignored;
+    std::filesystem::remove_all(root, ignored);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+#endif
+}